@@ -0,0 +1,410 @@
+/*
+ * history.c
+ * Power-of-two ring buffers in PSRAM, one per telemetry channel,
+ * plus a min/max/mean pyramid per channel
+ *
+ * `heads[ch]` counts every record ever appended to a channel. The
+ * writer fills the slot first and then publishes the new head, so a
+ * reader that loads the head sees only finished records. The pyramid
+ * levels work the same way.
+ *
+ * Pyramid buckets are counted in samples, not time: level-1 entry j
+ * summarises raw records [10j, 10j+10), level-2 entry j summarises
+ * level-1 entries [10j, 10j+10). That makes "which raw records does
+ * this entry cover" plain arithmetic.
+ */
+
+#include "history.h"
+#include "telemetry_channels.h"
+
+#include <stdatomic.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "HISTORY";
+
+/* Raw samples summarised by one entry of each level */
+static const unsigned level_span[HISTORY_LEVELS] = { 1, 10, 100 };
+
+/* ============================================================
+ * RAW LEVEL
+ * ============================================================ */
+static history_record_t *rings = NULL;     /* TELEMETRY_CHANNEL_COUNT rings, back to back */
+static size_t ring_size = 0;                /* Records per channel (power of two) */
+static size_t ring_mask = 0;
+static atomic_uint heads[TELEMETRY_CHANNEL_COUNT];
+
+/* ============================================================
+ * PYRAMID LEVELS (index 0 = 10x, 1 = 100x)
+ * ============================================================ */
+typedef struct {
+    uint32_t t_ms;          /* Time of the first sample covered */
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+} level_entry_t;
+
+typedef struct {
+    level_entry_t *ring;    /* TELEMETRY_CHANNEL_COUNT rings, back to back */
+    size_t size;            /* Entries per channel (power of two) */
+    size_t mask;
+    size_t guard;
+    atomic_uint heads[TELEMETRY_CHANNEL_COUNT];
+} level_t;
+
+/* Bucket being filled, one per channel per level (writer only) */
+typedef struct {
+    uint32_t t_ms;
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint32_t count;
+} partial_t;
+
+static level_t levels[HISTORY_LEVELS - 1];
+static partial_t partials[HISTORY_LEVELS - 1][TELEMETRY_CHANNEL_COUNT];
+
+/* ============================================================
+ * SETUP
+ * ============================================================ */
+esp_err_t history_init(size_t budget_bytes)
+{
+    /* Each raw record also pays for 1/8 of a level-1 entry and 1/64 of
+     * a level-2 entry (the level rings are size/8 and size/64) */
+    size_t bytes_per_record = sizeof(history_record_t) +
+                              sizeof(level_entry_t) / 8 + sizeof(level_entry_t) / 64;
+    size_t per_channel = budget_bytes / TELEMETRY_CHANNEL_COUNT / bytes_per_record;
+
+    /* Round down to a power of two so wrapping is a mask, not a divide */
+    size_t size = 1;
+    while (size * 2 <= per_channel) {
+        size *= 2;
+    }
+    if (size <= HISTORY_GUARD_RECORDS || (size >> (3 * (HISTORY_LEVELS - 1))) < 4) {
+        ESP_LOGE(TAG, "Budget of %u bytes is too small", (unsigned)budget_bytes);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t bytes = size * TELEMETRY_CHANNEL_COUNT * sizeof(history_record_t);
+    rings = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (rings == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes of PSRAM", (unsigned)bytes);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ring_size = size;
+    ring_mask = size - 1;
+    for (int ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+        atomic_store(&heads[ch], 0);
+    }
+
+    /* Pyramid: each level keeps 1/8 as many entries as the one below,
+     * which (with 10 samples per entry) reaches further back in time */
+    size_t total = bytes;
+    for (int l = 0; l < HISTORY_LEVELS - 1; l++) {
+        level_t *lv = &levels[l];
+        lv->size = size >> (3 * (l + 1));
+        lv->mask = lv->size - 1;
+        lv->guard = HISTORY_GUARD_RECORDS >> (3 * (l + 1));
+        if (lv->guard < 2) {
+            lv->guard = 2;
+        }
+
+        size_t level_bytes = lv->size * TELEMETRY_CHANNEL_COUNT * sizeof(level_entry_t);
+        lv->ring = heap_caps_malloc(level_bytes, MALLOC_CAP_SPIRAM);
+        if (lv->ring == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate %u bytes of PSRAM", (unsigned)level_bytes);
+            return ESP_ERR_NO_MEM;
+        }
+        for (int ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+            atomic_store(&lv->heads[ch], 0);
+        }
+        total += level_bytes;
+    }
+    memset(partials, 0, sizeof(partials));
+
+    ESP_LOGI(TAG, "%u records per channel x %d channels + pyramid (%u KB PSRAM)",
+             (unsigned)size, TELEMETRY_CHANNEL_COUNT, (unsigned)(total / 1024));
+    return ESP_OK;
+}
+
+size_t history_capacity(void)
+{
+    return ring_size;
+}
+
+/* ============================================================
+ * WRITER
+ * ============================================================ */
+
+/* Add one entry from the level below into `level`'s partial bucket;
+ * every HISTORY_LEVEL_FACTOR entries it is published and folded into
+ * the next level up */
+static void fold(int level, uint16_t channel, uint32_t t_ms, int32_t min, int32_t max,
+                 int32_t mean)
+{
+    partial_t *p = &partials[level][channel];
+
+    if (p->count == 0) {
+        p->t_ms = t_ms;
+        p->min = min;
+        p->max = max;
+        p->sum = 0;
+    } else {
+        if (min < p->min) {
+            p->min = min;
+        }
+        if (max > p->max) {
+            p->max = max;
+        }
+    }
+    p->sum += mean;
+    if (++p->count < HISTORY_LEVEL_FACTOR) {
+        return;
+    }
+
+    /* Bucket full - publish it. All inputs cover the same number of
+     * samples, so the mean of means is the mean; rounding it to the
+     * nearest integer keeps level 1 within 1/2 and level 2 within 1
+     * of the exact value. */
+    level_t *lv = &levels[level];
+    unsigned head = atomic_load_explicit(&lv->heads[channel], memory_order_relaxed);
+    level_entry_t *e = &lv->ring[channel * lv->size + (head & lv->mask)];
+    e->t_ms = p->t_ms;
+    e->min = p->min;
+    e->max = p->max;
+    e->mean = (int32_t)((p->sum + (p->sum < 0 ? -HISTORY_LEVEL_FACTOR / 2 : HISTORY_LEVEL_FACTOR / 2)) /
+                        HISTORY_LEVEL_FACTOR);
+    atomic_store_explicit(&lv->heads[channel], head + 1, memory_order_release);
+    p->count = 0;
+
+    if (level + 1 < HISTORY_LEVELS - 1) {
+        fold(level + 1, channel, e->t_ms, e->min, e->max, e->mean);
+    }
+}
+
+void history_append(uint16_t channel, int32_t value, int64_t now_us)
+{
+    if (rings == NULL || channel >= TELEMETRY_CHANNEL_COUNT) {
+        return;
+    }
+
+    uint32_t t_ms = (uint32_t)(now_us / 1000);
+    unsigned head = atomic_load_explicit(&heads[channel], memory_order_relaxed);
+    history_record_t *rec = &rings[channel * ring_size + (head & ring_mask)];
+    rec->t_ms = t_ms;
+    rec->value = value;
+    atomic_store_explicit(&heads[channel], head + 1, memory_order_release);
+
+    fold(0, channel, t_ms, value, value, value);
+}
+
+/* ============================================================
+ * READERS
+ * ============================================================ */
+
+/* Readable range of a channel as absolute record numbers [*oldest, *end) */
+static void readable_range(uint16_t channel, unsigned *oldest, unsigned *end)
+{
+    unsigned head = atomic_load_explicit(&heads[channel], memory_order_acquire);
+    unsigned keep = ring_size - HISTORY_GUARD_RECORDS;
+    *end = head;
+    *oldest = head > keep ? head - keep : 0;
+}
+
+static inline const history_record_t *record_at(uint16_t channel, unsigned n)
+{
+    return &rings[channel * ring_size + (n & ring_mask)];
+}
+
+/* First record number in [lo, hi) whose time is >= t_ms (wrap-safe
+ * compare, records are in time order) */
+static unsigned lower_bound(uint16_t channel, unsigned lo, unsigned hi, uint32_t t_ms)
+{
+    while (lo < hi) {
+        unsigned mid = lo + (hi - lo) / 2;
+        if ((int32_t)(record_at(channel, mid)->t_ms - t_ms) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool history_window(uint16_t channel, uint32_t from_ms, uint32_t to_ms, history_span_t *span)
+{
+    span->first = span->second = NULL;
+    span->first_count = span->second_count = 0;
+
+    if (rings == NULL || channel >= TELEMETRY_CHANNEL_COUNT) {
+        return false;
+    }
+
+    unsigned oldest, end;
+    readable_range(channel, &oldest, &end);
+
+    unsigned start = lower_bound(channel, oldest, end, from_ms);
+    unsigned stop = lower_bound(channel, start, end, to_ms + 1);
+    if (start == stop) {
+        return false;
+    }
+
+    /* Split at the physical end of the ring */
+    const history_record_t *base = &rings[channel * ring_size];
+    size_t start_idx = start & ring_mask;
+    size_t count = stop - start;
+    size_t until_wrap = ring_size - start_idx;
+
+    span->first = base + start_idx;
+    if (count <= until_wrap) {
+        span->first_count = count;
+    } else {
+        span->first_count = until_wrap;
+        span->second = base;
+        span->second_count = count - until_wrap;
+    }
+    return true;
+}
+
+size_t history_query_decimated(uint16_t channel, uint32_t from_ms, uint32_t to_ms,
+                               history_record_t *out, size_t max_points)
+{
+    history_span_t span;
+    if (max_points == 0 || !history_window(channel, from_ms, to_ms, &span)) {
+        return 0;
+    }
+
+    size_t count = history_span_count(&span);
+    if (count <= max_points) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = *history_span_at(&span, i);
+        }
+        return count;
+    }
+
+    /* Evenly spaced picks, always including the newest record */
+    for (size_t i = 0; i < max_points; i++) {
+        size_t idx = (max_points == 1) ? count - 1 : i * (count - 1) / (max_points - 1);
+        out[i] = *history_span_at(&span, idx);
+    }
+    return max_points;
+}
+
+/* ============================================================
+ * PYRAMID QUERY
+ * ============================================================ */
+
+/* Merge `count` samples starting at t_ms into the right output bucket */
+static void add_to_bucket(history_bucket_t *out, size_t width, uint32_t from_ms, uint32_t span_ms,
+                          uint32_t t_ms, int32_t min, int32_t max, int64_t sum, uint32_t count)
+{
+    int32_t offset = (int32_t)(t_ms - from_ms);
+    size_t px = offset <= 0 ? 0 : (size_t)((uint64_t)offset * width / span_ms);
+    if (px >= width) {
+        px = width - 1;
+    }
+
+    history_bucket_t *b = &out[px];
+    if (b->count == 0) {
+        b->min = min;
+        b->max = max;
+    } else {
+        if (min < b->min) {
+            b->min = min;
+        }
+        if (max > b->max) {
+            b->max = max;
+        }
+    }
+    b->sum += sum;
+    b->count += count;
+}
+
+static void add_raw(history_bucket_t *out, size_t width, uint32_t from_ms, uint32_t span_ms,
+                    const history_record_t *rec)
+{
+    add_to_bucket(out, width, from_ms, span_ms, rec->t_ms, rec->value, rec->value, rec->value, 1);
+}
+
+size_t history_query_buckets(uint16_t channel, uint32_t from_ms, uint32_t to_ms,
+                             history_bucket_t *out, size_t width)
+{
+    if (width == 0) {
+        return 0;
+    }
+    memset(out, 0, width * sizeof(*out));
+    if (rings == NULL || channel >= TELEMETRY_CHANNEL_COUNT) {
+        return 0;
+    }
+
+    unsigned oldest, end;
+    readable_range(channel, &oldest, &end);
+    unsigned start = lower_bound(channel, oldest, end, from_ms);
+    unsigned stop = lower_bound(channel, start, end, to_ms + 1);
+    if (start == stop) {
+        return 0;
+    }
+
+    /* Coarsest level that still gives every output bucket at least one
+     * entry - at most ~10 entries per bucket to merge - as long as it
+     * reads fewer records in all: the partial entries at both ends of
+     * the window cost about one span of raw records. A narrow query
+     * (the UI trace asks for one bucket per 100 ms) would otherwise
+     * trade ten level-1 entries for up to 200 raw records. */
+    unsigned samples = stop - start;
+    int k = 0;
+    while (k + 1 < HISTORY_LEVELS && samples / level_span[k + 1] >= width &&
+           samples / level_span[k + 1] + level_span[k + 1] <
+               samples / level_span[k] + level_span[k]) {
+        k++;
+    }
+
+    uint32_t span_ms = to_ms - from_ms + 1;
+
+    /* Level entries only where all their samples are inside the window;
+     * the partial entries at both ends (and anything not summarised
+     * yet) come from the raw records - fewer than level_span[k] each */
+    unsigned first = stop, last = stop;
+    if (k > 0) {
+        level_t *lv = &levels[k - 1];
+        unsigned span = level_span[k];
+        unsigned head = atomic_load_explicit(&lv->heads[channel], memory_order_acquire);
+        unsigned keep = lv->size - lv->guard;
+        unsigned e_first = (start + span - 1) / span;
+        unsigned e_last = stop / span;
+
+        if (head > keep && e_first < head - keep) {
+            e_first = head - keep;
+        }
+        if (e_last > head) {
+            e_last = head;
+        }
+
+        if (e_first < e_last) {
+            for (unsigned j = e_first; j < e_last; j++) {
+                const level_entry_t *e = &lv->ring[channel * lv->size + (j & lv->mask)];
+                add_to_bucket(out, width, from_ms, span_ms, e->t_ms, e->min, e->max,
+                              (int64_t)e->mean * span, span);
+            }
+            first = e_first * span;
+            last = e_last * span;
+        }
+    }
+
+    for (unsigned n = start; n < first; n++) {
+        add_raw(out, width, from_ms, span_ms, record_at(channel, n));
+    }
+    for (unsigned n = last; n < stop; n++) {
+        add_raw(out, width, from_ms, span_ms, record_at(channel, n));
+    }
+
+    size_t filled = 0;
+    for (size_t i = 0; i < width; i++) {
+        if (out[i].count > 0) {
+            filled++;
+        }
+    }
+    return filled;
+}
@@ -0,0 +1,124 @@
+/*
+ * history.h
+ * Per-channel time-series history (last N minutes of every channel)
+ *
+ * Each telemetry channel gets a ring buffer of compact
+ * (timestamp, value) records in PSRAM. Appending is O(1) and never
+ * allocates; queries hand back pointers into the ring instead of
+ * copying it.
+ *
+ * On top of the raw records every channel keeps a min/max/mean pyramid
+ * (one entry per 10 samples, one per 100 samples), updated as samples
+ * are appended. history_query_buckets() uses it so drawing a window W
+ * pixels wide touches about 10*W entries, however many samples the
+ * window holds.
+ *
+ * What that buys on the board: HISTORY_DEFAULT_BUDGET_BYTES gives each
+ * channel 8192 records, so a 1200 px window never reaches a level -
+ * that needs 12000 samples in the window (historybench shows it with a
+ * bigger -b). The caller that does use the levels is the UI trace
+ * (ui.c), one bucket per 100 ms column: on a channel faster than
+ * 100 Hz a column is read mostly as level-1 entries instead of every
+ * record (historybench -b 8 -R 1000: 0.2 us instead of 0.6 us a
+ * column). Slower channels are read raw, as without the pyramid.
+ *
+ * One writer (network task), any number of readers (UI).
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define HISTORY_DEFAULT_BUDGET_BYTES    (8 * 1024 * 1024)   /* PSRAM for all channels */
+
+/* Pyramid levels: raw, 10x, 100x */
+#define HISTORY_LEVELS                  3
+#define HISTORY_LEVEL_FACTOR            10
+
+/* Records this close to being overwritten are never handed to a
+ * reader, so a slow reader can still use them safely */
+#define HISTORY_GUARD_RECORDS           256
+
+/* One stored sample (8 bytes) */
+typedef struct {
+    uint32_t t_ms;          /* esp_timer time in milliseconds (wraps after ~49 days) */
+    int32_t value;          /* Fixed-point, same as the telemetry store */
+} history_record_t;
+
+/* Summary of the samples that fall into one output bucket (pixel) */
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int64_t sum;            /* Sum of the samples (mean = sum / count) */
+    uint32_t count;         /* Raw samples covered - 0 means no data here */
+} history_bucket_t;
+
+/* A time window inside one channel's ring. Because the ring wraps, the
+ * window is at most two contiguous pieces: `first` (older) then `second`. */
+typedef struct {
+    const history_record_t *first;
+    size_t first_count;
+    const history_record_t *second;
+    size_t second_count;
+} history_span_t;
+
+/* ============================================================
+ * SETUP
+ * ============================================================ */
+
+/* Allocate the rings in PSRAM. `budget_bytes` is split evenly over all
+ * channels and covers the raw rings plus the pyramid levels (each ring
+ * is rounded down to a power of two entries). */
+esp_err_t history_init(size_t budget_bytes);
+
+/* Records each channel can hold (0 before history_init) */
+size_t history_capacity(void);
+
+/* ============================================================
+ * WRITER SIDE (network task)
+ * ============================================================ */
+void history_append(uint16_t channel, int32_t value, int64_t now_us);
+
+/* ============================================================
+ * READER SIDE
+ * ============================================================ */
+
+/* Find the records of `channel` with from_ms <= t_ms <= to_ms.
+ * No copy - `span` points into the ring. Returns false if empty. */
+bool history_window(uint16_t channel, uint32_t from_ms, uint32_t to_ms, history_span_t *span);
+
+/* Number of records in a span, and the i-th one (0 = oldest) */
+static inline size_t history_span_count(const history_span_t *span)
+{
+    return span->first_count + span->second_count;
+}
+
+static inline const history_record_t *history_span_at(const history_span_t *span, size_t i)
+{
+    return i < span->first_count ? &span->first[i] : &span->second[i - span->first_count];
+}
+
+/* Pull at most `max_points` evenly spaced records of a window into
+ * `out` (e.g. one per chart pixel). Returns the number written. */
+size_t history_query_decimated(uint16_t channel, uint32_t from_ms, uint32_t to_ms,
+                               history_record_t *out, size_t max_points);
+
+/* Summarise [from_ms, to_ms] into exactly `width` equal time buckets
+ * (e.g. one per pixel column) using the coarsest pyramid level that
+ * still has at least `width` entries in the window and means fewer
+ * reads than the level below it. Only samples inside
+ * the window are counted: level entries that straddle either end are
+ * replaced by their raw records. Buckets with no data have count == 0.
+ * Returns the number of non-empty buckets. */
+size_t history_query_buckets(uint16_t channel, uint32_t from_ms, uint32_t to_ms,
+                             history_bucket_t *out, size_t width);
+
+static inline int32_t history_bucket_mean(const history_bucket_t *bucket)
+{
+    return bucket->count ? (int32_t)(bucket->sum / bucket->count) : 0;
+}
@@ -0,0 +1,354 @@
+/*
+ * frame.c
+ * Binary telemetry framing: encoder, CRC and streaming reassembler
+ *
+ * TCP is a byte stream - one recv() can hold half a frame or ten of
+ * them. The parser below copes with both without allocating:
+ *  - complete frames are decoded straight out of the caller's buffer
+ *  - only a frame split across two recv() calls is copied into
+ *    the parser's own buffer until the rest arrives
+ *  - on a bad header or CRC it drops one byte and hunts for the next
+ *    FRAME_SYNC, so one corrupted frame never desyncs the stream
+ */
+
+#include "frame.h"
+
+#include <string.h>
+
+/* ============================================================
+ * CRC-16/CCITT-FALSE lookup table (poly 0x1021)
+ * ============================================================ */
+static const uint16_t crc16_table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0,
+};
+
+uint16_t frame_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc = (uint16_t)((crc << 8) ^ crc16_table[((crc >> 8) ^ *data++) & 0xFF]);
+    }
+    return crc;
+}
+
+/* ============================================================
+ * FRAME SCANNER
+ * Looks at the start of a buffer and decides what it holds
+ * ============================================================ */
+typedef enum {
+    SCAN_FRAME,         /* A complete valid frame, `used` bytes long */
+    SCAN_NEED_MORE,     /* Looks like a frame so far, `used` = total bytes needed */
+    SCAN_NOISE,         /* No sync byte - skip `used` bytes */
+    SCAN_BAD_HEADER,    /* Header invalid - skip 1 byte (whole frame if its CRC was fine) */
+    SCAN_BAD_CRC,       /* Full frame but CRC mismatch - skip 1 byte */
+} scan_result_t;
+
+static scan_result_t scan(const uint8_t *buf, size_t n, frame_t *frame, size_t *used)
+{
+    if (n == 0) {
+        *used = FRAME_HEADER_SIZE;
+        return SCAN_NEED_MORE;
+    }
+
+    /* Not at a frame boundary - jump to the next candidate sync byte */
+    if (buf[0] != FRAME_SYNC) {
+        const uint8_t *next = memchr(buf + 1, FRAME_SYNC, n - 1);
+        *used = next ? (size_t)(next - buf) : n;
+        return SCAN_NOISE;
+    }
+
+    if (n >= 2 && buf[1] != FRAME_VERSION) {
+        *used = 1;
+        return SCAN_BAD_HEADER;
+    }
+
+    if (n < FRAME_HEADER_SIZE) {
+        *used = FRAME_HEADER_SIZE;
+        return SCAN_NEED_MORE;
+    }
+
+    uint16_t length = frame_read_u16(buf + 6);
+    if (length > FRAME_MAX_PAYLOAD) {
+        *used = 1;
+        return SCAN_BAD_HEADER;
+    }
+
+    size_t total = FRAME_HEADER_SIZE + length + FRAME_CRC_SIZE;
+    if (n < total) {
+        *used = total;
+        return SCAN_NEED_MORE;
+    }
+
+    uint16_t crc = frame_read_u16(buf + FRAME_HEADER_SIZE + length);
+    if (crc != frame_crc16(buf, FRAME_HEADER_SIZE + length)) {
+        *used = 1;
+        return SCAN_BAD_CRC;
+    }
+
+    frame->type = buf[2];
+    frame->flags = buf[3];
+    frame->channel = frame_read_u16(buf + 4);
+    frame->seq = 0;
+    frame->length = length;
+    frame->payload = buf + FRAME_HEADER_SIZE;
+
+    if (frame->flags & FRAME_FLAG_SEQ) {
+        if (length < FRAME_SEQ_SIZE) {
+            *used = total;          /* CRC was fine, so the whole frame is bogus */
+            return SCAN_BAD_HEADER;
+        }
+        frame->seq = frame_read_u16(frame->payload);
+        frame->payload += FRAME_SEQ_SIZE;
+        frame->length -= FRAME_SEQ_SIZE;
+    }
+
+    *used = total;
+    return SCAN_FRAME;
+}
+
+/* Update the stats for anything that is not a frame or a short read */
+static void count_skip(frame_parser_stats_t *stats, scan_result_t result, size_t used)
+{
+    switch (result) {
+        case SCAN_NOISE:
+            stats->bytes_skipped += used;
+            break;
+        case SCAN_BAD_HEADER:
+            stats->bad_headers++;
+            break;
+        case SCAN_BAD_CRC:
+            stats->crc_errors++;
+            break;
+        default:
+            break;
+    }
+}
+
+/* ============================================================
+ * STREAMING REASSEMBLER
+ * ============================================================ */
+void frame_parser_init(frame_parser_t *parser)
+{
+    parser->len = 0;
+    memset(&parser->stats, 0, sizeof(parser->stats));
+}
+
+size_t frame_parser_feed(frame_parser_t *parser, const uint8_t *data, size_t len,
+                         frame_handler_t handler, void *ctx)
+{
+    size_t delivered = 0;
+    frame_t frame;
+    size_t used;
+
+    while (len > 0) {
+        /* --------------------------------------------------------
+         * Fast path: nothing buffered, decode in place
+         * -------------------------------------------------------- */
+        if (parser->len == 0) {
+            scan_result_t result = scan(data, len, &frame, &used);
+
+            if (result == SCAN_NEED_MORE) {
+                /* Partial frame at the end - park it (always fits,
+                 * scan() already rejected oversized lengths) */
+                memcpy(parser->buf, data, len);
+                parser->len = len;
+                break;
+            }
+
+            if (result == SCAN_FRAME) {
+                handler(&frame, ctx);
+                parser->stats.frames++;
+                delivered++;
+            } else {
+                count_skip(&parser->stats, result, used);
+            }
+            data += used;
+            len -= used;
+            continue;
+        }
+
+        /* --------------------------------------------------------
+         * Slow path: top up the parked partial frame with exactly
+         * the bytes it still needs, then try to decode it
+         * -------------------------------------------------------- */
+        scan_result_t result = scan(parser->buf, parser->len, &frame, &used);
+        if (result == SCAN_NEED_MORE) {
+            size_t take = used - parser->len;
+            if (take > len) {
+                take = len;
+            }
+            memcpy(parser->buf + parser->len, data, take);
+            parser->len += take;
+            data += take;
+            len -= take;
+            result = scan(parser->buf, parser->len, &frame, &used);
+            if (result == SCAN_NEED_MORE) {
+                continue;
+            }
+        }
+
+        if (result == SCAN_FRAME) {
+            handler(&frame, ctx);
+            parser->stats.frames++;
+            delivered++;
+        } else {
+            count_skip(&parser->stats, result, used);
+        }
+
+        /* Drop what was consumed; whatever is left is re-scanned on
+         * the next pass (only non-empty after a resync) */
+        parser->len -= used;
+        memmove(parser->buf, parser->buf + used, parser->len);
+    }
+
+    /* Bytes left in the buffer after a resync may already hold
+     * complete frames - drain them before returning */
+    while (parser->len > 0) {
+        scan_result_t result = scan(parser->buf, parser->len, &frame, &used);
+        if (result == SCAN_NEED_MORE) {
+            break;
+        }
+        if (result == SCAN_FRAME) {
+            handler(&frame, ctx);
+            parser->stats.frames++;
+            delivered++;
+        } else {
+            count_skip(&parser->stats, result, used);
+        }
+        parser->len -= used;
+        memmove(parser->buf, parser->buf + used, parser->len);
+    }
+
+    return delivered;
+}
+
+size_t frame_parse_stream(const uint8_t *data, size_t len, frame_handler_t handler,
+                          void *ctx, frame_parser_stats_t *stats, size_t *consumed)
+{
+    const uint8_t *start = data;
+    size_t delivered = 0;
+    frame_t frame;
+    size_t used;
+
+    while (len > 0) {
+        scan_result_t result = scan(data, len, &frame, &used);
+
+        if (result == SCAN_NEED_MORE) {
+            break;      /* Partial frame: the caller keeps it for the next read */
+        }
+
+        if (result == SCAN_FRAME) {
+            handler(&frame, ctx);
+            delivered++;
+            if (stats != NULL) {
+                stats->frames++;
+            }
+        } else if (stats != NULL) {
+            count_skip(stats, result, used);
+        }
+        data += used;
+        len -= used;
+    }
+
+    *consumed = (size_t)(data - start);
+    return delivered;
+}
+
+size_t frame_parse_buffer(const uint8_t *data, size_t len, frame_handler_t handler,
+                          void *ctx, frame_parser_stats_t *stats)
+{
+    size_t consumed;
+    size_t delivered = frame_parse_stream(data, len, handler, ctx, stats, &consumed);
+
+    /* Truncated frame - nothing more can arrive for it */
+    if (consumed < len && stats != NULL) {
+        stats->bad_headers++;
+    }
+    return delivered;
+}
+
+/* ============================================================
+ * ENCODER
+ * ============================================================ */
+static size_t encode(uint8_t *out, size_t out_size, uint8_t type, uint8_t flags,
+                     uint16_t channel, const uint8_t *prefix, uint16_t prefix_len,
+                     const void *payload, uint16_t length)
+{
+    size_t wire_len = (size_t)prefix_len + length;
+    size_t total = FRAME_HEADER_SIZE + wire_len + FRAME_CRC_SIZE;
+    if (wire_len > FRAME_MAX_PAYLOAD || out_size < total) {
+        return 0;
+    }
+
+    out[0] = FRAME_SYNC;
+    out[1] = FRAME_VERSION;
+    out[2] = type;
+    out[3] = flags;
+    frame_write_u16(out + 4, channel);
+    frame_write_u16(out + 6, (uint16_t)wire_len);
+    if (prefix_len > 0) {
+        memcpy(out + FRAME_HEADER_SIZE, prefix, prefix_len);
+    }
+    if (length > 0) {
+        memcpy(out + FRAME_HEADER_SIZE + prefix_len, payload, length);
+    }
+    frame_write_u16(out + FRAME_HEADER_SIZE + wire_len,
+                    frame_crc16(out, FRAME_HEADER_SIZE + wire_len));
+    return total;
+}
+
+size_t frame_encode(uint8_t *out, size_t out_size, uint8_t type, uint16_t channel,
+                    const void *payload, uint16_t length)
+{
+    return encode(out, out_size, type, 0, channel, NULL, 0, payload, length);
+}
+
+size_t frame_encode_seq(uint8_t *out, size_t out_size, uint8_t type, uint16_t channel,
+                        uint16_t seq, const void *payload, uint16_t length)
+{
+    return frame_encode_flags(out, out_size, type, FRAME_FLAG_SEQ, channel, seq, payload, length);
+}
+
+size_t frame_encode_flags(uint8_t *out, size_t out_size, uint8_t type, uint8_t flags,
+                          uint16_t channel, uint16_t seq, const void *payload, uint16_t length)
+{
+    uint8_t prefix[FRAME_SEQ_SIZE];
+    uint16_t prefix_len = 0;
+
+    if (flags & FRAME_FLAG_SEQ) {
+        frame_write_u16(prefix, seq);
+        prefix_len = sizeof(prefix);
+    }
+    return encode(out, out_size, type, flags, channel, prefix, prefix_len, payload, length);
+}
@@ -0,0 +1,40 @@
+/*
+ * frame_batch.c
+ * FRAME_TYPE_BATCH / BATCH_TS payload encoder (the decoder is inline in the header)
+ */
+
+#include "frame_batch.h"
+
+void frame_batch_writer_init(frame_batch_writer_t *w)
+{
+    w->len = 0;
+    w->count = 0;
+    w->last = (frame_batch_sample_t){ 0 };
+}
+
+void frame_batch_writer_init_stamped(frame_batch_writer_t *w)
+{
+    frame_batch_writer_init(w);
+    frame_batch_set_stamp(w, 0);
+    w->len = FRAME_BATCH_STAMP_SIZE;
+}
+
+bool frame_batch_add(frame_batch_writer_t *w, uint16_t channel, uint32_t age_us, int32_t value)
+{
+    if (w->len + FRAME_BATCH_MAX_TUPLE > sizeof(w->buf)) {
+        return false;
+    }
+
+    int32_t channel_delta = (int32_t)channel - (int32_t)w->last.channel;
+    int32_t base = channel_delta == 0 ? w->last.value : 0;
+
+    uint8_t *p = w->buf + w->len;
+    p += frame_write_varint(p, frame_zigzag(channel_delta));
+    p += frame_write_varint(p, frame_zigzag((int32_t)(age_us - w->last.age_us)));
+    p += frame_write_varint(p, frame_zigzag((int32_t)((uint32_t)value - (uint32_t)base)));
+    w->len = (size_t)(p - w->buf);
+    w->count++;
+
+    w->last = (frame_batch_sample_t){ channel, value, age_us };
+    return true;
+}
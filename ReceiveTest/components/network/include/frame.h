@@ -0,0 +1,201 @@
+/*
+ * frame.h
+ * Length-prefixed binary telemetry frames + streaming reassembler
+ *
+ * Wire format (all multi-byte fields little-endian):
+ *
+ *   offset  size  field
+ *   0       1     sync      (FRAME_SYNC)
+ *   1       1     version   (FRAME_VERSION)
+ *   2       1     type      (frame_type_t)
+ *   3       1     flags     (FRAME_FLAG_*)
+ *   4       2     channel   (which telemetry channel this is for)
+ *   6       2     length    (payload bytes, <= FRAME_MAX_PAYLOAD)
+ *   8       N     payload
+ *   8+N     2     crc       (CRC-16/CCITT-FALSE over header + payload)
+ *
+ * With FRAME_FLAG_SEQ set, the first two payload bytes are a per-channel
+ * sequence number (+1 for every frame the sender sends on that channel).
+ * The parser strips them off into frame_t.seq, so handlers see the same
+ * payload either way.
+ *
+ * FRAME_FLAG_CRITICAL puts a frame in the receiver's critical lane: it
+ * is handled as soon as it is parsed, ahead of any queued bulk traffic.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================
+ * PROTOCOL CONSTANTS
+ * ============================================================ */
+#define FRAME_SYNC          0xA5
+#define FRAME_VERSION       0x01
+#define FRAME_HEADER_SIZE   8
+#define FRAME_CRC_SIZE      2
+#define FRAME_MAX_PAYLOAD   512
+#define FRAME_MAX_SIZE      (FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE)
+#define FRAME_SEQ_SIZE      2
+
+/* Header flags */
+#define FRAME_FLAG_SEQ      0x01    /* Payload starts with a u16 per-channel sequence number */
+#define FRAME_FLAG_CRITICAL 0x02    /* Fault / trip: handled ahead of all other traffic */
+
+/* What the payload of a frame contains */
+typedef enum {
+    FRAME_TYPE_TEXT      = 0x01,    /* UTF-8 string for the main display (not NUL-terminated) */
+    FRAME_TYPE_VALUE     = 0x02,    /* One int32 sample for `channel` */
+    FRAME_TYPE_PROBE     = 0x03,    /* Latency probe, see FRAME_PROBE_SIZE */
+    FRAME_TYPE_PROBE_ACK = 0x04,    /* Receiver -> sender answer to a probe */
+    FRAME_TYPE_BATCH     = 0x05,    /* Many samples, delta + varint coded (frame_batch.h) */
+    FRAME_TYPE_TIME_REQ  = 0x06,    /* Clock sync request, see FRAME_TIME_REQ_SIZE */
+    FRAME_TYPE_TIME_RESP = 0x07,    /* Receiver -> sender answer to a TIME_REQ */
+    FRAME_TYPE_BATCH_TS  = 0x08,    /* BATCH stamped with the sender's clock (frame_batch.h) */
+    FRAME_TYPE_LAP       = 0x09,    /* Lap marker, no payload: restart the running statistics */
+} frame_type_t;
+
+/* Latency probe payloads.
+ *   PROBE:     u32 seq, u64 sender_ts_us
+ *   PROBE_ACK: u32 seq, u64 sender_ts_us (echoed), u32 recv->apply us,
+ *              u32 apply->flush us, then p50 / p99 / max recv->flush us
+ *              over all probes so far (u32 each) */
+#define FRAME_PROBE_SIZE        12
+#define FRAME_PROBE_ACK_SIZE    32
+
+/* Clock sync payloads (NTP-style, the sender is the client).
+ *   TIME_REQ:  u32 seq, u64 t1 (sender clock, us), u64 t4 of request
+ *              seq - 1 (when the sender got its TIME_RESP; 0 = none)
+ *   TIME_RESP: u32 seq, u64 t1 (echoed), u64 t2 (receiver clock when
+ *              the request arrived), u64 t3 (receiver clock when sent)
+ * Handing t4 back in the next request lets the receiver, which is the
+ * side that needs the offset, finish the exchange (clock_sync.h). */
+#define FRAME_TIME_REQ_SIZE     20
+#define FRAME_TIME_RESP_SIZE    28
+
+/* One decoded frame. `payload` points into a buffer owned by the
+ * parser (or the caller's receive buffer) and is only valid for the
+ * duration of the handler call - copy it if you need to keep it. */
+typedef struct {
+    uint8_t type;
+    uint8_t flags;
+    uint16_t channel;
+    uint16_t seq;               /* Only meaningful with FRAME_FLAG_SEQ */
+    uint16_t length;            /* Payload length, without the sequence number */
+    const uint8_t *payload;
+} frame_t;
+
+/* Called once for every complete, CRC-valid frame */
+typedef void (*frame_handler_t)(const frame_t *frame, void *ctx);
+
+/* Error / throughput counters, kept per parser */
+typedef struct {
+    uint32_t frames;            /* Frames delivered to the handler */
+    uint32_t crc_errors;        /* Frames dropped because the CRC did not match */
+    uint32_t bad_headers;       /* Wrong version, length > FRAME_MAX_PAYLOAD, or
+                                   FRAME_FLAG_SEQ on a payload too short for it */
+    uint32_t bytes_skipped;     /* Bytes thrown away while hunting for FRAME_SYNC */
+} frame_parser_stats_t;
+
+/* Streaming reassembler state. Holds at most one partial frame, so it
+ * never allocates - embed one per connection. */
+typedef struct {
+    uint8_t buf[FRAME_MAX_SIZE];
+    size_t len;
+    frame_parser_stats_t stats;
+} frame_parser_t;
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Reset a parser to its empty state (also clears the stats) */
+void frame_parser_init(frame_parser_t *parser);
+
+/* Feed any number of received bytes. Works with arbitrary splits:
+ * a frame may arrive one byte at a time or many frames in one call.
+ * Complete frames are passed to `handler`; a trailing partial frame is
+ * kept until the next call. Returns the number of frames delivered. */
+size_t frame_parser_feed(frame_parser_t *parser, const uint8_t *data, size_t len,
+                         frame_handler_t handler, void *ctx);
+
+/* Decode a buffer that holds only whole frames (e.g. one UDP datagram).
+ * Nothing is carried over between calls; errors are added to `stats`
+ * (may be NULL). Returns the number of frames delivered. */
+size_t frame_parse_buffer(const uint8_t *data, size_t len, frame_handler_t handler,
+                          void *ctx, frame_parser_stats_t *stats);
+
+/* Decode whole frames in place and stop at a trailing partial frame,
+ * leaving it to the caller: `consumed` is set to the bytes used up, and
+ * data[consumed..len) must be passed in again, with more bytes after
+ * it, on the next call (net_server.c does this with pool buffers, so
+ * payloads never leave the receive buffer). Errors are added to `stats`
+ * (may be NULL). Returns the number of frames delivered. */
+size_t frame_parse_stream(const uint8_t *data, size_t len, frame_handler_t handler,
+                          void *ctx, frame_parser_stats_t *stats, size_t *consumed);
+
+/* Build one frame into `out`. Returns the number of bytes written,
+ * or 0 if the payload is too long or `out` is too small. */
+size_t frame_encode(uint8_t *out, size_t out_size, uint8_t type, uint16_t channel,
+                    const void *payload, uint16_t length);
+
+/* Same, with FRAME_FLAG_SEQ and `seq` in front of the payload.
+ * `length` is the payload alone (at most FRAME_MAX_PAYLOAD - 2). */
+size_t frame_encode_seq(uint8_t *out, size_t out_size, uint8_t type, uint16_t channel,
+                        uint16_t seq, const void *payload, uint16_t length);
+
+/* Any combination of FRAME_FLAG_*; `seq` is only sent with FRAME_FLAG_SEQ */
+size_t frame_encode_flags(uint8_t *out, size_t out_size, uint8_t type, uint8_t flags,
+                          uint16_t channel, uint16_t seq, const void *payload, uint16_t length);
+
+/* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) */
+uint16_t frame_crc16(const uint8_t *data, size_t len);
+
+/* The whole frame as it arrived (header through CRC) and its size.
+ * Only for frames handed out by the parser - their payload always sits
+ * inside the received bytes, right after the header. */
+static inline const uint8_t *frame_wire(const frame_t *frame, size_t *size)
+{
+    size_t prefix = FRAME_HEADER_SIZE + ((frame->flags & FRAME_FLAG_SEQ) ? FRAME_SEQ_SIZE : 0);
+    *size = prefix + frame->length + FRAME_CRC_SIZE;
+    return frame->payload - prefix;
+}
+
+/* ============================================================
+ * PAYLOAD HELPERS
+ * ============================================================ */
+static inline uint16_t frame_read_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t frame_read_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t frame_read_u64(const uint8_t *p)
+{
+    return (uint64_t)frame_read_u32(p) | ((uint64_t)frame_read_u32(p + 4) << 32);
+}
+
+static inline void frame_write_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void frame_write_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void frame_write_u64(uint8_t *p, uint64_t v)
+{
+    frame_write_u32(p, (uint32_t)v);
+    frame_write_u32(p + 4, (uint32_t)(v >> 32));
+}
@@ -0,0 +1,178 @@
+/*
+ * frame_batch.h
+ * Many samples in one frame: FRAME_TYPE_BATCH payload encoder / decoder
+ *
+ * Payload = back-to-back tuples of three zigzag varints:
+ *
+ *   channel delta   channel - previous tuple's channel (first: - 0)
+ *   age delta       age_us  - previous tuple's age_us  (first: - 0)
+ *   value delta     value - previous tuple's value if the channel did
+ *                   not change, value - 0 otherwise
+ *
+ * age_us is how long before the frame was sent the sample was taken,
+ * so the receiver timestamps it as rx_time - age_us without needing the
+ * sender's clock. Senders should group samples by channel (oldest
+ * first within a channel): then the channel delta is 0 and the value
+ * and age deltas are small, and most tuples take 3-4 bytes instead of
+ * a 16-byte VALUE frame.
+ *
+ * Zigzag maps signed to unsigned (0, -1, 1, -2 ... -> 0, 1, 2, 3 ...);
+ * varints are little-endian base-128, high bit = more bytes follow.
+ *
+ * The frame header's channel is not a telemetry channel: it names the
+ * sender's batch stream (FRAME_BATCH_CHANNEL), so FRAME_FLAG_SEQ on a
+ * batch numbers the batches.
+ *
+ * FRAME_TYPE_BATCH_TS is the same payload behind a u64 stamp: the
+ * sender's clock (us) when the frame was sent. Ages are relative to
+ * the stamp, and a receiver that has synced to the sender's clock
+ * (clock_sync.h) uses it instead of the arrival time, so network and
+ * queueing delay do not end up in the sample times.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "frame.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define FRAME_BATCH_CHANNEL         0xFFFF  /* Header channel of batch frames */
+#define FRAME_BATCH_MAX_PAYLOAD     (FRAME_MAX_PAYLOAD - FRAME_SEQ_SIZE)
+#define FRAME_BATCH_MAX_TUPLE       15      /* 3 x 5-byte varint */
+#define FRAME_BATCH_STAMP_SIZE      8       /* u64 in front of a BATCH_TS payload */
+
+/* One decoded sample */
+typedef struct {
+    uint16_t channel;
+    int32_t value;
+    uint32_t age_us;
+} frame_batch_sample_t;
+
+/* Decoder state. Walk a payload with frame_batch_next(). */
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    frame_batch_sample_t last;
+    bool error;                 /* Set if the payload ended mid-tuple */
+} frame_batch_reader_t;
+
+/* Encoder state. Build the payload in `buf`, then send it with
+ * frame_encode_seq(..., FRAME_TYPE_BATCH, FRAME_BATCH_CHANNEL, ...). */
+typedef struct {
+    uint8_t buf[FRAME_BATCH_MAX_PAYLOAD];
+    size_t len;
+    uint16_t count;
+    frame_batch_sample_t last;
+} frame_batch_writer_t;
+
+/* ============================================================
+ * VARINTS
+ * ============================================================ */
+static inline uint32_t frame_zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t frame_unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/* Returns the byte after the varint, or NULL if it runs past `end` or
+ * is longer than 5 bytes */
+static inline const uint8_t *frame_read_varint(const uint8_t *p, const uint8_t *end, uint32_t *out)
+{
+    if (p < end && *p < 0x80) {         /* Fast path: one byte */
+        *out = *p;
+        return p + 1;
+    }
+
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (b < 0x80) {
+            *out = v;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/* Writes at most 5 bytes, returns the number written */
+static inline size_t frame_write_varint(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/* ============================================================
+ * DECODER
+ * Inline so the receive path's per-sample loop compiles to a
+ * straight run of byte loads with no calls.
+ * ============================================================ */
+static inline void frame_batch_reader_init(frame_batch_reader_t *r, const uint8_t *payload,
+                                           size_t length)
+{
+    r->p = payload;
+    r->end = payload + length;
+    r->last = (frame_batch_sample_t){ 0 };
+    r->error = false;
+}
+
+/* Decode the next sample. Returns false at the end of the payload (or
+ * on a truncated tuple, which also sets `error`). */
+static inline bool frame_batch_next(frame_batch_reader_t *r, frame_batch_sample_t *out)
+{
+    uint32_t dch, dage, dval;
+    const uint8_t *p = r->p;
+
+    if (p == r->end) {
+        return false;
+    }
+    if ((p = frame_read_varint(p, r->end, &dch)) == NULL ||
+        (p = frame_read_varint(p, r->end, &dage)) == NULL ||
+        (p = frame_read_varint(p, r->end, &dval)) == NULL) {
+        r->error = true;
+        r->p = r->end;
+        return false;
+    }
+    r->p = p;
+
+    int32_t channel_delta = frame_unzigzag(dch);
+    r->last.channel = (uint16_t)(r->last.channel + channel_delta);
+    r->last.age_us += (uint32_t)frame_unzigzag(dage);
+    r->last.value = (int32_t)((uint32_t)(channel_delta == 0 ? r->last.value : 0) +
+                              (uint32_t)frame_unzigzag(dval));
+    *out = r->last;
+    return true;
+}
+
+/* ============================================================
+ * ENCODER
+ * ============================================================ */
+
+/* Start an empty payload */
+void frame_batch_writer_init(frame_batch_writer_t *w);
+
+/* Start an empty payload for a BATCH_TS frame: the stamp goes in the
+ * first FRAME_BATCH_STAMP_SIZE bytes of buf (frame_batch_set_stamp) and
+ * len includes it */
+void frame_batch_writer_init_stamped(frame_batch_writer_t *w);
+
+static inline void frame_batch_set_stamp(frame_batch_writer_t *w, uint64_t sender_us)
+{
+    frame_write_u64(w->buf, sender_us);
+}
+
+/* Append one sample. Returns false (and appends nothing) once the
+ * payload is full - send it, re-init and add the sample again. */
+bool frame_batch_add(frame_batch_writer_t *w, uint16_t channel, uint32_t age_us, int32_t value);
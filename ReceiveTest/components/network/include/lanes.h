@@ -0,0 +1,76 @@
+/*
+ * lanes.h
+ * Strict-priority ingest: a critical lane and a bulk lane
+ *
+ * A fault or BMS trip must never wait behind a burst of cell voltages.
+ * The server task sorts every parsed frame into one of two lanes:
+ *
+ *   critical  FRAME_FLAG_CRITICAL frames - dispatched on the spot,
+ *             before anything still sitting in the bulk queue
+ *   bulk      everything else - queued by reference (the payload stays
+ *             in its rx_pool buffer) and dispatched
+ *             NET_BULK_SLICE frames at a time; between slices the
+ *             server polls its sockets again without sleeping, so a
+ *             critical frame waits for at most one slice
+ *
+ * If the bulk queue fills up, it is drained completely before the new
+ * frame is dispatched, so bulk frames never reorder or get dropped -
+ * the sender just sees TCP back-pressure.
+ *
+ * Server task only, except lanes_get_stats() (plain copy, a torn read
+ * gives a number that is one frame stale).
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "frame.h"
+#include "network.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define LANES_BULK_QUEUE_DEPTH  512     /* Frames; power of two */
+
+/* Per-lane counters. Waits are rx_time -> handed to the data callback. */
+typedef struct {
+    uint32_t dispatched;        /* Frames handed to the data callback */
+    uint32_t depth;             /* Frames queued right now (bulk only) */
+    uint32_t max_depth;         /* Most frames ever queued at once */
+    uint32_t overflows;         /* Times the queue was full and drained inline */
+    uint32_t p50_us;            /* Wait percentiles, upper bound of a power-of-two bucket */
+    uint32_t p99_us;
+    uint32_t max_us;
+} lane_stats_t;
+
+/* Called for every frame a lane hands out */
+typedef void (*lanes_dispatch_t)(const frame_t *frame, const network_rx_info_t *rx);
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Lane for a frame, from its header flags */
+static inline network_lane_t lanes_classify(const frame_t *frame)
+{
+    return (frame->flags & FRAME_FLAG_CRITICAL) ? NETWORK_LANE_CRITICAL : NETWORK_LANE_BULK;
+}
+
+/* Queue a bulk frame, taking a reference on rx->buf until it has been
+ * dispatched. Returns false if the queue is full (or the frame has no
+ * pool buffer to keep it alive). */
+bool lanes_push_bulk(const frame_t *frame, const network_rx_info_t *rx);
+
+/* Dispatch up to `max` queued bulk frames, oldest first. Returns the
+ * number dispatched. */
+size_t lanes_drain_bulk(size_t max, lanes_dispatch_t dispatch);
+
+/* True while bulk frames are waiting */
+bool lanes_bulk_pending(void);
+
+/* Count one dispatched frame that waited `wait_us` since it arrived */
+void lanes_record_dispatch(network_lane_t lane, int64_t wait_us);
+
+/* Copy out one lane's counters */
+void lanes_get_stats(network_lane_t lane, lane_stats_t *stats);
@@ -0,0 +1,66 @@
+/*
+ * link_quality.h
+ * Per-channel and per-connection link statistics
+ *
+ * Every frame that arrives goes through link_quality_record() on the
+ * server task. Frames sent with FRAME_FLAG_SEQ are checked against a
+ * sequence window per channel and sender (gaps, duplicates, reorders);
+ * all frames update the inter-arrival interval and jitter. A sender is
+ * a TCP connection or a UDP source address + port, so two UDP senders
+ * on one channel each keep their own window. The counters are fixed
+ * arrays written by the server task only; each channel, connection and
+ * the total has its own seqlock, so a reader on another core always
+ * copies a consistent set.
+ *
+ * Only ids in the channel list (and the batch stream) have per-channel
+ * stats. Frames on any other id still count towards their connection
+ * and the total, as untracked.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "frame.h"
+#include "network.h"
+#include "telemetry_channels.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define LINK_MAX_CHANNELS       TELEMETRY_CHANNEL_COUNT    /* Ids with their own stats */
+#define LINK_MAX_CONNS          8       /* TCP client slots + one for all of UDP */
+#define LINK_CONN_SLOT_UDP      (LINK_MAX_CONNS - 1)
+#define LINK_SENDERS_PER_CHANNEL 2      /* Windows per channel; a further sender takes
+                                         * over the least recently heard one */
+
+typedef struct {
+    uint32_t received;          /* Frames accepted (duplicates not included) */
+    uint32_t sequenced;         /* ... of which carried a sequence number */
+    uint32_t lost;              /* Sequence gaps not filled by a late frame */
+    uint32_t duplicates;        /* Dropped: sequence number already seen */
+    uint32_t reordered;         /* Arrived after a higher sequence number */
+    uint32_t untracked;         /* Channel id outside the channel list (no sequence check) */
+    uint32_t interval_us;       /* Mean time between frames (1/16 EWMA) */
+    uint32_t jitter_us;         /* Mean deviation from that interval (1/16 EWMA, as RFC 3550) */
+    int64_t last_rx_us;         /* 0 = nothing yet */
+} link_stats_t;
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Server task, once per frame. Returns false if the frame is a
+ * duplicate and should not be processed. */
+bool link_quality_record(const frame_t *frame, const network_rx_info_t *rx);
+
+/* Copy out one channel (or FRAME_BATCH_CHANNEL for the batch frames
+ * themselves). Returns false if the id is out of range or nothing has
+ * arrived on it. */
+bool link_quality_get_channel(uint16_t channel, link_stats_t *stats);
+
+/* Copy out one connection slot (0..LINK_MAX_CONNS-1) and the id of the
+ * connection in it. Returns false if the slot has never been used. */
+bool link_quality_get_conn(int slot, int32_t *conn, link_stats_t *stats);
+
+/* Sum over all frames (interval/jitter are not meaningful here) */
+void link_quality_get_total(link_stats_t *stats);
@@ -0,0 +1,82 @@
+/*
+ * net_server.h
+ * Single-task event loop that serves many telemetry producers at once
+ * (TCP clients plus the UDP socket from udp_server.h)
+ *
+ * Builds against lwIP sockets on the ESP32 and POSIX sockets on Linux.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "network.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define NET_MAX_CLIENTS         6       /* Concurrent TCP producers (LWIP_MAX_SOCKETS is 10) */
+#define NET_IDLE_TIMEOUT_MS     30000   /* Close a client that sends nothing for this long */
+#define NET_POLL_INTERVAL_MS    20      /* Longest the loop sleeps before polling / idle checks */
+#define NET_POOL_RETRY_MS       10      /* Recheck interval while every rx_pool buffer is held */
+#define NET_BULK_SLICE          64      /* Bulk frames dispatched between socket polls (lanes.h) */
+#define NET_TX_QUEUE_SIZE       1024    /* Reply bytes held per client while its socket is full */
+#define NET_TASK_STACK_SIZE     8192    /* Bytes - the whole ingest chain runs on it, see below */
+#define NET_TASK_PRIORITY       5
+#define NET_STACK_CHECK_MS      1000    /* How often the loop samples its stack high water mark */
+#define NET_STACK_MARGIN        1024    /* Warn once if less than this was ever left free */
+
+/* Every frame handler runs on the server task: parser, link quality,
+ * lanes, the data callback with the store, history, stats, alarms and
+ * the recorder tap, and the poll callback with its replies. The host
+ * build (loadgen over TCP and UDP with batches, probes, clock sync and
+ * the recorder on, debug logging) peaks at about 5.4 KB of stack -
+ * 64-bit code calling glibc, so more than the board needs. The size
+ * leaves half as much again on top; stack_free_min below reports what
+ * the board actually leaves free. */
+
+/* Aggregate counters since start (read with net_server_get_stats) */
+typedef struct {
+    uint32_t clients_active;    /* Currently connected */
+    uint32_t accepted;          /* Connections accepted */
+    uint32_t rejected;          /* Connections refused because all slots were busy */
+    uint32_t idle_closed;       /* Connections closed by the idle timeout */
+    uint32_t frames;            /* Valid TCP frames delivered to the callback */
+    uint32_t crc_errors;        /* TCP frames dropped on CRC mismatch (all clients) */
+    uint32_t pool_stalls;       /* Loop passes that left the sockets unread: no rx_pool buffer free */
+    uint32_t tx_queued;         /* Replies (partly) held back for a full socket */
+    uint32_t tx_dropped;        /* Replies refused because the client's queue was full */
+    uint32_t pass_max_us;       /* Longest loop pass, select() return to the next select() */
+    uint32_t stack_free_min;    /* Fewest bytes of NET_TASK_STACK_SIZE ever left free */
+    uint64_t bytes;             /* Raw TCP bytes received (UDP totals: udp_server.h) */
+} net_server_stats_t;
+
+/* Start the server task listening on `tcp_port` and `udp_port`.
+ * `callback` is called from the server task for every complete frame,
+ * whichever client or transport it came from; `poll` (may be NULL)
+ * at least every NET_POLL_INTERVAL_MS. */
+esp_err_t net_server_start(uint16_t tcp_port, uint16_t udp_port,
+                           network_data_callback_t callback, network_poll_callback_t poll);
+
+/* Also hand every frame to `tap` as the parser delivers it: in arrival
+ * order, before duplicates are dropped and before the lanes reorder
+ * anything (rx->lane is the lane it is about to take). For a recorder
+ * of the raw stream. Call before net_server_start(); server task. */
+void net_server_set_frame_tap(network_data_callback_t tap);
+
+/* Send one whole frame to a TCP connection (id from network_rx_info_t.conn).
+ * Only call this from the server task (data or poll callback). Never
+ * blocks and never sends part of a frame: whatever the socket does not
+ * take now waits in a per-client queue (NET_TX_QUEUE_SIZE) and goes out
+ * when the socket is writable again. Returns `len`, or -1 if the
+ * connection is gone or the queue has no room for the whole frame. */
+int net_server_send(int32_t conn, const void *data, size_t len);
+
+/* The TCP connection from `peer_addr` (the most recently active one if
+ * there are several), or NETWORK_CONN_UDP if it has none. Lets a reply
+ * to a frame that came over UDP go back on the sender's TCP connection.
+ * Server task only, like net_server_send(). */
+int32_t net_server_find_conn(uint32_t peer_addr);
+
+/* Copy out the current counters */
+void net_server_get_stats(net_server_stats_t *stats);
@@ -4,13 +4,43 @@
  */
 #pragma once
 
+#include <stdint.h>
 #include "esp_err.h"
+#include "frame.h"
+#include "rx_pool.h"
 
-/* Callback function type - called when data is received */
-typedef void (*network_data_callback_t)(const char *data, int length);
+/* Connection id used for frames that arrived over UDP */
+#define NETWORK_CONN_UDP    (-1)
+
+/* Ingest lane a frame is dispatched on (see lanes.h) */
+typedef enum {
+    NETWORK_LANE_CRITICAL,  /* FRAME_FLAG_CRITICAL: dispatched as soon as it is parsed */
+    NETWORK_LANE_BULK,      /* Everything else: queued, dispatched in slices */
+    NETWORK_LANE_COUNT,
+} network_lane_t;
+
+/* Where and when a frame came in */
+typedef struct {
+    int64_t rx_time_us;     /* esp_timer time when recv() returned the bytes */
+    int32_t conn;           /* TCP connection id, or NETWORK_CONN_UDP */
+    network_lane_t lane;
+    rx_buf_t *buf;          /* Pool buffer holding the payload (see rx_pool.h) */
+    uint32_t peer_addr;     /* Sender's IPv4 address, network byte order */
+    uint16_t peer_port;     /* UDP: sender's source port, network byte order (TCP: 0) */
+} network_rx_info_t;
+
+/* Callback function type - called once for every complete frame received.
+ * The frame payload is only valid until the callback returns, unless
+ * the callback takes a reference with rx_pool_ref(rx->buf) - then it
+ * stays valid until the matching rx_pool_release(). */
+typedef void (*network_data_callback_t)(const frame_t *frame, const network_rx_info_t *rx);
+
+/* Called from the server task every few milliseconds - the place to
+ * send replies with net_server_send() (see net_server.h). May be NULL. */
+typedef void (*network_poll_callback_t)(void);
 
 /* Initialize Ethernet with static IP and start TCP server */
-esp_err_t network_init(network_data_callback_t callback);
+esp_err_t network_init(network_data_callback_t callback, network_poll_callback_t poll);
 
 /* Get our IP address as a string (for display) */
 const char* network_get_ip(void);
@@ -0,0 +1,66 @@
+/*
+ * rx_pool.h
+ * Fixed pool of reference-counted receive buffers
+ *
+ * The server task recv()s straight into a pool buffer and the parser
+ * decodes frames in place, so frame_t.payload points into that buffer.
+ * Anything that wants to keep a payload past the handler call (the bulk
+ * lane, a consumer task) takes a reference on network_rx_info_t.buf
+ * instead of copying, and drops it when done; the buffer goes back to
+ * the pool when the last reference is released.
+ *
+ * The pool is static - nothing is allocated after boot. When every
+ * buffer is taken, rx_pool_get() returns NULL and the caller leaves the
+ * bytes in the socket (TCP back-pressure / the UDP receive queue).
+ *
+ * rx_pool_get() is for the server task only; rx_pool_ref() and
+ * rx_pool_release() may be called from any task.
+ */
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define RX_POOL_BUFFERS         32      /* At most 32: the free list is one bitmap word */
+#define RX_POOL_BUFFER_SIZE     1536    /* One UDP datagram, or a partial frame + a recv() */
+
+typedef struct {
+    uint8_t data[RX_POOL_BUFFER_SIZE];
+    atomic_uint refs;           /* 0 while the buffer is free */
+    uint8_t index;              /* Slot in the pool */
+} rx_buf_t;
+
+/* Occupancy counters (read with rx_pool_get_stats) */
+typedef struct {
+    uint32_t in_use;            /* Buffers holding at least one reference right now */
+    uint32_t high_water;        /* Most buffers ever in use at once */
+    uint32_t gets;              /* Buffers handed out */
+    uint32_t exhausted;         /* rx_pool_get() calls that found the pool empty */
+} rx_pool_stats_t;
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Take a free buffer with one reference, or NULL if all are in use */
+rx_buf_t *rx_pool_get(void);
+
+/* Add a reference. `buf` must already hold one. */
+static inline void rx_pool_ref(rx_buf_t *buf)
+{
+    atomic_fetch_add_explicit(&buf->refs, 1, memory_order_relaxed);
+}
+
+/* Drop a reference; the last one returns the buffer to the pool.
+ * NULL is ignored. */
+void rx_pool_release(rx_buf_t *buf);
+
+/* Buffers rx_pool_get() could hand out right now */
+uint32_t rx_pool_available(void);
+
+/* Copy out the counters */
+void rx_pool_get_stats(rx_pool_stats_t *stats);
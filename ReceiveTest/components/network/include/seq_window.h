@@ -0,0 +1,77 @@
+/*
+ * seq_window.h
+ * Sequence number tracking with a 64-entry sliding window
+ *
+ * Same idea as IPsec anti-replay: remember which of the last 64
+ * numbers below the highest one have been seen, so a late packet can
+ * fill in a gap that was already counted as lost, and a repeat can be
+ * told apart from a reorder. Used for UDP datagrams and for the
+ * per-channel frame sequence numbers.
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t highest;           /* Highest sequence number seen */
+    uint64_t window;            /* Bit i set = (highest - i) was received */
+    uint32_t received;          /* Accepted (not duplicates) */
+    uint32_t lost;              /* Gaps not (yet) filled by a late arrival */
+    uint32_t reordered;         /* Arrived after a higher sequence number */
+    uint32_t duplicates;        /* Same sequence number seen twice */
+} seq_window_t;
+
+typedef enum {
+    SEQ_NEXT,                   /* Newest so far (possibly after a gap) */
+    SEQ_LATE,                   /* Older than the newest, first time seen */
+    SEQ_DUPLICATE,              /* Seen before - drop it */
+} seq_result_t;
+
+static inline seq_result_t seq_window_track(seq_window_t *w, uint32_t seq)
+{
+    if (w->received == 0) {
+        w->highest = seq;
+        w->window = 1;
+        w->received = 1;
+        return SEQ_NEXT;
+    }
+
+    int32_t ahead = (int32_t)(seq - w->highest);
+
+    if (ahead > 0) {
+        /* In order (ahead == 1) or skipped some numbers */
+        w->window = (ahead >= 64) ? 0 : (w->window << ahead);
+        w->window |= 1;
+        w->highest = seq;
+        w->lost += (uint32_t)(ahead - 1);
+        w->received++;
+        return SEQ_NEXT;
+    }
+
+    uint32_t age = (uint32_t)(-ahead);
+    if (age < 64 && (w->window & (1ULL << age))) {
+        w->duplicates++;
+        return SEQ_DUPLICATE;
+    }
+
+    /* Late arrival: it was counted as lost when the gap opened */
+    if (age < 64) {
+        w->window |= 1ULL << age;
+        if (w->lost > 0) {
+            w->lost--;
+        }
+    }
+    w->reordered++;
+    w->received++;
+    return SEQ_LATE;
+}
+
+/* Widen a 16-bit wire sequence number to 32 bits, taking the one
+ * closest to the highest number seen so far */
+static inline uint32_t seq_window_unwrap16(const seq_window_t *w, uint16_t seq)
+{
+    if (w->received == 0) {
+        return seq;
+    }
+    return w->highest + (uint32_t)(int32_t)(int16_t)(seq - (uint16_t)w->highest);
+}
@@ -0,0 +1,69 @@
+/*
+ * udp_server.h
+ * UDP ingest for high-rate channels (no head-of-line blocking)
+ *
+ * Datagram layout (little-endian):
+ *
+ *   offset  size  field
+ *   0       1     magic     (UDP_DGRAM_MAGIC)
+ *   1       1     version   (UDP_DGRAM_VERSION)
+ *   2       2     reserved  (send 0)
+ *   4       4     sequence  (per sender, +1 for every datagram)
+ *   8       ...   one or more whole frames (see frame.h)
+ *
+ * Senders are told apart by source address + port. The sequence
+ * number is what lets us count lost, duplicated and reordered
+ * datagrams per sender.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "frame.h"
+#include "network.h"
+#include "seq_window.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define UDP_DGRAM_MAGIC         0xD7
+#define UDP_DGRAM_VERSION       0x01
+#define UDP_DGRAM_HEADER_SIZE   8
+#define UDP_MAX_DATAGRAM        1472    /* Fits one Ethernet MTU without fragmentation */
+#define UDP_BATCH               16      /* Datagrams drained per wake-up */
+#define UDP_MAX_SOURCES         8       /* Senders tracked at once (oldest is evicted) */
+
+/* Per-sender sequence tracking */
+typedef struct {
+    uint32_t addr;              /* IPv4 address, network byte order (0 = unused slot) */
+    uint16_t port;              /* Source port, network byte order */
+    seq_window_t seq;           /* Datagram counts: received, lost, reordered, duplicates */
+    int64_t last_seen_us;
+} udp_source_stats_t;
+
+/* Totals over all senders */
+typedef struct {
+    uint32_t datagrams;         /* Datagrams received */
+    uint32_t batches;           /* Wake-ups that drained at least one datagram */
+    uint32_t bad_datagrams;     /* Too short or wrong magic/version */
+    uint32_t frames;            /* Valid frames delivered to the callback */
+    uint32_t frame_errors;      /* CRC/header errors inside datagrams */
+    uint32_t lost;
+    uint32_t reordered;
+    uint32_t duplicates;
+} udp_server_stats_t;
+
+/* Create and bind the non-blocking UDP socket. Returns the socket, or -1. */
+int udp_server_open(uint16_t port);
+
+/* Socket is readable: drain up to UDP_BATCH datagrams and pass every
+ * frame inside them to `handler`, with `rx` as its context, rx->buf set
+ * to the datagram's pool buffer and rx->peer_addr / peer_port to its
+ * source. Reads
+ * fewer (or none) while the pool is short of buffers. Called from the server event loop. */
+void udp_server_drain(int sock, int64_t now, frame_handler_t handler, network_rx_info_t *rx);
+
+/* Copy out the totals */
+void udp_server_get_stats(udp_server_stats_t *stats);
+
+/* Copy out one sender slot. Returns 0 if the slot is in use, -1 otherwise. */
+int udp_server_get_source(int index, udp_source_stats_t *source);
@@ -0,0 +1,133 @@
+/*
+ * lanes.c
+ * Bulk lane frame queue + per-lane wait statistics
+ *
+ * The queue holds the parsed frame_t and its rx info, not the payload:
+ * the payload stays in its receive buffer, which the queue keeps alive
+ * with one pool reference per entry (rx_pool.h). Only the server task
+ * touches the queue, so there are no atomics.
+ */
+
+#include "lanes.h"
+
+#define WAIT_BUCKETS        32      /* Bucket b holds waits in [2^(b-1), 2^b) us */
+
+_Static_assert((LANES_BULK_QUEUE_DEPTH & (LANES_BULK_QUEUE_DEPTH - 1)) == 0,
+               "LANES_BULK_QUEUE_DEPTH must be a power of two");
+
+typedef struct {
+    frame_t frame;
+    network_rx_info_t rx;
+} bulk_entry_t;
+
+typedef struct {
+    lane_stats_t stats;
+    uint32_t buckets[WAIT_BUCKETS];
+} lane_t;
+
+static bulk_entry_t queue[LANES_BULK_QUEUE_DEPTH];
+static uint32_t head;       /* Next write index (free-running) */
+static uint32_t tail;       /* Next read index (free-running) */
+
+static lane_t lanes[NETWORK_LANE_COUNT];
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static int wait_bucket(int64_t wait_us)
+{
+    if (wait_us <= 0) {
+        return 0;
+    }
+    uint32_t w = wait_us > INT32_MAX ? INT32_MAX : (uint32_t)wait_us;
+    return 32 - __builtin_clz(w);       /* 1..31 */
+}
+
+static uint32_t bucket_percentile(const lane_t *lane, uint32_t permille)
+{
+    uint32_t target = (uint32_t)(((uint64_t)lane->stats.dispatched * permille + 999) / 1000);
+    uint32_t seen = 0;
+
+    for (int b = 0; b < WAIT_BUCKETS; b++) {
+        seen += lane->buckets[b];
+        if (seen >= target && seen > 0) {
+            return b == 0 ? 0 : (1u << b) - 1;
+        }
+    }
+    return lane->stats.max_us;
+}
+
+/* ============================================================
+ * PUBLIC API
+ * ============================================================ */
+bool lanes_push_bulk(const frame_t *frame, const network_rx_info_t *rx)
+{
+    lane_stats_t *stats = &lanes[NETWORK_LANE_BULK].stats;
+    uint32_t queued = head - tail;
+
+    if (queued == LANES_BULK_QUEUE_DEPTH || rx->buf == NULL) {
+        stats->overflows++;
+        return false;
+    }
+
+    bulk_entry_t *entry = &queue[head % LANES_BULK_QUEUE_DEPTH];
+    entry->frame = *frame;
+    entry->rx = *rx;
+    rx_pool_ref(rx->buf);
+    head++;
+    queued++;
+
+    stats->depth = queued;
+    if (queued > stats->max_depth) {
+        stats->max_depth = queued;
+    }
+    return true;
+}
+
+size_t lanes_drain_bulk(size_t max, lanes_dispatch_t dispatch)
+{
+    size_t n = 0;
+
+    while (tail != head && n < max) {
+        bulk_entry_t *entry = &queue[tail % LANES_BULK_QUEUE_DEPTH];
+        tail++;
+
+        dispatch(&entry->frame, &entry->rx);
+        rx_pool_release(entry->rx.buf);
+        n++;
+    }
+
+    lanes[NETWORK_LANE_BULK].stats.depth = head - tail;
+    return n;
+}
+
+bool lanes_bulk_pending(void)
+{
+    return head != tail;
+}
+
+void lanes_record_dispatch(network_lane_t lane, int64_t wait_us)
+{
+    lane_t *l = &lanes[lane];
+
+    l->stats.dispatched++;
+    l->buckets[wait_bucket(wait_us)]++;
+    if (wait_us > (int64_t)l->stats.max_us) {
+        l->stats.max_us = (uint32_t)wait_us;
+    }
+}
+
+void lanes_get_stats(network_lane_t lane, lane_stats_t *out)
+{
+    const lane_t *l = &lanes[lane];
+
+    *out = l->stats;
+    out->p50_us = bucket_percentile(l, 500);
+    out->p99_us = bucket_percentile(l, 990);
+    if (out->p50_us > out->max_us) {
+        out->p50_us = out->max_us;
+    }
+    if (out->p99_us > out->max_us) {
+        out->p99_us = out->max_us;
+    }
+}
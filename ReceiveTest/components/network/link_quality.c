@@ -0,0 +1,235 @@
+/*
+ * link_quality.c
+ * Sequence tracking + inter-arrival jitter, per channel and per connection
+ *
+ * Each channel keeps one sequence window per sender - TCP connection,
+ * or UDP source address + port (every UDP frame shares one connection
+ * id) - so two producers on the same channel never mix their numbers.
+ * A sender the channel has no window for (a reconnect, a move from TCP
+ * to UDP, a new producer) takes over the least recently heard window
+ * and starts it over, rather than reporting thousands of lost or
+ * reordered frames.
+ *
+ * Every entry is updated inside its own seqlock write section; the
+ * getters retry until they copy an entry no write overlapped.
+ */
+
+#include "link_quality.h"
+#include "frame_batch.h"
+#include "seq_window.h"
+#include "seqlock.h"
+
+#include <string.h>
+
+typedef struct {
+    int32_t conn;               /* Sender: connection id, plus for UDP ... */
+    uint32_t addr;              /* ... source address ... */
+    uint16_t port;              /* ... and port (network byte order) */
+    int64_t last_rx_us;         /* For taking over the stalest window */
+    seq_window_t seq;
+} sender_window_t;
+
+typedef struct {
+    atomic_uint lock;
+    sender_window_t senders[LINK_SENDERS_PER_CHANNEL];
+    link_stats_t stats;
+} channel_entry_t;
+
+typedef struct {
+    atomic_uint lock;
+    int32_t conn;
+    bool used;
+    link_stats_t stats;
+} conn_entry_t;
+
+static channel_entry_t channels[LINK_MAX_CHANNELS];
+static channel_entry_t batch_stream;    /* Batch frames number their own stream */
+static conn_entry_t conns[LINK_MAX_CONNS];
+static atomic_uint total_lock;
+static link_stats_t total;
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+
+/* RFC 3550 style: EWMA of the interval and of the deviation from it */
+static void update_timing(link_stats_t *s, int64_t now)
+{
+    if (s->last_rx_us != 0) {
+        int32_t interval = (int32_t)(now - s->last_rx_us);
+        if (s->interval_us == 0) {
+            s->interval_us = (uint32_t)interval;
+        } else {
+            s->interval_us = (uint32_t)((int32_t)s->interval_us +
+                                        (interval - (int32_t)s->interval_us) / 16);
+        }
+        int32_t deviation = interval - (int32_t)s->interval_us;
+        if (deviation < 0) {
+            deviation = -deviation;
+        }
+        s->jitter_us = (uint32_t)((int32_t)s->jitter_us + (deviation - (int32_t)s->jitter_us) / 16);
+    }
+    s->last_rx_us = now;
+}
+
+static conn_entry_t *conn_slot(int32_t conn)
+{
+    int slot = (conn == NETWORK_CONN_UDP) ? LINK_CONN_SLOT_UDP : (conn & 0xFF);
+    if (slot >= LINK_MAX_CONNS || (conn != NETWORK_CONN_UDP && slot == LINK_CONN_SLOT_UDP)) {
+        return NULL;
+    }
+    return &conns[slot];
+}
+
+static channel_entry_t *channel_entry(uint16_t channel)
+{
+    if (channel < LINK_MAX_CHANNELS) {
+        return &channels[channel];
+    }
+    return channel == FRAME_BATCH_CHANNEL ? &batch_stream : NULL;
+}
+
+/* The window of the sender `rx` came from, or a fresh one in place of
+ * the least recently heard (an unused one has last_rx_us 0) */
+static seq_window_t *sender_window(channel_entry_t *ch, const network_rx_info_t *rx)
+{
+    sender_window_t *oldest = &ch->senders[0];
+
+    for (int i = 0; i < LINK_SENDERS_PER_CHANNEL; i++) {
+        sender_window_t *s = &ch->senders[i];
+        if (s->seq.received > 0 && s->conn == rx->conn && s->addr == rx->peer_addr &&
+            s->port == rx->peer_port) {
+            s->last_rx_us = rx->rx_time_us;
+            return &s->seq;
+        }
+        if (s->last_rx_us < oldest->last_rx_us) {
+            oldest = s;
+        }
+    }
+
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->conn = rx->conn;
+    oldest->addr = rx->peer_addr;
+    oldest->port = rx->peer_port;
+    oldest->last_rx_us = rx->rx_time_us;
+    return &oldest->seq;
+}
+
+/* Apply one frame's outcome to a set of counters */
+static void count(link_stats_t *s, bool sequenced, seq_result_t result, int32_t lost_delta)
+{
+    if (result == SEQ_DUPLICATE) {
+        s->duplicates++;
+        return;
+    }
+    s->received++;
+    if (sequenced) {
+        s->sequenced++;
+        s->lost += (uint32_t)lost_delta;
+        if (result == SEQ_LATE) {
+            s->reordered++;
+        }
+    }
+}
+
+/* Copy one entry's stats, retrying until no write overlapped the copy */
+static void read_stats(const atomic_uint *lock, const link_stats_t *stats, link_stats_t *out)
+{
+    unsigned start;
+    do {
+        start = seqlock_read_begin(lock);
+        *out = *stats;
+    } while (seqlock_read_retry(lock, start));
+}
+
+/* ============================================================
+ * PUBLIC API
+ * ============================================================ */
+bool link_quality_record(const frame_t *frame, const network_rx_info_t *rx)
+{
+    bool sequenced = (frame->flags & FRAME_FLAG_SEQ) != 0;
+    seq_result_t result = SEQ_NEXT;
+    int32_t lost_delta = 0;
+
+    channel_entry_t *ch = channel_entry(frame->channel);
+    conn_entry_t *conn = conn_slot(rx->conn);
+    bool untracked = (ch == NULL);
+
+    /* No window to check an untracked channel's numbers against */
+    if (untracked) {
+        sequenced = false;
+    }
+
+    if (ch != NULL) {
+        seqlock_write_begin(&ch->lock);
+        if (sequenced) {
+            seq_window_t *w = sender_window(ch, rx);
+            uint32_t lost_before = w->lost;
+            result = seq_window_track(w, seq_window_unwrap16(w, frame->seq));
+            lost_delta = (int32_t)(w->lost - lost_before);      /* -1 when a gap fills */
+        }
+        count(&ch->stats, sequenced, result, lost_delta);
+        if (result != SEQ_DUPLICATE) {
+            update_timing(&ch->stats, rx->rx_time_us);
+        }
+        seqlock_write_end(&ch->lock);
+    }
+
+    if (conn != NULL) {
+        seqlock_write_begin(&conn->lock);
+        if (!conn->used || conn->conn != rx->conn) {
+            memset(&conn->stats, 0, sizeof(conn->stats));
+            conn->conn = rx->conn;
+            conn->used = true;
+        }
+        count(&conn->stats, sequenced, result, lost_delta);
+        conn->stats.untracked += untracked;
+        if (result != SEQ_DUPLICATE) {
+            update_timing(&conn->stats, rx->rx_time_us);
+        }
+        seqlock_write_end(&conn->lock);
+    }
+
+    seqlock_write_begin(&total_lock);
+    count(&total, sequenced, result, lost_delta);
+    total.untracked += untracked;
+    if (result != SEQ_DUPLICATE) {
+        total.last_rx_us = rx->rx_time_us;
+    }
+    seqlock_write_end(&total_lock);
+
+    return result != SEQ_DUPLICATE;
+}
+
+bool link_quality_get_channel(uint16_t channel, link_stats_t *out)
+{
+    const channel_entry_t *ch = channel_entry(channel);
+    if (ch == NULL) {
+        return false;
+    }
+    read_stats(&ch->lock, &ch->stats, out);
+    return out->last_rx_us != 0;
+}
+
+bool link_quality_get_conn(int slot, int32_t *conn, link_stats_t *out)
+{
+    if (slot < 0 || slot >= LINK_MAX_CONNS) {
+        return false;
+    }
+
+    const conn_entry_t *entry = &conns[slot];
+    unsigned start;
+    bool used;
+    do {
+        start = seqlock_read_begin(&entry->lock);
+        used = entry->used;
+        *conn = entry->conn;
+        *out = entry->stats;
+    } while (seqlock_read_retry(&entry->lock, start));
+    return used;
+}
+
+void link_quality_get_total(link_stats_t *out)
+{
+    read_stats(&total_lock, &total, out);
+}
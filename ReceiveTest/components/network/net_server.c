@@ -0,0 +1,555 @@
+/*
+ * net_server.c
+ * Event-driven TCP + UDP server: one task, select() over all sockets
+ *
+ * Every producer (pit laptop, logger, load generator) gets its own
+ * slot, so frames from different clients never mix. Sockets are
+ * non-blocking, so one slow client can never stall the others.
+ *
+ * Bytes are recv()d straight into rx_pool buffers and frames are decoded
+ * in place (frame_parse_stream), so a payload is never copied between
+ * the socket and the data callback. The one exception is a frame split
+ * across two reads: its head is moved to the front of the next buffer
+ * and the rest is received behind it.
+ *
+ * Parsed frames go through the two ingest lanes from lanes.h: critical
+ * frames reach the data callback immediately, bulk frames are queued
+ * and handed out a slice at a time between socket polls.
+ *
+ * Replies (probe acks, clock sync) are length-prefixed frames too, so a
+ * short non-blocking send() must not lose the tail: it is kept in the
+ * client's tx queue and select() watches the socket for writability
+ * until the queue is empty.
+ */
+
+#include "net_server.h"
+#include "net_socket.h"
+#include "udp_server.h"
+#include "frame.h"
+#include "link_quality.h"
+#include "lanes.h"
+#include "rx_pool.h"
+#include "trace.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "NET_SERVER";
+
+_Static_assert(RX_POOL_BUFFER_SIZE > 2 * FRAME_MAX_SIZE, "pool buffer must hold a partial frame + a read");
+
+/* ============================================================
+ * CLIENT SLOTS
+ * ============================================================ */
+typedef struct {
+    int sock;                   /* -1 when the slot is free */
+    uint32_t generation;        /* Bumped on every accept, part of the connection id */
+    int64_t last_rx_us;         /* For the idle timeout */
+    rx_buf_t *pending;          /* Buffer holding the start of a partial frame, or NULL */
+    uint16_t pending_off;       /* Where the partial frame starts in it */
+    uint16_t pending_len;       /* Bytes of it received so far */
+    frame_parser_stats_t parse_stats;
+    uint32_t peer_addr;         /* IPv4, network byte order */
+    char addr[16];              /* Peer address, for logs */
+    uint16_t tx_len;            /* Reply bytes waiting for the socket */
+    uint8_t tx_queue[NET_TX_QUEUE_SIZE];
+} net_client_t;
+
+static net_client_t clients[NET_MAX_CLIENTS];
+static int listen_sock = -1;
+static int udp_sock = -1;
+static uint16_t tcp_port;
+static uint16_t udp_port;
+static network_data_callback_t data_callback = NULL;
+static network_poll_callback_t poll_callback = NULL;
+static network_data_callback_t frame_tap = NULL;
+static net_server_stats_t stats;
+static int64_t next_stack_check_us;
+
+/* ============================================================
+ * FRAME HANDLER
+ * Called by a parser for every complete frame; `ctx` is the
+ * network_rx_info_t describing the recv() the bytes came from
+ * ============================================================ */
+static void dispatch(const frame_t *frame, const network_rx_info_t *rx)
+{
+    lanes_record_dispatch(rx->lane, esp_timer_get_time() - rx->rx_time_us);
+    if (data_callback != NULL) {
+        data_callback(frame, rx);
+    }
+}
+
+static void on_frame(const frame_t *frame, void *ctx)
+{
+    network_rx_info_t rx = *(const network_rx_info_t *)ctx;
+
+    /* Per-frame logging goes to the trace ring - formatting and
+     * printing it here would cost more than handling the frame */
+    TRACE(NET_FRAME, frame->type, frame->channel, frame->length, rx.conn);
+
+    rx.lane = lanes_classify(frame);
+    if (frame_tap != NULL) {
+        frame_tap(frame, &rx);
+    }
+
+    if (!link_quality_record(frame, &rx)) {
+        return;     /* Duplicate of a sequence number we already handled */
+    }
+
+    if (rx.lane == NETWORK_LANE_CRITICAL) {
+        dispatch(frame, &rx);
+    } else if (!lanes_push_bulk(frame, &rx)) {
+        /* Ring full: empty it first so bulk frames stay in order */
+        lanes_drain_bulk(SIZE_MAX, dispatch);
+        dispatch(frame, &rx);
+    }
+}
+
+/* Connection id = generation << 8 | slot, so a reply for a client that
+ * has gone (and whose slot was reused) is never sent to the new one */
+static int32_t conn_id(const net_client_t *client)
+{
+    return (int32_t)(((client->generation & 0x7FFFFF) << 8) | (uint32_t)(client - clients));
+}
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static void set_nonblocking(int sock)
+{
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void close_client(net_client_t *client, const char *reason)
+{
+    ESP_LOGI(TAG, "Client %s closed (%s): %lu frames, %lu CRC errors, %lu bad headers, %lu bytes skipped",
+             client->addr, reason,
+             (unsigned long)client->parse_stats.frames,
+             (unsigned long)client->parse_stats.crc_errors,
+             (unsigned long)client->parse_stats.bad_headers,
+             (unsigned long)client->parse_stats.bytes_skipped);
+
+    rx_pool_release(client->pending);
+    client->pending = NULL;
+    stats.clients_active--;
+    close(client->sock);
+    client->sock = -1;
+}
+
+static int open_listener(uint16_t port)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket");
+        return -1;
+    }
+
+    /* Allow socket reuse (helps with quick restarts) */
+    int opt = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = htonl(INADDR_ANY);   /* Accept from any interface */
+    server_addr.sin_port = htons(port);
+
+    if (bind(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        ESP_LOGE(TAG, "Failed to bind port %d", port);
+        close(sock);
+        return -1;
+    }
+
+    if (listen(sock, NET_MAX_CLIENTS) < 0) {
+        ESP_LOGE(TAG, "Failed to listen");
+        close(sock);
+        return -1;
+    }
+
+    set_nonblocking(sock);
+    return sock;
+}
+
+/* ============================================================
+ * EVENT HANDLERS
+ * ============================================================ */
+
+/* Listener is readable: accept everything that is waiting */
+static void accept_clients(int64_t now)
+{
+    while (1) {
+        struct sockaddr_in client_addr;
+        socklen_t addr_len = sizeof(client_addr);
+        int sock = accept(listen_sock, (struct sockaddr *)&client_addr, &addr_len);
+        if (sock < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "Failed to accept connection (errno %d)", errno);
+            }
+            return;
+        }
+
+        net_client_t *client = NULL;
+        for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+            if (clients[i].sock < 0) {
+                client = &clients[i];
+                break;
+            }
+        }
+
+        if (client == NULL) {
+            ESP_LOGW(TAG, "Rejecting %s: all %d client slots busy",
+                     inet_ntoa(client_addr.sin_addr), NET_MAX_CLIENTS);
+            stats.rejected++;
+            close(sock);
+            continue;
+        }
+
+        set_nonblocking(sock);
+        client->sock = sock;
+        client->generation++;
+        client->last_rx_us = now;
+        client->pending = NULL;
+        client->pending_len = 0;
+        client->tx_len = 0;
+        memset(&client->parse_stats, 0, sizeof(client->parse_stats));
+        client->peer_addr = client_addr.sin_addr.s_addr;
+        strncpy(client->addr, inet_ntoa(client_addr.sin_addr), sizeof(client->addr) - 1);
+        client->addr[sizeof(client->addr) - 1] = '\0';
+
+        stats.accepted++;
+        stats.clients_active++;
+        ESP_LOGI(TAG, "Client connected from %s (%lu active)",
+                 client->addr, (unsigned long)stats.clients_active);
+    }
+}
+
+/* A pool buffer for the next read. If the pool is dry, the bulk queue
+ * is what holds most references - dispatch it and try again. */
+static rx_buf_t *get_rx_buffer(void)
+{
+    rx_buf_t *buf = rx_pool_get();
+    if (buf == NULL && lanes_bulk_pending()) {
+        lanes_drain_bulk(SIZE_MAX, dispatch);
+        buf = rx_pool_get();
+    }
+    return buf;
+}
+
+/* Client socket is readable: recv() into a pool buffer (behind any
+ * partial frame left from the last read) and decode it in place */
+static void service_client(net_client_t *client, int64_t now)
+{
+    rx_buf_t *buf = get_rx_buffer();
+    if (buf == NULL) {
+        return;     /* Leave the bytes in the socket - the next pass waits for buffers */
+    }
+
+    size_t have = 0;
+    if (client->pending != NULL) {
+        have = client->pending_len;
+        memcpy(buf->data, client->pending->data + client->pending_off, have);
+        rx_pool_release(client->pending);
+        client->pending = NULL;
+    }
+
+    int len = recv(client->sock, buf->data + have, sizeof(buf->data) - have, 0);
+    if (len > 0) {
+        client->last_rx_us = now;
+        stats.bytes += len;
+
+        network_rx_info_t rx = {
+            .rx_time_us = now,
+            .conn = conn_id(client),
+            .buf = buf,
+            .peer_addr = client->peer_addr,
+        };
+        uint32_t crc_before = client->parse_stats.crc_errors;
+        size_t used;
+        stats.frames += frame_parse_stream(buf->data, have + (size_t)len, on_frame, &rx,
+                                           &client->parse_stats, &used);
+        stats.crc_errors += client->parse_stats.crc_errors - crc_before;
+
+        /* A partial frame is always shorter than FRAME_MAX_SIZE
+         * (frame_parse_stream only stops at a valid header) */
+        have = have + (size_t)len - used;
+        if (have > 0) {
+            client->pending = buf;
+            client->pending_off = (uint16_t)used;
+            client->pending_len = (uint16_t)have;
+            return;
+        }
+        rx_pool_release(buf);
+        return;
+    }
+
+    if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        if (have > 0) {         /* Nothing new: keep the partial frame */
+            client->pending = buf;
+            client->pending_off = 0;
+            client->pending_len = (uint16_t)have;
+        } else {
+            rx_pool_release(buf);
+        }
+        return;
+    }
+
+    rx_pool_release(buf);
+    close_client(client, len == 0 ? "disconnected" : "receive error");
+}
+
+/* Socket is writable again: send what is queued. Returns false if the
+ * connection failed (the caller closes it). */
+static bool flush_client(net_client_t *client)
+{
+    while (client->tx_len > 0) {
+        int n = send(client->sock, client->tx_queue, client->tx_len, MSG_DONTWAIT);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        client->tx_len -= (uint16_t)n;
+        memmove(client->tx_queue, client->tx_queue + n, client->tx_len);
+    }
+    return true;
+}
+
+/* Drop clients that have gone quiet (unplugged cable, crashed sender) */
+static void close_idle_clients(int64_t now)
+{
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        if (clients[i].sock >= 0 &&
+            now - clients[i].last_rx_us > (int64_t)NET_IDLE_TIMEOUT_MS * 1000) {
+            stats.idle_closed++;
+            close_client(&clients[i], "idle");
+        }
+    }
+}
+
+/* Everything frames reach runs on this task's stack (parser, link
+ * quality, the data and poll callbacks down to the store, history,
+ * alarms and recorder), so keep an eye on how much of it is left */
+static void check_stack(int64_t now)
+{
+    if (now < next_stack_check_us) {
+        return;
+    }
+    next_stack_check_us = now + (int64_t)NET_STACK_CHECK_MS * 1000;
+
+    uint32_t free_bytes = (uint32_t)uxTaskGetStackHighWaterMark(NULL);
+    if (free_bytes < stats.stack_free_min) {
+        if (stats.stack_free_min >= NET_STACK_MARGIN && free_bytes < NET_STACK_MARGIN) {
+            ESP_LOGW(TAG, "Server task stack: only %lu of %d bytes left free",
+                     (unsigned long)free_bytes, NET_TASK_STACK_SIZE);
+        }
+        stats.stack_free_min = free_bytes;
+    }
+}
+
+/* ============================================================
+ * SERVER TASK
+ * ============================================================ */
+static void net_server_task(void *pvParameters)
+{
+    (void)pvParameters;
+
+    ESP_LOGI(TAG, "Starting TCP server on port %d", tcp_port);
+
+    listen_sock = open_listener(tcp_port);
+    if (listen_sock < 0) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Listening on port %d for up to %d clients", tcp_port, NET_MAX_CLIENTS);
+
+    /* UDP is optional - keep serving TCP if it fails */
+    udp_sock = udp_server_open(udp_port);
+
+    while (1) {
+        fd_set read_fds, write_fds;
+        FD_ZERO(&read_fds);
+        FD_ZERO(&write_fds);
+        FD_SET(listen_sock, &read_fds);
+        int max_fd = listen_sock;
+
+        /* Every buffer held by another task and nothing on the bulk lane
+         * to dispatch: a readable socket could not be read, and select()
+         * would report it again at once - a busy loop. Leave the
+         * receive sockets out and recheck the pool shortly; their bytes
+         * wait in the stack (TCP back-pressure / the UDP queue). */
+        bool pool_dry = rx_pool_available() == 0 && !lanes_bulk_pending();
+        if (pool_dry) {
+            stats.pool_stalls++;
+        }
+
+        if (udp_sock >= 0 && !pool_dry) {
+            FD_SET(udp_sock, &read_fds);
+            if (udp_sock > max_fd) {
+                max_fd = udp_sock;
+            }
+        }
+
+        for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+            if (clients[i].sock >= 0) {
+                if (!pool_dry) {
+                    FD_SET(clients[i].sock, &read_fds);
+                }
+                if (clients[i].tx_len > 0) {
+                    FD_SET(clients[i].sock, &write_fds);
+                }
+                if (clients[i].sock > max_fd) {
+                    max_fd = clients[i].sock;
+                }
+            }
+        }
+
+        /* With bulk frames queued, only check the sockets (so critical
+         * frames are picked up between slices) - do not sleep */
+        struct timeval timeout = { 0 };
+        if (pool_dry) {
+            timeout.tv_usec = NET_POOL_RETRY_MS * 1000;
+        } else if (!lanes_bulk_pending()) {
+            timeout.tv_sec = NET_POLL_INTERVAL_MS / 1000;
+            timeout.tv_usec = (NET_POLL_INTERVAL_MS % 1000) * 1000;
+        }
+
+        /* Sleep until any socket has data (or the timeout passes) */
+        int ready = select(max_fd + 1, &read_fds, &write_fds, NULL, &timeout);
+        if (ready < 0) {
+            if (errno != EINTR) {
+                ESP_LOGE(TAG, "select() failed (errno %d)", errno);
+                vTaskDelay(pdMS_TO_TICKS(100));
+            }
+            continue;
+        }
+
+        int64_t now = esp_timer_get_time();
+
+        if (ready > 0) {
+            if (FD_ISSET(listen_sock, &read_fds)) {
+                accept_clients(now);
+            }
+            if (udp_sock >= 0 && FD_ISSET(udp_sock, &read_fds)) {
+                if (rx_pool_available() < UDP_BATCH && lanes_bulk_pending()) {
+                    lanes_drain_bulk(SIZE_MAX, dispatch);   /* Free buffers for a full batch */
+                }
+                network_rx_info_t rx = { .rx_time_us = now, .conn = NETWORK_CONN_UDP };
+                udp_server_drain(udp_sock, now, on_frame, &rx);
+            }
+            for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+                if (clients[i].sock >= 0 && FD_ISSET(clients[i].sock, &write_fds) &&
+                    !flush_client(&clients[i])) {
+                    close_client(&clients[i], "send error");
+                }
+                if (clients[i].sock >= 0 && FD_ISSET(clients[i].sock, &read_fds)) {
+                    service_client(&clients[i], now);
+                }
+            }
+        }
+
+        lanes_drain_bulk(NET_BULK_SLICE, dispatch);
+
+        close_idle_clients(now);
+
+        if (poll_callback != NULL) {
+            poll_callback();
+        }
+
+        check_stack(now);
+
+        /* A task that cannot run (flash erase with the cache off) shows
+         * up as one long pass */
+        uint32_t pass_us = (uint32_t)(esp_timer_get_time() - now);
+        if (pass_us > stats.pass_max_us) {
+            stats.pass_max_us = pass_us;
+        }
+    }
+}
+
+/* ============================================================
+ * PUBLIC API
+ * ============================================================ */
+esp_err_t net_server_start(uint16_t tcp, uint16_t udp, network_data_callback_t callback,
+                           network_poll_callback_t poll)
+{
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        clients[i].sock = -1;
+    }
+    memset(&stats, 0, sizeof(stats));
+    stats.stack_free_min = NET_TASK_STACK_SIZE;
+    next_stack_check_us = 0;
+    tcp_port = tcp;
+    udp_port = udp;
+    data_callback = callback;
+    poll_callback = poll;
+
+    if (xTaskCreate(net_server_task, "net_server", NET_TASK_STACK_SIZE, NULL,
+                    NET_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create server task");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void net_server_set_frame_tap(network_data_callback_t tap)
+{
+    frame_tap = tap;
+}
+
+int net_server_send(int32_t conn, const void *data, size_t len)
+{
+    if (conn < 0 || (conn & 0xFF) >= NET_MAX_CLIENTS) {
+        return -1;
+    }
+
+    net_client_t *client = &clients[conn & 0xFF];
+    if (client->sock < 0 || conn_id(client) != conn) {
+        return -1;
+    }
+
+    /* Room for all of it in the queue, whatever send() takes - so the
+     * frame either goes out whole or not at all */
+    if (len > sizeof(client->tx_queue) - client->tx_len) {
+        stats.tx_dropped++;
+        return -1;
+    }
+
+    size_t sent = 0;
+    if (client->tx_len == 0) {          /* Nothing queued ahead of it: try right away */
+        int n = send(client->sock, data, len, MSG_DONTWAIT);
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return -1;                  /* Broken: recv() will see it and close the client */
+        }
+        sent = n > 0 ? (size_t)n : 0;
+    }
+
+    if (sent < len) {
+        memcpy(client->tx_queue + client->tx_len, (const uint8_t *)data + sent, len - sent);
+        client->tx_len += (uint16_t)(len - sent);
+        stats.tx_queued++;
+    }
+    return (int)len;
+}
+
+int32_t net_server_find_conn(uint32_t peer_addr)
+{
+    const net_client_t *best = NULL;
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        const net_client_t *client = &clients[i];
+        if (client->sock >= 0 && client->peer_addr == peer_addr &&
+            (best == NULL || client->last_rx_us > best->last_rx_us)) {
+            best = client;
+        }
+    }
+    return best != NULL ? conn_id(best) : NETWORK_CONN_UDP;
+}
+
+void net_server_get_stats(net_server_stats_t *out)
+{
+    /* Plain copy - counters are only written by the server task, a
+     * torn read just gives a slightly stale number */
+    *out = stats;
+}
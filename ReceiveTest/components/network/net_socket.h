@@ -0,0 +1,19 @@
+/*
+ * net_socket.h
+ * Picks the socket headers for the platform we are building for.
+ * lwIP exposes the BSD API, so the server code is identical on both.
+ */
+#pragma once
+
+#ifdef ESP_PLATFORM
+#include "lwip/sockets.h"
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <errno.h>
@@ -1,12 +1,15 @@
 /*
  * network.c
  * Ethernet initialization with static IP + TCP server
+ * (the server event loop itself lives in net_server.c)
  *
  * Static IP: 192.168.1.100
  * TCP Port: 5000
+ * UDP Port: 5001
  */
 
 #include "network.h"
+#include "net_server.h"
 
 #include <string.h>
 #include "freertos/FreeRTOS.h"
@@ -16,9 +19,6 @@
 #include "esp_netif.h"
 #include "esp_eth.h"
 
-/* For TCP sockets */
-#include "lwip/sockets.h"
-
 static const char *TAG = "NETWORK";
 
 /* ============================================================
@@ -28,13 +28,12 @@ static const char *TAG = "NETWORK";
 #define STATIC_GATEWAY  "192.168.1.1"     /* Your laptop's IP */
 #define STATIC_NETMASK  "255.255.255.0"   /* Subnet mask */
 #define TCP_PORT        5000               /* Port to listen on */
-#define RX_BUFFER_SIZE  128                /* Max message size */
+#define UDP_PORT        5001               /* Port for high-rate datagrams */
 
 /* ============================================================
  * GLOBAL STATE
  * ============================================================ */
 static char ip_address_str[16] = "0.0.0.0";
-static network_data_callback_t data_callback = NULL;
 static esp_netif_t *eth_netif = NULL;
 
 /* ============================================================
@@ -80,108 +79,14 @@ static void ip_event_handler(void *arg, esp_event_base_t event_base,
     }
 }
 
-/* ============================================================
- * TCP SERVER TASK
- * Runs in background, accepts connections, receives data
- * ============================================================ */
-static void tcp_server_task(void *pvParameters)
-{
-    char rx_buffer[RX_BUFFER_SIZE];
-    int listen_sock, client_sock;
-    struct sockaddr_in server_addr, client_addr;
-    socklen_t addr_len = sizeof(client_addr);
-
-    ESP_LOGI(TAG, "Starting TCP server on port %d", TCP_PORT);
-
-    /* Create socket */
-    listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (listen_sock < 0) {
-        ESP_LOGE(TAG, "Failed to create socket");
-        vTaskDelete(NULL);
-        return;
-    }
-
-    /* Allow socket reuse (helps with quick restarts) */
-    int opt = 1;
-    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-    /* Bind to our IP and port */
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;  /* Accept from any interface */
-    server_addr.sin_port = htons(TCP_PORT);
-
-    if (bind(listen_sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        ESP_LOGE(TAG, "Failed to bind socket");
-        close(listen_sock);
-        vTaskDelete(NULL);
-        return;
-    }
-
-    /* Start listening (queue up to 1 connection) */
-    if (listen(listen_sock, 1) < 0) {
-        ESP_LOGE(TAG, "Failed to listen");
-        close(listen_sock);
-        vTaskDelete(NULL);
-        return;
-    }
-
-    ESP_LOGI(TAG, "TCP server listening on %s:%d", ip_address_str, TCP_PORT);
-
-    /* Main server loop */
-    while (1) {
-        ESP_LOGI(TAG, "Waiting for client connection...");
-
-        /* Accept incoming connection (blocks until someone connects) */
-        client_sock = accept(listen_sock, (struct sockaddr *)&client_addr, &addr_len);
-        if (client_sock < 0) {
-            ESP_LOGE(TAG, "Failed to accept connection");
-            continue;
-        }
-
-        ESP_LOGI(TAG, "Client connected from %s",
-                 inet_ntoa(client_addr.sin_addr));
-
-        /* Receive data from this client until they disconnect */
-        while (1) {
-            int len = recv(client_sock, rx_buffer, RX_BUFFER_SIZE - 1, 0);
-
-            if (len < 0) {
-                ESP_LOGE(TAG, "Receive error");
-                break;
-            } else if (len == 0) {
-                ESP_LOGI(TAG, "Client disconnected");
-                break;
-            } else {
-                /* Null-terminate the received string */
-                rx_buffer[len] = '\0';
-
-                ESP_LOGI(TAG, "Received: %s", rx_buffer);
-
-                /* Call the callback function to handle the data */
-                if (data_callback != NULL) {
-                    data_callback(rx_buffer, len);
-                }
-            }
-        }
-
-        close(client_sock);
-    }
-
-    close(listen_sock);
-    vTaskDelete(NULL);
-}
-
 /* ============================================================
  * ETHERNET INITIALIZATION
  * Sets up the hardware, static IP, and starts TCP server
  * ============================================================ */
-esp_err_t network_init(network_data_callback_t callback)
+esp_err_t network_init(network_data_callback_t callback, network_poll_callback_t poll)
 {
     ESP_LOGI(TAG, "Initializing Ethernet with static IP: %s", STATIC_IP);
 
-    /* Save the callback function */
-    data_callback = callback;
-
     /* Initialize TCP/IP stack */
     ESP_ERROR_CHECK(esp_netif_init());
 
@@ -243,9 +148,9 @@ esp_err_t network_init(network_data_callback_t callback)
     ESP_ERROR_CHECK(esp_eth_start(eth_handle));
 
     /* --------------------------------------------------------
-     * Start TCP server in a background task
+     * Start TCP + UDP server in a background task
      * -------------------------------------------------------- */
-    xTaskCreate(tcp_server_task, "tcp_server", 4096, NULL, 5, NULL);
+    ESP_ERROR_CHECK(net_server_start(TCP_PORT, UDP_PORT, callback, poll));
 
     ESP_LOGI(TAG, "Network initialization complete");
     return ESP_OK;
@@ -0,0 +1,73 @@
+/*
+ * rx_pool.c
+ * Receive buffer pool: static storage + a one-word free bitmap
+ *
+ * Bit i of `free_bits` is set while buffer i is free. The server task
+ * claims a buffer by clearing its bit; whichever task drops the last
+ * reference sets it again. Both are single atomic operations, so no
+ * task ever blocks on the pool.
+ */
+
+#include "rx_pool.h"
+
+_Static_assert(RX_POOL_BUFFERS <= 32, "free bitmap is one 32-bit word");
+
+static rx_buf_t pool[RX_POOL_BUFFERS];
+static atomic_uint free_bits = (RX_POOL_BUFFERS == 32) ? 0xFFFFFFFFu
+                                                       : (1u << RX_POOL_BUFFERS) - 1;
+static atomic_uint in_use;
+static rx_pool_stats_t stats;   /* Server task only, except in_use */
+
+/* ============================================================
+ * PUBLIC API
+ * ============================================================ */
+rx_buf_t *rx_pool_get(void)
+{
+    unsigned bits = atomic_load_explicit(&free_bits, memory_order_acquire);
+
+    do {
+        if (bits == 0) {
+            stats.exhausted++;
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&free_bits, &bits, bits & (bits - 1),
+                                                    memory_order_acquire,
+                                                    memory_order_acquire));
+
+    int index = __builtin_ctz(bits);
+    rx_buf_t *buf = &pool[index];
+    buf->index = (uint8_t)index;
+    atomic_store_explicit(&buf->refs, 1, memory_order_relaxed);
+
+    unsigned used = atomic_fetch_add_explicit(&in_use, 1, memory_order_relaxed) + 1;
+    if (used > stats.high_water) {
+        stats.high_water = used;
+    }
+    stats.gets++;
+    return buf;
+}
+
+void rx_pool_release(rx_buf_t *buf)
+{
+    if (buf == NULL) {
+        return;
+    }
+
+    /* acq_rel: everything the last holder read from the buffer happens
+     * before the server task recv()s into it again */
+    if (atomic_fetch_sub_explicit(&buf->refs, 1, memory_order_acq_rel) == 1) {
+        atomic_fetch_sub_explicit(&in_use, 1, memory_order_relaxed);
+        atomic_fetch_or_explicit(&free_bits, 1u << buf->index, memory_order_release);
+    }
+}
+
+uint32_t rx_pool_available(void)
+{
+    return RX_POOL_BUFFERS - atomic_load_explicit(&in_use, memory_order_relaxed);
+}
+
+void rx_pool_get_stats(rx_pool_stats_t *out)
+{
+    *out = stats;
+    out->in_use = atomic_load_explicit(&in_use, memory_order_relaxed);
+}
@@ -0,0 +1,228 @@
+/*
+ * udp_server.c
+ * UDP datagram ingest: batched draining + per-sender sequence tracking
+ *
+ * The socket is serviced from the same event loop as the TCP clients
+ * (net_server.c) and frames go to the same callback, so the rest of the
+ * firmware does not care which transport a sample came in on.
+ *
+ * Each datagram is received straight into its own rx_pool buffer and
+ * its frames are decoded in place.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     /* recvmmsg() */
+#endif
+
+#include "udp_server.h"
+#include "net_socket.h"
+
+#include <string.h>
+#include "esp_log.h"
+
+static const char *TAG = "UDP_SERVER";
+
+_Static_assert(UDP_MAX_DATAGRAM <= RX_POOL_BUFFER_SIZE, "a datagram must fit one pool buffer");
+
+static udp_source_stats_t sources[UDP_MAX_SOURCES];
+static udp_server_stats_t stats;
+
+/* ============================================================
+ * SOCKET SETUP
+ * ============================================================ */
+int udp_server_open(uint16_t port)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket");
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "Failed to bind port %d", port);
+        close(sock);
+        return -1;
+    }
+
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+
+    memset(sources, 0, sizeof(sources));
+    memset(&stats, 0, sizeof(stats));
+
+    ESP_LOGI(TAG, "Listening for datagrams on port %d", port);
+    return sock;
+}
+
+/* ============================================================
+ * SEQUENCE TRACKING
+ * ============================================================ */
+
+/* Find the slot for a sender, or take over the least recently seen one */
+static udp_source_stats_t *lookup_source(const struct sockaddr_in *from)
+{
+    udp_source_stats_t *oldest = &sources[0];
+
+    for (int i = 0; i < UDP_MAX_SOURCES; i++) {
+        udp_source_stats_t *src = &sources[i];
+        if (src->addr == from->sin_addr.s_addr && src->port == from->sin_port &&
+            src->seq.received > 0) {
+            return src;
+        }
+        if (src->last_seen_us < oldest->last_seen_us) {
+            oldest = src;
+        }
+    }
+
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->addr = from->sin_addr.s_addr;
+    oldest->port = from->sin_port;
+    return oldest;
+}
+
+/* Classify one sequence number and keep the totals in step with the
+ * sender's counters. Returns -1 for a duplicate. */
+static int track_sequence(udp_source_stats_t *src, uint32_t seq)
+{
+    uint32_t lost_before = src->seq.lost;
+    seq_result_t result = seq_window_track(&src->seq, seq);
+
+    stats.lost += src->seq.lost - lost_before;      /* May go down: late arrival */
+    switch (result) {
+        case SEQ_DUPLICATE:
+            stats.duplicates++;
+            return -1;
+        case SEQ_LATE:
+            stats.reordered++;
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+/* ============================================================
+ * DATAGRAM HANDLING
+ * ============================================================ */
+static void handle_datagram(const uint8_t *data, size_t len, const struct sockaddr_in *from,
+                            int64_t now, frame_handler_t handler, void *ctx)
+{
+    stats.datagrams++;
+
+    if (len < UDP_DGRAM_HEADER_SIZE || data[0] != UDP_DGRAM_MAGIC ||
+        data[1] != UDP_DGRAM_VERSION) {
+        stats.bad_datagrams++;
+        return;
+    }
+
+    udp_source_stats_t *src = lookup_source(from);
+    src->last_seen_us = now;
+    if (track_sequence(src, frame_read_u32(data + 4)) < 0) {
+        return;
+    }
+
+    frame_parser_stats_t frame_stats = {0};
+    frame_parse_buffer(data + UDP_DGRAM_HEADER_SIZE, len - UDP_DGRAM_HEADER_SIZE,
+                       handler, ctx, &frame_stats);
+    stats.frames += frame_stats.frames;
+    stats.frame_errors += frame_stats.crc_errors + frame_stats.bad_headers;
+}
+
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+
+/* Linux: one recvmmsg() syscall pulls the whole batch */
+void udp_server_drain(int sock, int64_t now, frame_handler_t handler, network_rx_info_t *rx)
+{
+    struct mmsghdr msgs[UDP_BATCH];
+    struct iovec iovs[UDP_BATCH];
+    struct sockaddr_in from[UDP_BATCH];
+    rx_buf_t *bufs[UDP_BATCH];
+    int n = 0;
+
+    memset(msgs, 0, sizeof(msgs));
+    while (n < UDP_BATCH && (bufs[n] = rx_pool_get()) != NULL) {
+        iovs[n].iov_base = bufs[n]->data;
+        iovs[n].iov_len = UDP_MAX_DATAGRAM;
+        msgs[n].msg_hdr.msg_iov = &iovs[n];
+        msgs[n].msg_hdr.msg_iovlen = 1;
+        msgs[n].msg_hdr.msg_name = &from[n];
+        msgs[n].msg_hdr.msg_namelen = sizeof(from[n]);
+        n++;
+    }
+
+    int count = n > 0 ? recvmmsg(sock, msgs, (unsigned)n, MSG_DONTWAIT, NULL) : 0;
+    if (count > 0) {
+        stats.batches++;
+    }
+    for (int i = 0; i < n; i++) {
+        if (i < count) {
+            rx->buf = bufs[i];
+            rx->peer_addr = from[i].sin_addr.s_addr;
+            rx->peer_port = from[i].sin_port;
+            handle_datagram(bufs[i]->data, msgs[i].msg_len, &from[i], now, handler, rx);
+        }
+        rx_pool_release(bufs[i]);     /* Queued frames hold their own reference */
+    }
+    rx->buf = NULL;
+}
+
+#else
+
+/* lwIP has no recvmmsg(): drain with non-blocking recvfrom() until the
+ * socket is empty or the batch is full */
+void udp_server_drain(int sock, int64_t now, frame_handler_t handler, network_rx_info_t *rx)
+{
+    int count = 0;
+
+    while (count < UDP_BATCH) {
+        rx_buf_t *buf = rx_pool_get();
+        if (buf == NULL) {
+            break;
+        }
+
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(sock, buf->data, UDP_MAX_DATAGRAM, MSG_DONTWAIT,
+                           (struct sockaddr *)&from, &from_len);
+        if (len >= 0) {
+            rx->buf = buf;
+            rx->peer_addr = from.sin_addr.s_addr;
+            rx->peer_port = from.sin_port;
+            handle_datagram(buf->data, len, &from, now, handler, rx);
+            count++;
+        }
+        rx_pool_release(buf);       /* Queued frames hold their own reference */
+        if (len < 0) {
+            break;
+        }
+    }
+    rx->buf = NULL;
+
+    if (count > 0) {
+        stats.batches++;
+    }
+}
+
+#endif
+
+/* ============================================================
+ * STATS
+ * ============================================================ */
+void udp_server_get_stats(udp_server_stats_t *out)
+{
+    *out = stats;
+}
+
+int udp_server_get_source(int index, udp_source_stats_t *source)
+{
+    if (index < 0 || index >= UDP_MAX_SOURCES || sources[index].seq.received == 0) {
+        return -1;
+    }
+    *source = sources[index];
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * recorder.h
+ * Flight recorder: every received frame, as it arrived, to flash
+ *
+ * The server task appends every frame the parser delivers (wire bytes +
+ * rx time, source and lane) to a block in a PSRAM staging ring. It
+ * taps the stream before duplicates are dropped and before the lanes
+ * reorder anything (net_server_set_frame_tap), so a recording is the
+ * link exactly as it arrived. Full blocks -
+ * and blocks left open longer than RECORDER_FLUSH_MS - are handed to
+ * the recorder task, which erases one sector and writes the block to
+ * the "recorder" data partition. Flash erase/write never runs on the
+ * server task; if flash falls behind and the staging ring fills up,
+ * frames are dropped from the recording (counted) rather than holding
+ * up the network.
+ *
+ * The partition is a ring: once full, the oldest block is overwritten.
+ * The block headers are kept in RAM as a seek index
+ * (recorder_find_block). On-flash layout: recorder_format.h. Recordings
+ * are turned back into a frame stream by tools/recextract.
+ *
+ * On the host build the partition is a file (receivetest_host -r).
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "frame.h"
+#include "network.h"
+#include "recorder_format.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define RECORDER_PARTITION_LABEL    "recorder"
+#define RECORDER_PARTITION_SUBTYPE  0x40    /* Custom data subtype, see partitions.csv */
+#define RECORDER_STAGING_BLOCKS     16      /* 64 KB of PSRAM between the server and flash */
+#define RECORDER_FLUSH_MS           2000    /* Most a frame waits in an open block */
+
+/* Counters since boot (read with recorder_get_stats) */
+typedef struct {
+    uint32_t frames;            /* Frames written into staging blocks */
+    uint32_t dropped;           /* Frames lost because the staging ring was full */
+    uint32_t blocks;            /* Blocks written to flash */
+    uint32_t write_errors;      /* Blocks flash refused (erase or write failed) */
+    uint32_t staged_max;        /* Most blocks ever waiting for flash at once */
+    uint32_t write_max_us;      /* Slowest erase + write of one block */
+    uint32_t slots;             /* Blocks the partition holds */
+    uint16_t session;           /* This boot's session number */
+} recorder_stats_t;
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Find the partition, read the block headers into the seek index (and
+ * so find where the last boot stopped), allocate the staging ring and
+ * start the recorder task. Returns
+ * ESP_ERR_NOT_FOUND without a partition - recording is then off and
+ * the other calls do nothing. */
+esp_err_t recorder_init(void);
+
+/* Append one frame. Server task only - installed as the server's frame
+ * tap, see net_server_set_frame_tap(). */
+void recorder_record(const frame_t *frame, const network_rx_info_t *rx);
+
+/* Hand the open block to flash once it has been open RECORDER_FLUSH_MS.
+ * Server task only (poll callback). */
+void recorder_poll(int64_t now);
+
+/* Seek: the oldest block of `session` whose last frame is at or after
+ * `t_us` (esp_timer time of that session's boot) - where reading from
+ * `t_us` starts; for a time before the session's first kept frame,
+ * its first kept block. Returns false if the session ends before `t_us`
+ * or the recording holds none of it. Binary search of the in-RAM
+ * index, no flash access; any task. */
+bool recorder_find_block(uint16_t session, int64_t t_us, recorder_block_t *block);
+
+/* Copy out the counters */
+void recorder_get_stats(recorder_stats_t *stats);
@@ -0,0 +1,149 @@
+/*
+ * recorder_format.h
+ * On-flash layout of a flight recording (shared with tools/recextract)
+ *
+ * A recording is a ring of RECORDER_BLOCK_SIZE blocks, one flash sector
+ * each. Block `seq` (counting every block ever written) lives in slot
+ * seq % slot_count, so the oldest block is the one after the newest.
+ * Erased slots read as all 0xFF and fail the magic check.
+ *
+ * Block header (little-endian):
+ *
+ *   offset  size  field
+ *   0       4     magic     (RECORDER_MAGIC)
+ *   4       2     version   (RECORDER_VERSION)
+ *   6       2     header size
+ *   8       4     seq
+ *   12      2     session   (+1 every boot, tells esp_timer epochs apart)
+ *   14      2     records
+ *   16      2     used      (header + records, bytes)
+ *   18      2     crc       (CRC-16/CCITT-FALSE over the records)
+ *   20      4     reserved
+ *   24      8     first_us  (rx time of the first record, esp_timer)
+ *   32      8     last_us   (rx time of the last record)
+ *
+ * The headers are the seek index: every block says which session and
+ * time span it covers, so finding a moment is a binary search over
+ * 40-byte reads instead of a scan of the whole recording
+ * (recorder_seek below, used on the board and by tools/recextract).
+ *
+ * Records follow back to back:
+ *
+ *   0       4     dt_us     (rx time - first_us)
+ *   4       2     length    (bytes of the wire frame that follows)
+ *   6       1     source    (TCP client slot, RECORDER_SOURCE_UDP for UDP)
+ *   7       1     lane      (network_lane_t it was classified into)
+ *   8       N     the frame exactly as received (frame.h wire format)
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "frame.h"
+
+/* ============================================================
+ * CONSTANTS
+ * ============================================================ */
+#define RECORDER_BLOCK_SIZE         4096    /* One flash erase sector */
+#define RECORDER_MAGIC              0x31435254u     /* "TRC1" */
+#define RECORDER_VERSION            1
+#define RECORDER_HEADER_SIZE        40
+#define RECORDER_RECORD_HEADER_SIZE 8
+#define RECORDER_SOURCE_UDP         0xFF
+
+/* Decoded block header */
+typedef struct {
+    uint32_t seq;
+    uint16_t session;
+    uint16_t records;
+    uint16_t used;
+    uint16_t crc;
+    int64_t first_us;
+    int64_t last_us;
+} recorder_block_t;
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static inline void recorder_write_header(uint8_t *block, const recorder_block_t *h)
+{
+    frame_write_u32(block + 0, RECORDER_MAGIC);
+    frame_write_u16(block + 4, RECORDER_VERSION);
+    frame_write_u16(block + 6, RECORDER_HEADER_SIZE);
+    frame_write_u32(block + 8, h->seq);
+    frame_write_u16(block + 12, h->session);
+    frame_write_u16(block + 14, h->records);
+    frame_write_u16(block + 16, h->used);
+    frame_write_u16(block + 18, h->crc);
+    frame_write_u32(block + 20, 0);
+    frame_write_u64(block + 24, (uint64_t)h->first_us);
+    frame_write_u64(block + 32, (uint64_t)h->last_us);
+}
+
+/* Returns false for an erased or foreign block (the CRC is not checked
+ * here - that needs the whole block) */
+static inline bool recorder_read_header(const uint8_t *block, recorder_block_t *h)
+{
+    if (frame_read_u32(block) != RECORDER_MAGIC || frame_read_u16(block + 4) != RECORDER_VERSION ||
+        frame_read_u16(block + 6) != RECORDER_HEADER_SIZE) {
+        return false;
+    }
+    h->seq = frame_read_u32(block + 8);
+    h->session = frame_read_u16(block + 12);
+    h->records = frame_read_u16(block + 14);
+    h->used = frame_read_u16(block + 16);
+    h->crc = frame_read_u16(block + 18);
+    h->first_us = (int64_t)frame_read_u64(block + 24);
+    h->last_us = (int64_t)frame_read_u64(block + 32);
+    return h->used >= RECORDER_HEADER_SIZE && h->used <= RECORDER_BLOCK_SIZE;
+}
+
+/* ============================================================
+ * SEEK
+ * ============================================================ */
+
+/* Header of block i of a recording (oldest first), or NULL for a hole:
+ * a slot that is erased, failed to write or is being rewritten */
+typedef const recorder_block_t *(*recorder_block_at_t)(uint32_t i, void *ctx);
+
+/* Blocks are in (session, time) order; true if `h` lies wholly before
+ * moment `t_us` of `session` */
+static inline bool recorder_block_before(const recorder_block_t *h, uint16_t session, int64_t t_us)
+{
+    if (h->session != session) {
+        return (int16_t)(h->session - session) < 0;
+    }
+    return h->last_us < t_us;
+}
+
+/* Where reading from `t_us` of `session` starts: the index of the first
+ * of the `n` blocks that is not wholly before it, or n if there is none.
+ * Lower bound by binary search; a hole is never taken as a boundary -
+ * the first block after it decides, so holes cost a scan but never
+ * hide the blocks beyond them. The caller checks the block's session. */
+static inline uint32_t recorder_seek(uint32_t n, recorder_block_at_t at, void *ctx,
+                                     uint16_t session, int64_t t_us)
+{
+    /* Invariant: every block below lo is before the target, every
+     * block from hi on is not */
+    uint32_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t k = mid;
+        const recorder_block_t *h = NULL;
+        while (k < hi && (h = at(k, ctx)) == NULL) {
+            k++;
+        }
+
+        if (h != NULL && recorder_block_before(h, session, t_us)) {
+            lo = k + 1;
+        } else {
+            hi = mid;       /* Block k is not before, or [mid, hi) is all holes */
+        }
+    }
+
+    while (lo < n && at(lo, ctx) == NULL) {
+        lo++;
+    }
+    return lo;
+}
@@ -0,0 +1,300 @@
+/*
+ * recorder.c
+ * Staging ring (server task) -> flash (recorder task)
+ *
+ * The staging ring is RECORDER_STAGING_BLOCKS whole blocks. The server
+ * task fills block `sealed % N` and, when it is done with it, bumps
+ * `sealed` and notifies the recorder task; the recorder task writes
+ * blocks until `flushed` catches up. Each side only writes its own
+ * counter, so there are no locks. The CRC is computed by the recorder
+ * task, not on the receive path.
+ *
+ * The recorder task also keeps the header of every block on flash in
+ * RAM (the seek index), so recorder_find_block() never reads flash.
+ * It is one seqlock-protected array: the writer never waits, a seek
+ * retries if a block was written underneath it.
+ */
+
+#include "recorder.h"
+#include "seqlock.h"
+
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+
+static const char *TAG = "RECORDER";
+
+static const esp_partition_t *partition = NULL;
+static uint32_t slot_count;
+static recorder_block_t *block_index;      /* Header of the block in each slot (used 0 = none) */
+static atomic_uint index_lock;
+static uint32_t index_end;                  /* Seq after the newest block in the index */
+static uint8_t *staging;                    /* RECORDER_STAGING_BLOCKS blocks, PSRAM */
+static TaskHandle_t writer_task;
+
+static atomic_uint sealed;                  /* Blocks handed to the recorder task (server task) */
+static atomic_uint flushed;                 /* Blocks written to flash (recorder task) */
+
+/* Block being filled - server task only */
+static uint8_t *open_block;
+static recorder_block_t open_header;
+static uint32_t next_seq;
+
+static recorder_stats_t stats;
+
+/* ============================================================
+ * SERVER TASK SIDE
+ * ============================================================ */
+static void seal_block(void)
+{
+    recorder_write_header(open_block, &open_header);
+    open_block = NULL;
+    next_seq++;
+
+    unsigned n = atomic_load_explicit(&sealed, memory_order_relaxed) + 1;
+    atomic_store_explicit(&sealed, n, memory_order_release);
+    unsigned waiting = n - atomic_load_explicit(&flushed, memory_order_acquire);
+    if (waiting > stats.staged_max) {
+        stats.staged_max = waiting;
+    }
+    xTaskNotifyGive(writer_task);
+}
+
+static bool open_new_block(int64_t now)
+{
+    unsigned s = atomic_load_explicit(&sealed, memory_order_relaxed);
+    if (s - atomic_load_explicit(&flushed, memory_order_acquire) >= RECORDER_STAGING_BLOCKS) {
+        return false;   /* Flash is behind - every staging block is waiting */
+    }
+
+    open_block = staging + (size_t)(s % RECORDER_STAGING_BLOCKS) * RECORDER_BLOCK_SIZE;
+    open_header = (recorder_block_t){
+        .seq = next_seq,
+        .session = stats.session,
+        .used = RECORDER_HEADER_SIZE,
+        .first_us = now,
+        .last_us = now,
+    };
+    return true;
+}
+
+void recorder_record(const frame_t *frame, const network_rx_info_t *rx)
+{
+    if (partition == NULL) {
+        return;
+    }
+
+    size_t wire_len;
+    const uint8_t *wire = frame_wire(frame, &wire_len);
+    size_t need = RECORDER_RECORD_HEADER_SIZE + wire_len;
+
+    if (open_block != NULL && open_header.used + need > RECORDER_BLOCK_SIZE) {
+        seal_block();
+    }
+    if (open_block == NULL && !open_new_block(rx->rx_time_us)) {
+        stats.dropped++;
+        return;
+    }
+
+    /* Frames come straight from the parser, in arrival order, so rx
+     * time never goes backwards within a block */
+    uint8_t *p = open_block + open_header.used;
+    frame_write_u32(p, (uint32_t)(rx->rx_time_us - open_header.first_us));
+    frame_write_u16(p + 4, (uint16_t)wire_len);
+    p[6] = rx->conn == NETWORK_CONN_UDP ? RECORDER_SOURCE_UDP : (uint8_t)(rx->conn & 0xFF);
+    p[7] = (uint8_t)rx->lane;
+    memcpy(p + RECORDER_RECORD_HEADER_SIZE, wire, wire_len);
+
+    open_header.used += (uint16_t)need;
+    open_header.records++;
+    open_header.last_us = rx->rx_time_us;
+    stats.frames++;
+}
+
+void recorder_poll(int64_t now)
+{
+    if (open_block != NULL && now - open_header.first_us >= (int64_t)RECORDER_FLUSH_MS * 1000) {
+        seal_block();
+    }
+}
+
+/* ============================================================
+ * RECORDER TASK
+ * ============================================================ */
+static void write_block(uint8_t *block)
+{
+    recorder_block_t h;
+    if (!recorder_read_header(block, &h)) {
+        stats.write_errors++;       /* Sealed by the server task - cannot happen */
+        return;
+    }
+
+    /* Unused tail reads back like erased flash */
+    memset(block + h.used, 0xFF, RECORDER_BLOCK_SIZE - h.used);
+    h.crc = frame_crc16(block + RECORDER_HEADER_SIZE, h.used - RECORDER_HEADER_SIZE);
+    recorder_write_header(block, &h);
+
+    uint32_t slot = h.seq % slot_count;
+    size_t offset = (size_t)slot * RECORDER_BLOCK_SIZE;
+    int64_t t0 = esp_timer_get_time();
+
+    /* The slot holds neither block until the write is done: a hole */
+    seqlock_write_begin(&index_lock);
+    block_index[slot].used = 0;
+    index_end = h.seq + 1;
+    seqlock_write_end(&index_lock);
+
+    if (esp_partition_erase_range(partition, offset, RECORDER_BLOCK_SIZE) != ESP_OK ||
+        esp_partition_write(partition, offset, block, RECORDER_BLOCK_SIZE) != ESP_OK) {
+        stats.write_errors++;
+        return;
+    }
+
+    seqlock_write_begin(&index_lock);
+    block_index[slot] = h;
+    seqlock_write_end(&index_lock);
+
+    uint32_t took = (uint32_t)(esp_timer_get_time() - t0);
+    if (took > stats.write_max_us) {
+        stats.write_max_us = took;
+    }
+    stats.blocks++;
+}
+
+static void recorder_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        unsigned f = atomic_load_explicit(&flushed, memory_order_relaxed);
+        while (f != atomic_load_explicit(&sealed, memory_order_acquire)) {
+            write_block(staging + (size_t)(f % RECORDER_STAGING_BLOCKS) * RECORDER_BLOCK_SIZE);
+            atomic_store_explicit(&flushed, ++f, memory_order_release);
+        }
+    }
+}
+
+/* ============================================================
+ * SETUP
+ * ============================================================ */
+
+/* Read every block header into the seek index, and find where the
+ * last boot stopped writing */
+static void scan_partition(void)
+{
+    uint8_t header[RECORDER_HEADER_SIZE];
+    bool found = false;
+    uint32_t last_seq = 0;
+    uint16_t last_session = 0;
+
+    for (uint32_t slot = 0; slot < slot_count; slot++) {
+        recorder_block_t h;
+        if (esp_partition_read(partition, (size_t)slot * RECORDER_BLOCK_SIZE, header,
+                               sizeof(header)) != ESP_OK ||
+            !recorder_read_header(header, &h) || h.seq % slot_count != slot) {
+            continue;
+        }
+        block_index[slot] = h;
+        if (!found || (int32_t)(h.seq - last_seq) > 0) {
+            last_seq = h.seq;
+        }
+        if (!found || (int16_t)(h.session - last_session) > 0) {
+            last_session = h.session;
+        }
+        found = true;
+    }
+
+    next_seq = found ? last_seq + 1 : 0;
+    index_end = next_seq;
+    stats.session = found ? (uint16_t)(last_session + 1) : 0;
+}
+
+esp_err_t recorder_init(void)
+{
+    const esp_partition_t *part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)RECORDER_PARTITION_SUBTYPE,
+        RECORDER_PARTITION_LABEL);
+    if (part == NULL) {
+        ESP_LOGW(TAG, "No \"%s\" partition - flight recorder off", RECORDER_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    slot_count = part->size / RECORDER_BLOCK_SIZE;
+    block_index = heap_caps_calloc(slot_count, sizeof(*block_index), MALLOC_CAP_SPIRAM);
+    staging = heap_caps_malloc((size_t)RECORDER_STAGING_BLOCKS * RECORDER_BLOCK_SIZE,
+                               MALLOC_CAP_SPIRAM);
+    if (slot_count < 2 || block_index == NULL || staging == NULL) {
+        ESP_LOGE(TAG, "Cannot record: %lu slots, out of memory?", (unsigned long)slot_count);
+        heap_caps_free(block_index);
+        heap_caps_free(staging);
+        return ESP_ERR_NO_MEM;
+    }
+
+    partition = part;
+    stats.slots = slot_count;
+    scan_partition();
+
+    /* Below the server (5) and LVGL (4): flash only gets spare time */
+    if (xTaskCreate(recorder_task, "recorder", 3072, NULL, 2, &writer_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create recorder task");
+        partition = NULL;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Recording to \"%s\": %lu blocks (%lu KB), session %u, next block %lu",
+             part->label, (unsigned long)slot_count,
+             (unsigned long)(part->size / 1024), stats.session, (unsigned long)next_seq);
+    return ESP_OK;
+}
+
+/* ============================================================
+ * SEEK INDEX
+ * ============================================================ */
+
+/* ctx is the seq of block 0: the index holds [index_end - count, index_end) */
+static const recorder_block_t *index_at(uint32_t i, void *ctx)
+{
+    uint32_t seq = *(const uint32_t *)ctx + i;
+    const recorder_block_t *h = &block_index[seq % slot_count];
+    return h->used != 0 && h->seq == seq ? h : NULL;
+}
+
+bool recorder_find_block(uint16_t session, int64_t t_us, recorder_block_t *out)
+{
+    if (partition == NULL) {
+        return false;
+    }
+
+    unsigned start;
+    bool found;
+    do {
+        start = seqlock_read_begin(&index_lock);
+        uint32_t count = index_end < slot_count ? index_end : slot_count;
+        uint32_t first_seq = index_end - count;
+
+        /* A torn read may find the block gone again; the retry fixes it */
+        uint32_t i = recorder_seek(count, index_at, &first_seq, session, t_us);
+        const recorder_block_t *h = i < count ? index_at(i, &first_seq) : NULL;
+        found = h != NULL && h->session == session;
+        if (found) {
+            *out = *h;
+        }
+    } while (seqlock_read_retry(&index_lock, start));
+    return found;
+}
+
+/* ============================================================
+ * PUBLIC API
+ * ============================================================ */
+void recorder_get_stats(recorder_stats_t *out)
+{
+    /* Plain copy - see net_server_get_stats() */
+    *out = stats;
+}
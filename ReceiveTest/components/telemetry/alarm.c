@@ -0,0 +1,253 @@
+/*
+ * alarm.c
+ * Flat, channel-indexed rule array + single-producer event queue
+ *
+ * ABOVE and BELOW rules are unified by a sign: a BELOW rule compares
+ * -value against -threshold, so evaluation is the same two compares
+ * for every rule with no switch on the operator.
+ *
+ * The summary (active count + newest raised alarm) is rewritten only on
+ * a transition, so the per-sample path is unchanged; the UI copies it
+ * under a seqlock.
+ */
+
+#include "alarm.h"
+#include "alarm_rules.h"
+#include "seqlock.h"
+
+#include <stdatomic.h>
+#include <string.h>
+#include "esp_log.h"
+
+static const char *TAG = "ALARM";
+
+/* ============================================================
+ * RULE SOURCE TABLE (from alarm_rules.h)
+ * ============================================================ */
+typedef struct {
+    const char *name;
+    uint16_t first_channel;
+    uint16_t last_channel;
+    uint8_t op;
+    int32_t threshold;
+    int32_t hysteresis;
+    uint8_t debounce;
+    uint8_t severity;
+} alarm_rule_def_t;
+
+#define ALARM_RULE_DEF(name, first, last, op, threshold, hysteresis, debounce, severity) \
+    { name, first, last, op, threshold, hysteresis, debounce, severity },
+static const alarm_rule_def_t rule_defs[] = {
+    ALARM_RULE_LIST(ALARM_RULE_DEF)
+};
+#undef ALARM_RULE_DEF
+
+#define RULE_DEF_COUNT  (sizeof(rule_defs) / sizeof(rule_defs[0]))
+
+/* ============================================================
+ * COMPILED RULES
+ * ============================================================ */
+typedef struct {
+    int32_t sign;           /* +1 for ABOVE, -1 for BELOW */
+    int32_t trip;           /* sign * threshold */
+    int32_t clear;          /* sign * (threshold -/+ hysteresis) */
+    uint8_t debounce;
+    uint8_t count;          /* Consecutive samples towards the next transition */
+    uint8_t active;
+    uint8_t severity;
+    uint16_t def;           /* Index into rule_defs */
+    uint16_t channel;
+    int32_t raised_value;   /* While active: the sample that raised it */
+    int64_t raised_us;
+} alarm_rule_t;
+
+static alarm_rule_t rules[ALARM_MAX_RULES];
+static uint16_t rule_count;
+static uint16_t rule_start[TELEMETRY_CHANNEL_COUNT + 1];   /* Rules of ch: [start[ch], start[ch+1]) */
+
+/* Published summary (network task writes, anyone reads) */
+static alarm_summary_t summary;
+static atomic_uint summary_seq;
+
+/* ============================================================
+ * EVENT QUEUE (network task -> UI task)
+ * ============================================================ */
+static alarm_event_t events[ALARM_EVENT_QUEUE];
+static atomic_uint event_head;      /* Written by the producer */
+static atomic_uint event_tail;      /* Written by the consumer */
+static uint32_t dropped;
+
+static void push_event(const alarm_rule_t *rule, uint16_t channel, int32_t value, int64_t now_us)
+{
+    unsigned head = atomic_load_explicit(&event_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&event_tail, memory_order_acquire);
+    if (head - tail >= ALARM_EVENT_QUEUE) {
+        dropped++;
+        return;
+    }
+
+    alarm_event_t *ev = &events[head % ALARM_EVENT_QUEUE];
+    ev->rule = (uint16_t)(rule - rules);
+    ev->channel = channel;
+    ev->raised = rule->active;
+    ev->severity = rule->severity;
+    ev->value = value;
+    ev->timestamp_us = now_us;
+    atomic_store_explicit(&event_head, head + 1, memory_order_release);
+}
+
+/* ============================================================
+ * SUMMARY (rewritten on every transition)
+ * ============================================================ */
+static void publish_summary(const alarm_rule_t *changed)
+{
+    alarm_summary_t next = summary;
+
+    if (changed->active) {
+        next.active++;
+        next.rule = (uint16_t)(changed - rules);
+        next.channel = changed->channel;
+        next.severity = changed->severity;
+        next.value = changed->raised_value;
+        next.raised_us = changed->raised_us;
+    } else {
+        /* Cleared: the newest of the ones still raised takes over */
+        next.active--;
+        const alarm_rule_t *newest = NULL;
+        for (unsigned i = 0; i < rule_count; i++) {
+            if (rules[i].active && (newest == NULL || rules[i].raised_us >= newest->raised_us)) {
+                newest = &rules[i];
+            }
+        }
+        if (newest != NULL) {
+            next.rule = (uint16_t)(newest - rules);
+            next.channel = newest->channel;
+            next.severity = newest->severity;
+            next.value = newest->raised_value;
+            next.raised_us = newest->raised_us;
+        }
+    }
+
+    seqlock_write_begin(&summary_seq);
+    summary = next;
+    seqlock_write_end(&summary_seq);
+}
+
+/* ============================================================
+ * SETUP
+ * ============================================================ */
+void alarm_init(void)
+{
+    rule_count = 0;
+    seqlock_write_begin(&summary_seq);
+    memset(&summary, 0, sizeof(summary));
+    seqlock_write_end(&summary_seq);
+
+    /* Counting-sort the expanded rules by channel so each channel's
+     * rules are contiguous */
+    for (int ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+        rule_start[ch] = rule_count;
+        for (size_t d = 0; d < RULE_DEF_COUNT; d++) {
+            const alarm_rule_def_t *def = &rule_defs[d];
+            if (ch < def->first_channel || ch > def->last_channel) {
+                continue;
+            }
+            if (rule_count >= ALARM_MAX_RULES) {
+                ESP_LOGE(TAG, "More than %d rules - raise ALARM_MAX_RULES", ALARM_MAX_RULES);
+                break;
+            }
+
+            alarm_rule_t *rule = &rules[rule_count++];
+            rule->sign = (def->op == ALARM_BELOW) ? -1 : 1;
+            rule->trip = rule->sign * def->threshold;
+            rule->clear = rule->trip - def->hysteresis;
+            rule->debounce = def->debounce ? def->debounce : 1;
+            rule->count = 0;
+            rule->active = 0;
+            rule->severity = def->severity;
+            rule->def = (uint16_t)d;
+            rule->channel = (uint16_t)ch;
+        }
+    }
+    rule_start[TELEMETRY_CHANNEL_COUNT] = rule_count;
+
+    ESP_LOGI(TAG, "Compiled %u alarm rules from %u definitions",
+             (unsigned)rule_count, (unsigned)RULE_DEF_COUNT);
+}
+
+/* ============================================================
+ * EVALUATION (hot path)
+ * ============================================================ */
+void alarm_evaluate(uint16_t channel, int32_t value, int64_t now_us)
+{
+    if (channel >= TELEMETRY_CHANNEL_COUNT) {
+        return;
+    }
+
+    for (unsigned i = rule_start[channel]; i < rule_start[channel + 1]; i++) {
+        alarm_rule_t *rule = &rules[i];
+        int32_t v = rule->sign * value;
+
+        /* Inactive: count samples past the trip point.
+         * Active:   count samples back past the clear point. */
+        int towards = rule->active ? (v < rule->clear) : (v > rule->trip);
+        if (!towards) {
+            rule->count = 0;
+            continue;
+        }
+        if (++rule->count < rule->debounce) {
+            continue;
+        }
+
+        rule->count = 0;
+        rule->active = !rule->active;
+        if (rule->active) {
+            rule->raised_value = value;
+            rule->raised_us = now_us;
+        }
+        publish_summary(rule);
+        push_event(rule, channel, value, now_us);
+    }
+}
+
+/* ============================================================
+ * UI SIDE
+ * ============================================================ */
+bool alarm_pop_event(alarm_event_t *event)
+{
+    unsigned tail = atomic_load_explicit(&event_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&event_head, memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+
+    *event = events[tail % ALARM_EVENT_QUEUE];
+    atomic_store_explicit(&event_tail, tail + 1, memory_order_release);
+    return true;
+}
+
+void alarm_get_summary(alarm_summary_t *out)
+{
+    unsigned start;
+    do {
+        start = seqlock_read_begin(&summary_seq);
+        *out = summary;
+    } while (seqlock_read_retry(&summary_seq, start));
+}
+
+int alarm_active_count(void)
+{
+    alarm_summary_t s;
+    alarm_get_summary(&s);
+    return s.active;
+}
+
+const char *alarm_rule_name(uint16_t rule)
+{
+    return rule < rule_count ? rule_defs[rules[rule].def].name : "?";
+}
+
+uint32_t alarm_dropped_events(void)
+{
+    return dropped;
+}
@@ -0,0 +1,250 @@
+/*
+ * clock_sync.c
+ * Per-sender exchange window, min-delay filter, least-squares drift
+ *
+ * For an exchange t1 (sender sends), t2 (we receive), t3 (we answer),
+ * t4 (sender receives):
+ *
+ *   offset = ((t1 - t2) + (t4 - t3)) / 2     sender clock - ours
+ *   delay  = (t4 - t1) - (t3 - t2)           round trip on the wire
+ *
+ * The offset is exact when both directions took equally long; the
+ * error is at most delay / 2, which is why the low-delay exchanges
+ * are the ones to trust.
+ *
+ * The fit runs in float on offsets relative to the best exchange and
+ * times relative to the newest, so the numbers stay small (the P4 has
+ * a single-precision FPU only).
+ */
+
+#include "clock_sync.h"
+#include "seqlock.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/* ============================================================
+ * STATE
+ * ============================================================ */
+typedef struct {
+    int64_t mid_us;             /* (t2 + t3) / 2, our clock */
+    int64_t offset_us;
+    uint32_t delay_us;
+} sync_sample_t;
+
+typedef struct {
+    bool in_use;
+    int64_t last_seen_us;
+
+    /* The exchange waiting for its t4 */
+    bool pending;
+    uint32_t pending_seq;
+    int64_t t1, t2, t3;
+
+    sync_sample_t samples[CLOCK_SYNC_WINDOW];
+    unsigned head;              /* Next slot to write */
+    unsigned count;
+
+    atomic_uint seq;            /* Seqlock over `pub` */
+    clock_sync_peer_t pub;
+} peer_t;
+
+static peer_t peers[CLOCK_SYNC_MAX_PEERS];
+
+/* ============================================================
+ * PEERS
+ * ============================================================ */
+static peer_t *find_peer(int32_t conn)
+{
+    for (int i = 0; i < CLOCK_SYNC_MAX_PEERS; i++) {
+        if (peers[i].in_use && peers[i].pub.conn == conn) {
+            return &peers[i];
+        }
+    }
+    return NULL;
+}
+
+/* Every change to `pub`, counters included, goes through here, so a
+ * reader never sees a count from one exchange and an estimate from
+ * another */
+static void publish(peer_t *p, const clock_sync_peer_t *pub)
+{
+    seqlock_write_begin(&p->seq);
+    p->pub = *pub;
+    seqlock_write_end(&p->seq);
+}
+
+/* Free slot, or the one heard from least recently */
+static peer_t *new_peer(int32_t conn, int64_t now_us)
+{
+    peer_t *p = &peers[0];
+    for (int i = 0; i < CLOCK_SYNC_MAX_PEERS; i++) {
+        if (!peers[i].in_use) {
+            p = &peers[i];
+            break;
+        }
+        if (peers[i].last_seen_us < p->last_seen_us) {
+            p = &peers[i];
+        }
+    }
+
+    publish(p, &(clock_sync_peer_t){ .conn = conn });
+
+    p->in_use = true;
+    p->pending = false;
+    p->head = 0;
+    p->count = 0;
+    p->last_seen_us = now_us;
+    return p;
+}
+
+/* ============================================================
+ * ESTIMATE
+ * ============================================================ */
+
+/* Refit the window after a new sample into `pub` (a copy of the
+ * published estimate - the caller publishes it). Returns false if the
+ * newest sample was an outlier. */
+static bool refit(const peer_t *p, clock_sync_peer_t *pub)
+{
+    const sync_sample_t *newest = &p->samples[(p->head + CLOCK_SYNC_WINDOW - 1) % CLOCK_SYNC_WINDOW];
+    const sync_sample_t *best = newest;
+
+    for (unsigned i = 0; i < p->count; i++) {
+        if (p->samples[i].delay_us < best->delay_us) {
+            best = &p->samples[i];
+        }
+    }
+    uint32_t limit = 2 * best->delay_us + CLOCK_SYNC_SLACK_US;
+
+    /* Least squares over the accepted samples: x in seconds before the
+     * newest, y in us relative to the best sample */
+    int64_t ref = newest->mid_us;
+    float sx = 0, sy = 0, sxx = 0, sxy = 0;
+    float x_min = 0, x_max = 0;
+    unsigned n = 0;
+
+    for (unsigned i = 0; i < p->count; i++) {
+        const sync_sample_t *s = &p->samples[i];
+        if (s->delay_us > limit) {
+            continue;
+        }
+        float x = (float)(s->mid_us - ref) / 1e6f;
+        float y = (float)(s->offset_us - best->offset_us);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        x_min = n == 0 || x < x_min ? x : x_min;
+        x_max = n == 0 || x > x_max ? x : x_max;
+        n++;
+    }
+
+    /* Drift in us/s = ppm. Until the window spans long enough, keep
+     * the old drift and anchor on the best sample. */
+    float drift = (float)pub->drift_ppb / 1000.0f;
+    float at_ref;
+    float det = n * sxx - sx * sx;
+    if (n >= 3 && (x_max - x_min) * 1e6f >= CLOCK_SYNC_MIN_SPAN_US && det > 0) {
+        drift = (n * sxy - sx * sy) / det;
+        at_ref = (sy - drift * sx) / n;
+    } else {
+        at_ref = -drift * (float)(best->mid_us - ref) / 1e6f;
+    }
+
+    int64_t drift_ppb = (int64_t)(drift * 1000.0f);
+    if (drift_ppb > CLOCK_SYNC_MAX_DRIFT_PPB || drift_ppb < -CLOCK_SYNC_MAX_DRIFT_PPB) {
+        drift_ppb = 0;
+        at_ref = 0;
+    }
+
+    pub->synced = true;
+    pub->offset_us = best->offset_us + (int64_t)at_ref;
+    pub->ref_us = ref;
+    pub->drift_ppb = (int32_t)drift_ppb;
+    pub->error_us = best->delay_us / 2;
+
+    return newest->delay_us <= limit;
+}
+
+static void add_sample(peer_t *p, int64_t t4)
+{
+    clock_sync_peer_t pub = p->pub;
+
+    int64_t delay = (t4 - p->t1) - (p->t3 - p->t2);
+    if (delay < 0 || delay > UINT32_MAX) {
+        pub.rejected++;         /* Sender's clock stepped mid-exchange */
+        publish(p, &pub);
+        return;
+    }
+
+    p->samples[p->head] = (sync_sample_t){
+        .mid_us = p->t2 + (p->t3 - p->t2) / 2,
+        .offset_us = ((p->t1 - p->t2) + (t4 - p->t3)) / 2,
+        .delay_us = (uint32_t)delay,
+    };
+    p->head = (p->head + 1) % CLOCK_SYNC_WINDOW;
+    if (p->count < CLOCK_SYNC_WINDOW) {
+        p->count++;
+    }
+
+    bool accepted = refit(p, &pub);
+    pub.exchanges++;
+    if (!accepted) {
+        pub.rejected++;
+    }
+    publish(p, &pub);
+}
+
+/* ============================================================
+ * API
+ * ============================================================ */
+void clock_sync_exchange(int32_t conn, uint32_t seq, uint64_t t1, uint64_t prev_t4,
+                         int64_t rx_us, int64_t tx_us)
+{
+    peer_t *p = find_peer(conn);
+    if (p == NULL) {
+        p = new_peer(conn, rx_us);
+    }
+    p->last_seen_us = rx_us;
+
+    if (p->pending && prev_t4 != 0 && p->pending_seq + 1 == seq) {
+        add_sample(p, (int64_t)prev_t4);
+    }
+
+    p->pending = true;
+    p->pending_seq = seq;
+    p->t1 = (int64_t)t1;
+    p->t2 = rx_us;
+    p->t3 = tx_us;
+}
+
+bool clock_sync_to_local(int32_t conn, uint64_t sender_us, int64_t *local_us)
+{
+    const peer_t *p = find_peer(conn);
+    if (p == NULL || !p->pub.synced) {
+        return false;
+    }
+
+    /* local = sender - offset(local); offset(local) moves by drift, so
+     * evaluate it at the first guess - the error is drift^2, nothing */
+    int64_t guess = (int64_t)sender_us - p->pub.offset_us;
+    int64_t correction = (int64_t)p->pub.drift_ppb * (guess - p->pub.ref_us) / 1000000000;
+    *local_us = guess - correction;
+    return true;
+}
+
+bool clock_sync_get_peer(int index, clock_sync_peer_t *out)
+{
+    if (index < 0 || index >= CLOCK_SYNC_MAX_PEERS || !peers[index].in_use) {
+        return false;
+    }
+
+    peer_t *p = &peers[index];
+    unsigned start;
+    do {
+        start = seqlock_read_begin(&p->seq);
+        *out = p->pub;
+    } while (seqlock_read_retry(&p->seq, start));
+    return true;
+}
@@ -0,0 +1,339 @@
+/*
+ * derived.c
+ * Static rule graph, dirty bitmap in dependency order
+ *
+ * Rules are stored sorted so that a rule always comes after every rule
+ * whose output it reads. The dirty bitmap is indexed by that position:
+ * recomputing lowest bit first is a topological walk, and marking a
+ * dependent can only set a bit above the one being processed - one
+ * pass over the bitmap is enough.
+ */
+
+#include "derived.h"
+#include "derived_rules.h"
+#include "telemetry_store.h"
+
+#include "esp_log.h"
+
+static const char *TAG = "DERIVED";
+
+/* ============================================================
+ * RULE SOURCE TABLE (from derived_rules.h)
+ * ============================================================ */
+typedef struct {
+    uint16_t output;
+    uint8_t op;
+    uint16_t a;
+    uint16_t b;
+    int32_t param;
+} derived_rule_def_t;
+
+#define DERIVED_RULE_DEF(output, op, a, b, param) { output, op, a, b, param },
+static const derived_rule_def_t rule_defs[] = {
+    DERIVED_RULE_LIST(DERIVED_RULE_DEF)
+};
+#undef DERIVED_RULE_DEF
+
+#define RULE_DEF_COUNT  (sizeof(rule_defs) / sizeof(rule_defs[0]))
+#define DIRTY_WORDS     ((DERIVED_MAX_RULES + 31) / 32)
+
+/* ============================================================
+ * COMPILED GRAPH
+ * ============================================================ */
+typedef struct {
+    const derived_rule_def_t *def;
+    uint8_t out_decimals;
+    uint8_t in_decimals;        /* Of input a */
+
+    /* DERIVED_INTEGRAL state */
+    uint8_t started;
+    int32_t last_value;
+    int64_t last_us;
+    int64_t area;               /* Sum of (v0 + v1) * dt_us, input units */
+} derived_rule_t;
+
+static derived_rule_t rules[DERIVED_MAX_RULES];        /* Dependency order */
+static uint16_t rule_count;
+static uint16_t reader_start[TELEMETRY_CHANNEL_COUNT + 1];  /* Readers of ch: [start[ch], start[ch+1]) */
+static uint8_t readers[DERIVED_MAX_EDGES];              /* Rule positions, ascending per channel */
+static uint8_t is_output[TELEMETRY_CHANNEL_COUNT];
+static uint32_t dirty[DIRTY_WORDS];
+
+/* ============================================================
+ * FIXED-POINT HELPERS
+ * ============================================================ */
+static const int64_t pow10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+/* num / den rounded half away from zero (den > 0) */
+static int64_t div_round(int64_t num, int64_t den)
+{
+    return num >= 0 ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+/* Move `value` from `from` decimals to `to` decimals */
+static int64_t rescale(int64_t value, int from, int to)
+{
+    return to >= from ? value * pow10[to - from] : div_round(value, pow10[from - to]);
+}
+
+static int32_t saturate(int64_t v)
+{
+    return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (int32_t)v;
+}
+
+/* ============================================================
+ * SETUP
+ * ============================================================ */
+
+/* True if rule `def` takes `channel` as an input */
+static bool reads(const derived_rule_def_t *def, uint16_t channel)
+{
+    if (def->op == DERIVED_PRODUCT) {
+        return channel == def->a || channel == def->b;
+    }
+    return channel >= def->a && channel <= def->b;
+}
+
+/* True if every input of `def` that some rule computes is already placed */
+static bool inputs_ready(const derived_rule_def_t *def, const uint8_t *placed)
+{
+    for (size_t d = 0; d < RULE_DEF_COUNT; d++) {
+        if (!placed[d] && reads(def, rule_defs[d].output)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void derived_init(void)
+{
+    uint8_t placed[RULE_DEF_COUNT];
+    uint16_t edges = 0;
+
+    rule_count = 0;
+    for (size_t d = 0; d < RULE_DEF_COUNT; d++) {
+        placed[d] = 0;
+    }
+    for (int ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+        is_output[ch] = 0;
+    }
+    for (int w = 0; w < DIRTY_WORDS; w++) {
+        dirty[w] = 0;
+    }
+
+    /* Topological sort: keep placing the first rule whose inputs are
+     * all placed. A handful of rules - quadratic is fine at startup. */
+    bool progress = true;
+    while (progress && rule_count < RULE_DEF_COUNT) {
+        progress = false;
+        for (size_t d = 0; d < RULE_DEF_COUNT; d++) {
+            const derived_rule_def_t *def = &rule_defs[d];
+            if (placed[d] || !inputs_ready(def, placed)) {
+                continue;
+            }
+            placed[d] = 1;
+            progress = true;
+
+            if (rule_count >= DERIVED_MAX_RULES || def->output >= TELEMETRY_CHANNEL_COUNT ||
+                is_output[def->output]) {
+                ESP_LOGE(TAG, "Skipping rule for channel %u (duplicate, unknown or "
+                         "more than %d rules)", def->output, DERIVED_MAX_RULES);
+                continue;
+            }
+
+            rules[rule_count++] = (derived_rule_t){
+                .def = def,
+                .out_decimals = telemetry_channel_info[def->output].decimals,
+                .in_decimals = telemetry_channel_info[def->a].decimals,
+            };
+            is_output[def->output] = 1;
+        }
+    }
+    for (size_t d = 0; d < RULE_DEF_COUNT; d++) {
+        if (!placed[d]) {
+            ESP_LOGE(TAG, "Rule for channel %u is in a dependency cycle - skipped",
+                     rule_defs[d].output);
+        }
+    }
+
+    /* Readers of each channel, grouped by channel (like alarm rules) */
+    for (int ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+        reader_start[ch] = edges;
+        for (unsigned r = 0; r < rule_count; r++) {
+            if (!reads(rules[r].def, (uint16_t)ch)) {
+                continue;
+            }
+            if (edges >= DERIVED_MAX_EDGES) {
+                ESP_LOGE(TAG, "More than %d inputs - raise DERIVED_MAX_EDGES", DERIVED_MAX_EDGES);
+                break;
+            }
+            readers[edges++] = (uint8_t)r;
+        }
+    }
+    reader_start[TELEMETRY_CHANNEL_COUNT] = edges;
+
+    ESP_LOGI(TAG, "Compiled %u derived channels, %u inputs", (unsigned)rule_count, (unsigned)edges);
+}
+
+bool derived_is_output(uint16_t channel)
+{
+    return channel < TELEMETRY_CHANNEL_COUNT && is_output[channel];
+}
+
+/* ============================================================
+ * MARKING (every stored sample)
+ * ============================================================ */
+void derived_input_changed(uint16_t channel)
+{
+    if (channel >= TELEMETRY_CHANNEL_COUNT) {
+        return;
+    }
+    for (unsigned i = reader_start[channel]; i < reader_start[channel + 1]; i++) {
+        dirty[readers[i] / 32] |= 1u << (readers[i] % 32);
+    }
+}
+
+/* ============================================================
+ * EVALUATION
+ * ============================================================ */
+
+/* Fresh input only - a stale cell must not set the pack minimum */
+static bool read_input(uint16_t channel, int64_t now_us, telemetry_sample_t *s)
+{
+    telemetry_store_read(channel, now_us, s);
+    return (s->flags & (TELEMETRY_FLAG_VALID | TELEMETRY_FLAG_STALE)) == TELEMETRY_FLAG_VALID;
+}
+
+static bool eval_product(const derived_rule_t *rule, int64_t now_us, int32_t *value, int64_t *ts)
+{
+    const derived_rule_def_t *def = rule->def;
+    telemetry_sample_t a, b;
+    if (!read_input(def->a, now_us, &a) || !read_input(def->b, now_us, &b)) {
+        return false;
+    }
+
+    int decimals = rule->in_decimals + telemetry_channel_info[def->b].decimals;
+    *value = saturate(rescale((int64_t)a.value * b.value, decimals, rule->out_decimals));
+    *ts = a.timestamp_us > b.timestamp_us ? a.timestamp_us : b.timestamp_us;
+    return true;
+}
+
+static bool eval_extreme(const derived_rule_t *rule, int64_t now_us, int32_t *value, int64_t *ts)
+{
+    const derived_rule_def_t *def = rule->def;
+    bool want_max = def->op == DERIVED_MAX;
+    bool found = false;
+    telemetry_sample_t s;
+    int32_t best = 0;
+
+    *ts = 0;
+    for (uint16_t ch = def->a; ch <= def->b; ch++) {
+        if (!read_input(ch, now_us, &s)) {
+            continue;
+        }
+        if (!found || (want_max ? s.value > best : s.value < best)) {
+            best = s.value;
+        }
+        if (s.timestamp_us > *ts) {
+            *ts = s.timestamp_us;
+        }
+        found = true;
+    }
+
+    *value = saturate(rescale(best, rule->in_decimals, rule->out_decimals));
+    return found;
+}
+
+/* Trapezoid rule between consecutive samples of the input. A gap longer
+ * than the input's stale_ms is not integrated - we do not know what
+ * happened in it. */
+static bool eval_integral(derived_rule_t *rule, int64_t now_us, int32_t *value, int64_t *ts)
+{
+    const derived_rule_def_t *def = rule->def;
+    telemetry_sample_t s;
+    telemetry_store_read(def->a, now_us, &s);
+    if (!(s.flags & TELEMETRY_FLAG_VALID)) {
+        return false;
+    }
+
+    int64_t dt = s.timestamp_us - rule->last_us;
+    if (rule->started && dt <= 0) {
+        return false;       /* Nothing new (or out of order) */
+    }
+    if (rule->started && dt <= (int64_t)telemetry_channel_info[def->a].stale_ms * 1000) {
+        rule->area += ((int64_t)rule->last_value + s.value) * dt;
+    }
+    rule->started = 1;
+    rule->last_value = s.value;
+    rule->last_us = s.timestamp_us;
+
+    /* area is 2 * input * us; the output is area * 10^out / (2 * 10^in * param * 10^6).
+     * Split into quotient and remainder so nothing overflows int64. */
+    int64_t den = 2 * pow10[rule->in_decimals] * (def->param > 0 ? def->param : 1) * 1000000;
+    int64_t scale = pow10[rule->out_decimals];
+    int64_t whole = rule->area / den;
+    int64_t rem = rule->area % den;
+    *value = saturate(whole * scale + div_round(rem * scale, den));
+    *ts = s.timestamp_us;
+    return true;
+}
+
+static bool eval_remaining(const derived_rule_t *rule, int64_t now_us, int32_t *value, int64_t *ts)
+{
+    const derived_rule_def_t *def = rule->def;
+    telemetry_sample_t s;
+    if (!read_input(def->a, now_us, &s) || def->param <= 0) {
+        return false;
+    }
+
+    int64_t full = def->param * pow10[rule->in_decimals];
+    int64_t hundred = 100 * pow10[rule->out_decimals];
+    int64_t left = div_round((full - s.value) * hundred, full);
+    *value = (int32_t)(left < 0 ? 0 : left > hundred ? hundred : left);
+    *ts = s.timestamp_us;
+    return true;
+}
+
+static bool eval_rule(derived_rule_t *rule, int64_t now_us, int32_t *value, int64_t *ts)
+{
+    switch (rule->def->op) {
+        case DERIVED_PRODUCT:   return eval_product(rule, now_us, value, ts);
+        case DERIVED_MIN:
+        case DERIVED_MAX:       return eval_extreme(rule, now_us, value, ts);
+        case DERIVED_INTEGRAL:  return eval_integral(rule, now_us, value, ts);
+        case DERIVED_REMAINING: return eval_remaining(rule, now_us, value, ts);
+        default:                return false;
+    }
+}
+
+size_t derived_flush(int64_t now_us, derived_sink_t sink)
+{
+    size_t written = 0;
+    int32_t value;
+    int64_t ts;
+
+    /* Marking only ever sets bits above the current one, so each word
+     * is re-read until it is clear before moving on */
+    for (int w = 0; w < DIRTY_WORDS; w++) {
+        while (dirty[w]) {
+            unsigned r = w * 32 + __builtin_ctz(dirty[w]);
+            dirty[w] &= dirty[w] - 1;
+
+            derived_rule_t *rule = &rules[r];
+            if (!eval_rule(rule, now_us, &value, &ts)) {
+                continue;
+            }
+
+            uint16_t out = rule->def->output;
+            telemetry_store_update(out, value, ts);
+            derived_input_changed(out);
+            if (sink != NULL) {
+                sink(out, value, ts);
+            }
+            written++;
+        }
+    }
+    return written;
+}
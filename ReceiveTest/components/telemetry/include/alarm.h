@@ -0,0 +1,75 @@
+/*
+ * alarm.h
+ * Threshold alarms evaluated on every incoming sample
+ *
+ * Rules from alarm_rules.h are compiled once by alarm_init() into a flat
+ * array grouped by channel. The network task calls alarm_evaluate() for
+ * each sample - a few compares per rule on that channel - and state
+ * changes are queued as events for the UI to pick up on its next frame.
+ * The set of raised alarms is also published as a summary (how many,
+ * and the newest one still raised) under a seqlock, so the banner never
+ * shows an alarm that has already cleared.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_channels.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define ALARM_MAX_RULES     128     /* Compiled rules (after expanding channel ranges) */
+#define ALARM_EVENT_QUEUE   32      /* Pending events (power of two) */
+
+typedef enum {
+    ALARM_ABOVE,
+    ALARM_BELOW,
+} alarm_op_t;
+
+typedef enum {
+    ALARM_WARNING,
+    ALARM_CRITICAL,
+} alarm_severity_t;
+
+/* One raise/clear transition */
+typedef struct {
+    uint16_t rule;          /* Compiled rule index (for alarm_rule_name) */
+    uint16_t channel;
+    uint8_t raised;         /* 1 = alarm raised, 0 = cleared */
+    uint8_t severity;       /* alarm_severity_t */
+    int32_t value;          /* Sample that caused the transition */
+    int64_t timestamp_us;
+} alarm_event_t;
+
+/* What the banner shows: the raised alarms, as of one moment */
+typedef struct {
+    int active;             /* Alarms currently raised */
+    uint16_t rule;          /* Newest one still raised (only if active > 0) */
+    uint16_t channel;
+    uint8_t severity;       /* alarm_severity_t */
+    int32_t value;          /* Sample that raised it */
+    int64_t raised_us;
+} alarm_summary_t;
+
+/* Compile the rule list. Call once before any alarm_evaluate(). */
+void alarm_init(void);
+
+/* Evaluate every rule on `channel` against a new sample (network task) */
+void alarm_evaluate(uint16_t channel, int32_t value, int64_t now_us);
+
+/* Pop the oldest pending event (UI task). Returns false if none. */
+bool alarm_pop_event(alarm_event_t *event);
+
+/* Number of alarms currently raised */
+int alarm_active_count(void);
+
+/* Consistent snapshot of the raised alarms (any task) */
+void alarm_get_summary(alarm_summary_t *summary);
+
+/* Rule name ("overtemp", ...) of a compiled rule */
+const char *alarm_rule_name(uint16_t rule);
+
+/* Events lost because the UI did not drain the queue in time */
+uint32_t alarm_dropped_events(void);
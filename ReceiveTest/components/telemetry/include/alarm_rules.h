@@ -0,0 +1,26 @@
+/*
+ * alarm_rules.h
+ * THE list of alarm rules - edit this table to add one
+ *
+ * Thresholds are in the channel's fixed-point units (see
+ * telemetry_channels.h), e.g. 2800 on a 3-decimal voltage = 2.800 V.
+ * A rule can cover a range of channels (all 30 cells at once); it is
+ * expanded into one compiled rule per channel by alarm_init().
+ *
+ *   op          ALARM_ABOVE / ALARM_BELOW the threshold trips the alarm
+ *   hysteresis  how far back past the threshold the value must go to clear
+ *   debounce    consecutive samples needed to trip (and to clear)
+ */
+#pragma once
+
+/*  X(name,            first channel,    last channel,     op,          threshold, hysteresis, debounce, severity) */
+#define ALARM_RULE_LIST(X)                                                                                          \
+    X("undervoltage",  CH_PACK_VOLTAGE,  CH_PACK_VOLTAGE,  ALARM_BELOW, 90000,     2000,       3,  ALARM_CRITICAL)  \
+    X("overvoltage",   CH_PACK_VOLTAGE,  CH_PACK_VOLTAGE,  ALARM_ABOVE, 126000,    2000,       3,  ALARM_CRITICAL)  \
+    X("overcurrent",   CH_PACK_CURRENT,  CH_PACK_CURRENT,  ALARM_ABOVE, 60000,     5000,       2,  ALARM_CRITICAL)  \
+    X("overcurrent",   CH_MOTOR_CURRENT, CH_MOTOR_CURRENT, ALARM_ABOVE, 80000,     5000,       2,  ALARM_WARNING)   \
+    X("overtemp",      CH_MOTOR_TEMP,    CH_MOTOR_TEMP,    ALARM_ABOVE, 1200,      50,         5,  ALARM_WARNING)   \
+    X("overtemp",      CH_CONTROLLER_TEMP, CH_CONTROLLER_TEMP, ALARM_ABOVE, 900,   50,         5,  ALARM_WARNING)   \
+    X("overtemp",      CH_CELL_TEMP_1,   CH_CELL_TEMP_8,   ALARM_ABOVE, 550,       20,         3,  ALARM_CRITICAL)  \
+    X("undervoltage",  CH_CELL_V_1,      CH_CELL_V_30,     ALARM_BELOW, 2800,      50,         3,  ALARM_CRITICAL)  \
+    X("overvoltage",   CH_CELL_V_1,      CH_CELL_V_30,     ALARM_ABOVE, 4200,      30,         3,  ALARM_CRITICAL)
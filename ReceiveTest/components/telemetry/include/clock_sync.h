@@ -0,0 +1,57 @@
+/*
+ * clock_sync.h
+ * Sender clock -> esp_timer time, per TCP connection
+ *
+ * A sender that stamps its data with its own clock also sends a
+ * TIME_REQ every second or so (frame.h). Each finished exchange gives
+ * one NTP-style measurement: the offset between the clocks and the
+ * round-trip delay. A burst of queueing inflates the delay and skews
+ * the offset, so only measurements whose delay is close to the best in
+ * the window are used; a least-squares line through those gives the
+ * offset and the drift (crystals differ by tens of ppm - 2 ms a minute).
+ *
+ * Network task only, except clock_sync_get_peer() (any task, seqlock).
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define CLOCK_SYNC_MAX_PEERS    6       /* Senders tracked at once (NET_MAX_CLIENTS) */
+#define CLOCK_SYNC_WINDOW       16      /* Exchanges kept per sender */
+#define CLOCK_SYNC_SLACK_US     200     /* Accepted delay: up to 2 x best + this */
+#define CLOCK_SYNC_MIN_SPAN_US  2000000 /* Local time covered before drift is fitted */
+#define CLOCK_SYNC_MAX_DRIFT_PPB 500000 /* Anything wilder is a bad fit, not a crystal */
+
+/* Current estimate for one sender */
+typedef struct {
+    int32_t conn;               /* Connection id */
+    bool synced;                /* At least one usable exchange */
+    int64_t offset_us;          /* Sender clock - esp_timer time, at ref_us */
+    int64_t ref_us;             /* esp_timer time the offset is for */
+    int32_t drift_ppb;          /* How much faster the sender's clock runs */
+    uint32_t error_us;          /* Half the best round trip: bound on the offset error */
+    uint32_t exchanges;         /* Exchanges completed */
+    uint32_t rejected;          /* ... of which were left out as outliers */
+} clock_sync_peer_t;
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* A TIME_REQ from `conn` (fields as sent) was answered with t2 = rx_us,
+ * t3 = tx_us. Finishes the previous exchange if `prev_t4` belongs to it
+ * and remembers this one. */
+void clock_sync_exchange(int32_t conn, uint32_t seq, uint64_t t1, uint64_t prev_t4,
+                         int64_t rx_us, int64_t tx_us);
+
+/* Map a time on `conn`'s clock to esp_timer time. Returns false (and
+ * leaves *local_us alone) until that sender is synced. */
+bool clock_sync_to_local(int32_t conn, uint64_t sender_us, int64_t *local_us);
+
+/* Copy out one peer slot (0..CLOCK_SYNC_MAX_PEERS-1). Returns false if
+ * the slot is unused. */
+bool clock_sync_get_peer(int index, clock_sync_peer_t *peer);
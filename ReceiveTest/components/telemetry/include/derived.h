@@ -0,0 +1,55 @@
+/*
+ * derived.h
+ * Derived channels (pack power, energy, min/max cell...) computed from
+ * the telemetry store
+ *
+ * derived_init() compiles derived_rules.h into a static graph: rules in
+ * dependency order, plus a channel-indexed list of the rules reading
+ * each channel. The network task reports every stored sample with
+ * derived_input_changed(), which only marks the rules that read that
+ * channel; derived_flush() then recomputes the marked rules in order,
+ * writes their outputs to the store and marks the rules reading those
+ * in turn. Marking per sample and flushing once per frame means a
+ * batch touching all 30 cells recomputes the min/max once, not 30
+ * times.
+ *
+ * Network task only. No heap - every table is sized at compile time.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_channels.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define DERIVED_MAX_RULES   32      /* Derived channels */
+#define DERIVED_MAX_EDGES   128     /* Input channel -> rule links (a range counts each channel) */
+
+typedef enum {
+    DERIVED_PRODUCT,
+    DERIVED_MIN,
+    DERIVED_MAX,
+    DERIVED_INTEGRAL,
+    DERIVED_REMAINING,
+} derived_op_t;
+
+/* Called for every output derived_flush() writes to the store, so the
+ * caller can feed it to history and alarms like a received sample */
+typedef void (*derived_sink_t)(uint16_t channel, int32_t value, int64_t timestamp_us);
+
+/* Sort and compile the rules. Call once before any other call. Rules
+ * in a dependency cycle are logged and left out. */
+void derived_init(void);
+
+/* True if `channel` is computed here (senders must not write it) */
+bool derived_is_output(uint16_t channel);
+
+/* `channel` has a new value in the store: mark the rules that read it */
+void derived_input_changed(uint16_t channel);
+
+/* Recompute every marked rule in dependency order. Returns the number
+ * of outputs written. */
+size_t derived_flush(int64_t now_us, derived_sink_t sink);
@@ -0,0 +1,28 @@
+/*
+ * derived_rules.h
+ * THE list of derived channels - edit this table to add one
+ *
+ * Each rule computes one output channel (from telemetry_channels.h)
+ * out of other channels, which may themselves be derived. The order of
+ * the list does not matter: derived_init() sorts the rules so every
+ * rule runs after the rules it reads from.
+ *
+ *   DERIVED_PRODUCT    a * b
+ *   DERIVED_MIN/MAX    smallest / largest valid channel in [a, b]
+ *   DERIVED_INTEGRAL   running integral of a over time, divided by
+ *                      param seconds (3600: W -> Wh)
+ *   DERIVED_REMAINING  100% * (1 - a / param), a and param in the same
+ *                      unit (energy used of a param Wh pack -> SoC)
+ *
+ * Values are converted between the channels' decimals with integer
+ * math only - no floats anywhere.
+ */
+#pragma once
+
+/*  X(output,          op,                a,                b,                param) */
+#define DERIVED_RULE_LIST(X)                                                            \
+    X(CH_PACK_POWER,   DERIVED_PRODUCT,   CH_PACK_VOLTAGE,  CH_PACK_CURRENT,  0)        \
+    X(CH_PACK_ENERGY,  DERIVED_INTEGRAL,  CH_PACK_POWER,    CH_PACK_POWER,    3600)     \
+    X(CH_SOC_ENERGY,   DERIVED_REMAINING, CH_PACK_ENERGY,   CH_PACK_ENERGY,   5000)     \
+    X(CH_CELL_V_MIN,   DERIVED_MIN,       CH_CELL_V_1,      CH_CELL_V_30,     0)        \
+    X(CH_CELL_V_MAX,   DERIVED_MAX,       CH_CELL_V_1,      CH_CELL_V_30,     0)
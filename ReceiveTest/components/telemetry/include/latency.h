@@ -0,0 +1,71 @@
+/*
+ * latency.h
+ * End-to-end latency probes: sender -> recv -> UI apply -> pixels
+ *
+ * A sender embeds a sequence number and its own timestamp in a probe
+ * frame. The receiver stamps the probe when recv() returned it, when
+ * the UI applied it, and when LVGL finished flushing that frame to the
+ * panel. Stage durations go into percentile histograms (shown on the
+ * status line) and back to the sender as an acknowledgement.
+ *
+ * If the sender's clock is synced (clock_sync.h), the probe's own
+ * timestamp also gives the one-way wire time, sender -> recv.
+ *
+ * Threads: probes come in on the network task, apply/flush happen on
+ * the LVGL task, acks go out on the network task again. Each hand-over
+ * is a small single-producer/single-consumer queue.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define LATENCY_QUEUE_SIZE      16      /* Probes in flight per hand-over (power of two) */
+
+typedef enum {
+    LATENCY_RECV_TO_APPLY,      /* recv() returned -> UI applied the update */
+    LATENCY_APPLY_TO_FLUSH,     /* UI applied -> last flush of that frame finished */
+    LATENCY_RECV_TO_FLUSH,      /* Whole on-board path */
+    LATENCY_SEND_TO_RECV,       /* Sender stamped the probe -> recv() (synced senders only) */
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+/* Percentiles of one stage (microseconds, ~12% resolution) */
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} latency_summary_t;
+
+/* A finished probe, to be sent back to whoever sent it */
+typedef struct {
+    int32_t conn;               /* Connection the probe arrived on */
+    uint32_t seq;
+    uint64_t sender_ts_us;      /* Echoed back so the sender can compute RTT */
+    uint32_t recv_to_apply_us;
+    uint32_t apply_to_flush_us;
+} latency_ack_t;
+
+/* Network task: a probe frame arrived. `sent_us` is the probe's
+ * timestamp in esp_timer time, or -1 if the sender is not synced. */
+void latency_probe_received(int32_t conn, uint32_t seq, uint64_t sender_ts_us, int64_t sent_us,
+                            int64_t rx_us);
+
+/* LVGL task: called once per UI refresh after applying new data.
+ * Returns true if probes are waiting for a flush (so the caller should
+ * make sure something is redrawn). */
+bool latency_mark_applied(int64_t now_us);
+
+/* LVGL task: the last area of a frame has been flushed to the panel */
+void latency_mark_flushed(int64_t now_us);
+
+/* Network task: next finished probe to acknowledge */
+bool latency_pop_ack(latency_ack_t *ack);
+
+/* Percentiles of one stage since boot. Exact on the LVGL task; from
+ * other tasks the numbers may be one sample behind. */
+void latency_get_summary(latency_stage_t stage, latency_summary_t *summary);
@@ -0,0 +1,57 @@
+/*
+ * mailbox.h
+ * Latest-value-wins text mailbox between the network task and the UI
+ *
+ * The network task posts every text message as it arrives (no locks,
+ * never blocks). The UI drains the mailbox once per refresh period and
+ * only sees the newest message per channel, so UI work is bounded by
+ * the frame rate instead of the packet rate.
+ *
+ * Numeric samples go to the telemetry store instead (telemetry_store.h),
+ * which works the same way.
+ *
+ * One writer (network task) and one reader (LVGL task).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define MAILBOX_CHANNELS    8       /* Text channel ids 0..7 */
+#define MAILBOX_TEXT_MAX    96      /* Longest text kept (including NUL) */
+
+/* Snapshot of one channel as handed to the reader */
+typedef struct {
+    uint16_t channel;
+    int64_t timestamp_us;           /* When the network task posted it */
+    char text[MAILBOX_TEXT_MAX];    /* Always NUL-terminated */
+} mailbox_msg_t;
+
+/* Counters for the whole mailbox */
+typedef struct {
+    uint32_t posted;        /* Messages written */
+    uint32_t coalesced;     /* Overwritten before the UI read them */
+    uint32_t dropped;       /* Channel id out of range */
+    uint32_t drained;       /* Messages handed to the UI */
+} mailbox_stats_t;
+
+/* Called by mailbox_drain() once per channel that changed */
+typedef void (*mailbox_visitor_t)(const mailbox_msg_t *msg, void *ctx);
+
+/* ============================================================
+ * WRITER SIDE (network task)
+ * ============================================================ */
+void mailbox_post_text(uint16_t channel, const char *text, size_t len, int64_t now_us);
+
+/* ============================================================
+ * READER SIDE (LVGL task)
+ * ============================================================ */
+
+/* Visit every channel posted since the last drain, newest value only.
+ * Returns the number of channels visited. */
+size_t mailbox_drain(mailbox_visitor_t visit, void *ctx);
+
+void mailbox_get_stats(mailbox_stats_t *stats);
@@ -0,0 +1,39 @@
+/*
+ * seqlock.h
+ * Single-writer sequence lock helpers
+ *
+ * The writer bumps the counter to odd, writes, then bumps it to even.
+ * A reader copies the data and retries if the counter was odd or
+ * changed underneath it. The writer never waits for a reader.
+ */
+#pragma once
+
+#include <stdatomic.h>
+
+static inline void seqlock_write_begin(atomic_uint *seq)
+{
+    atomic_fetch_add_explicit(seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void seqlock_write_end(atomic_uint *seq)
+{
+    atomic_fetch_add_explicit(seq, 1, memory_order_release);
+}
+
+/* Returns the counter to pass to seqlock_read_retry(); spins while a
+ * write is in flight (a handful of stores) */
+static inline unsigned seqlock_read_begin(const atomic_uint *seq)
+{
+    unsigned s;
+    while ((s = atomic_load_explicit(seq, memory_order_acquire)) & 1) {
+    }
+    return s;
+}
+
+/* True if the data copied since seqlock_read_begin() may be torn */
+static inline int seqlock_read_retry(const atomic_uint *seq, unsigned start)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(seq, memory_order_relaxed) != start;
+}
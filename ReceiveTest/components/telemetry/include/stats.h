@@ -0,0 +1,72 @@
+/*
+ * stats.h
+ * Running statistics per channel: mean/variance, min/max and EWMAs
+ *
+ * Only channels listed in STATS_CHANNEL_LIST keep statistics. Each
+ * sample is folded in at ingest in O(1): Welford's update for mean and
+ * variance since the last reset, min/max, and one exponentially
+ * weighted average per STATS_EWMA_TAU_MS entry (time constants, so
+ * irregular sample rates weigh correctly).
+ *
+ * The network task is the only writer; any task reads lock-free
+ * through a per-channel seqlock. Resetting (say, at the start of a
+ * lap) is a request any task can make - the writer applies it on the
+ * channel's next sample.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "telemetry_channels.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+
+/*  X(first channel,     last channel) */
+#define STATS_CHANNEL_LIST(X)                   \
+    X(CH_PACK_VOLTAGE,   CH_SOC)                \
+    X(CH_CELL_TEMP_1,    CH_CELL_TEMP_8)        \
+    X(CH_PACK_POWER,     CH_SOC_ENERGY)
+
+/* EWMA time constants (ms): ~1 s, ~10 s and ~1 min trends */
+#define STATS_EWMA_TAU_MS   { 1000, 10000, 60000 }
+#define STATS_EWMA_COUNT    3
+
+/* One consistent snapshot. Values are in the channel's fixed-point
+ * units (telemetry_channels.h). */
+typedef struct {
+    uint32_t count;                     /* Samples since the last reset */
+    double mean;
+    double variance;                    /* Sample variance (n - 1), 0 below two samples */
+    int32_t min;
+    int32_t max;
+    float ewma[STATS_EWMA_COUNT];       /* In STATS_EWMA_TAU_MS order */
+    int64_t reset_us;                   /* When the current window started */
+} stats_snapshot_t;
+
+/* ============================================================
+ * WRITER SIDE (network task)
+ * ============================================================ */
+
+/* Map the listed channels to their slots. Call once before any
+ * stats_update(). */
+void stats_init(void);
+
+/* Fold in one sample. Channels without statistics return right away. */
+void stats_update(uint16_t channel, int32_t value, int64_t now_us);
+
+/* ============================================================
+ * READER SIDE (any task)
+ * ============================================================ */
+
+/* Copy out one channel. Returns false if the channel keeps no
+ * statistics or has no sample since its last reset. */
+bool stats_read(uint16_t channel, stats_snapshot_t *snapshot);
+
+/* Start a new window (mean/variance/min/max) on the channel's next
+ * sample. The EWMAs carry on. */
+void stats_request_reset(uint16_t channel);
+
+/* The same for every channel - a new lap (FRAME_TYPE_LAP) */
+void stats_request_reset_all(void);
@@ -0,0 +1,99 @@
+/*
+ * telemetry_channels.h
+ * THE list of telemetry channels - edit this table to add one
+ *
+ * Everything else (the channel id enum, the name/unit table, the store
+ * arrays) is generated from this list at compile time, so looking a
+ * channel up is just an array index.
+ *
+ * Values travel as int32 fixed-point: the real value is
+ * raw / 10^decimals (e.g. pack voltage 98234 with 3 decimals = 98.234 V).
+ * A channel is "stale" when nothing arrived for stale_ms.
+ *
+ * The channel id on the wire is the position in this list, so only
+ * ever append - never reorder or delete entries.
+ *
+ * The last few channels are computed on the board from the others
+ * (derived_rules.h); samples a sender sends for them are ignored.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/*  X(id,              name,              unit,   decimals, stale_ms) */
+#define TELEMETRY_CHANNEL_LIST(X)                                       \
+    X(PACK_VOLTAGE,    "Pack voltage",    "V",    3,  1000)             \
+    X(PACK_CURRENT,    "Pack current",    "A",    3,  1000)             \
+    X(MOTOR_CURRENT,   "Motor current",   "A",    3,  500)              \
+    X(MOTOR_TEMP,      "Motor temp",      "C",    1,  2000)             \
+    X(CONTROLLER_TEMP, "Controller temp", "C",    1,  2000)             \
+    X(SPEED,           "Speed",           "km/h", 1,  500)              \
+    X(WHEEL_SPEED_L,   "Wheel speed L",   "rpm",  0,  500)              \
+    X(WHEEL_SPEED_R,   "Wheel speed R",   "rpm",  0,  500)              \
+    X(ARRAY_POWER,     "Array power",     "W",    0,  2000)             \
+    X(SOC,             "State of charge", "%",    1,  5000)             \
+    X(CELL_TEMP_1,     "Cell temp 1",     "C",    1,  2000)             \
+    X(CELL_TEMP_2,     "Cell temp 2",     "C",    1,  2000)             \
+    X(CELL_TEMP_3,     "Cell temp 3",     "C",    1,  2000)             \
+    X(CELL_TEMP_4,     "Cell temp 4",     "C",    1,  2000)             \
+    X(CELL_TEMP_5,     "Cell temp 5",     "C",    1,  2000)             \
+    X(CELL_TEMP_6,     "Cell temp 6",     "C",    1,  2000)             \
+    X(CELL_TEMP_7,     "Cell temp 7",     "C",    1,  2000)             \
+    X(CELL_TEMP_8,     "Cell temp 8",     "C",    1,  2000)             \
+    X(CELL_V_1,        "Cell 1",          "V",    3,  2000)             \
+    X(CELL_V_2,        "Cell 2",          "V",    3,  2000)             \
+    X(CELL_V_3,        "Cell 3",          "V",    3,  2000)             \
+    X(CELL_V_4,        "Cell 4",          "V",    3,  2000)             \
+    X(CELL_V_5,        "Cell 5",          "V",    3,  2000)             \
+    X(CELL_V_6,        "Cell 6",          "V",    3,  2000)             \
+    X(CELL_V_7,        "Cell 7",          "V",    3,  2000)             \
+    X(CELL_V_8,        "Cell 8",          "V",    3,  2000)             \
+    X(CELL_V_9,        "Cell 9",          "V",    3,  2000)             \
+    X(CELL_V_10,       "Cell 10",         "V",    3,  2000)             \
+    X(CELL_V_11,       "Cell 11",         "V",    3,  2000)             \
+    X(CELL_V_12,       "Cell 12",         "V",    3,  2000)             \
+    X(CELL_V_13,       "Cell 13",         "V",    3,  2000)             \
+    X(CELL_V_14,       "Cell 14",         "V",    3,  2000)             \
+    X(CELL_V_15,       "Cell 15",         "V",    3,  2000)             \
+    X(CELL_V_16,       "Cell 16",         "V",    3,  2000)             \
+    X(CELL_V_17,       "Cell 17",         "V",    3,  2000)             \
+    X(CELL_V_18,       "Cell 18",         "V",    3,  2000)             \
+    X(CELL_V_19,       "Cell 19",         "V",    3,  2000)             \
+    X(CELL_V_20,       "Cell 20",         "V",    3,  2000)             \
+    X(CELL_V_21,       "Cell 21",         "V",    3,  2000)             \
+    X(CELL_V_22,       "Cell 22",         "V",    3,  2000)             \
+    X(CELL_V_23,       "Cell 23",         "V",    3,  2000)             \
+    X(CELL_V_24,       "Cell 24",         "V",    3,  2000)             \
+    X(CELL_V_25,       "Cell 25",         "V",    3,  2000)             \
+    X(CELL_V_26,       "Cell 26",         "V",    3,  2000)             \
+    X(CELL_V_27,       "Cell 27",         "V",    3,  2000)             \
+    X(CELL_V_28,       "Cell 28",         "V",    3,  2000)             \
+    X(CELL_V_29,       "Cell 29",         "V",    3,  2000)             \
+    X(CELL_V_30,       "Cell 30",         "V",    3,  2000)             \
+    X(PACK_POWER,      "Pack power",      "W",    0,  1000)             \
+    X(PACK_ENERGY,     "Pack energy",     "Wh",   1,  5000)             \
+    X(CELL_V_MIN,      "Cell min",        "V",    3,  2000)             \
+    X(CELL_V_MAX,      "Cell max",        "V",    3,  2000)             \
+    X(SOC_ENERGY,      "SoC (energy)",    "%",    1,  5000)
+
+/* ============================================================
+ * GENERATED: channel ids
+ * ============================================================ */
+#define TELEMETRY_CHANNEL_ENUM(id, name, unit, decimals, stale_ms) CH_##id,
+typedef enum {
+    TELEMETRY_CHANNEL_LIST(TELEMETRY_CHANNEL_ENUM)
+    TELEMETRY_CHANNEL_COUNT
+} telemetry_channel_t;
+#undef TELEMETRY_CHANNEL_ENUM
+
+/* ============================================================
+ * GENERATED: static description of each channel
+ * ============================================================ */
+typedef struct {
+    const char *name;
+    const char *unit;
+    uint8_t decimals;
+    uint16_t stale_ms;
+} telemetry_channel_info_t;
+
+extern const telemetry_channel_info_t telemetry_channel_info[TELEMETRY_CHANNEL_COUNT];
@@ -0,0 +1,55 @@
+/*
+ * telemetry_store.h
+ * Current value of every telemetry channel, indexed by channel id
+ *
+ * Fixed-size arrays generated from telemetry_channels.h - no hashing,
+ * no heap. The network task is the only writer; the UI (and anything
+ * else) reads lock-free. Each write also marks the channel dirty so the
+ * UI can pick up just the channels that changed since its last frame.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_channels.h"
+
+/* Flags returned with every read */
+#define TELEMETRY_FLAG_VALID    0x01    /* At least one sample has arrived */
+#define TELEMETRY_FLAG_STALE    0x02    /* Nothing new for longer than stale_ms */
+
+/* One consistent snapshot of a channel */
+typedef struct {
+    int32_t value;          /* Fixed-point, see telemetry_channel_info[].decimals */
+    int64_t timestamp_us;   /* esp_timer time of the last update */
+    uint8_t flags;          /* TELEMETRY_FLAG_* */
+} telemetry_sample_t;
+
+/* Called by telemetry_store_drain() once per changed channel */
+typedef void (*telemetry_visitor_t)(telemetry_channel_t channel,
+                                    const telemetry_sample_t *sample, void *ctx);
+
+/* ============================================================
+ * WRITER SIDE (network task)
+ * ============================================================ */
+
+/* Store a new value. Returns false if `channel` is not a known id. */
+bool telemetry_store_update(uint16_t channel, int32_t value, int64_t now_us);
+
+/* ============================================================
+ * READER SIDE (any task)
+ * ============================================================ */
+
+/* Snapshot one channel. `now_us` is used for the stale flag. */
+bool telemetry_store_read(uint16_t channel, int64_t now_us, telemetry_sample_t *sample);
+
+/* Visit every channel updated since the last drain (single reader -
+ * the UI). Returns the number of channels visited. */
+size_t telemetry_store_drain(int64_t now_us, telemetry_visitor_t visit, void *ctx);
+
+/* Format a value with its decimals and unit, e.g. "98.234 V". Returns
+ * what snprintf() would. */
+int telemetry_format_value(telemetry_channel_t channel, int32_t value, char *buf, size_t size);
+
+/* The same without the unit ("3.412") */
+int telemetry_format_bare(telemetry_channel_t channel, int32_t value, char *buf, size_t size);
@@ -0,0 +1,205 @@
+/*
+ * latency.c
+ * Probe hand-over queues + log-linear latency histograms
+ *
+ * Histogram buckets: values below 16 us get one bucket each, above
+ * that every power of two is split into 8 sub-buckets. That covers
+ * 1 us .. 4000 s in 240 counters with about 12% resolution, and
+ * recording a value is a count-leading-zeros and an add.
+ */
+
+#include "latency.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+/* ============================================================
+ * HISTOGRAMS (written by the LVGL task only)
+ * ============================================================ */
+#define HIST_LINEAR     16
+#define HIST_SUB_BITS   3
+#define HIST_BUCKETS    (HIST_LINEAR + (32 - 4) * (1 << HIST_SUB_BITS))
+
+typedef struct {
+    uint32_t buckets[HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+} latency_hist_t;
+
+static latency_hist_t hists[LATENCY_STAGE_COUNT];
+
+static int hist_index(uint32_t us)
+{
+    if (us < HIST_LINEAR) {
+        return (int)us;
+    }
+    int msb = 31 - __builtin_clz(us);
+    int sub = (us >> (msb - HIST_SUB_BITS)) & ((1 << HIST_SUB_BITS) - 1);
+    return HIST_LINEAR + (msb - 4) * (1 << HIST_SUB_BITS) + sub;
+}
+
+/* Upper edge of a bucket, so a reported percentile never understates */
+static uint32_t hist_value(int index)
+{
+    if (index < HIST_LINEAR) {
+        return (uint32_t)index;
+    }
+    int msb = (index - HIST_LINEAR) / (1 << HIST_SUB_BITS) + 4;
+    int sub = (index - HIST_LINEAR) % (1 << HIST_SUB_BITS);
+    uint64_t low = (uint64_t)((1 << HIST_SUB_BITS) + sub) << (msb - HIST_SUB_BITS);
+    uint64_t width = 1ULL << (msb - HIST_SUB_BITS);
+    uint64_t high = low + width - 1;
+    return high > UINT32_MAX ? UINT32_MAX : (uint32_t)high;
+}
+
+static void hist_record(latency_stage_t stage, int64_t us)
+{
+    latency_hist_t *h = &hists[stage];
+    uint32_t v = us < 0 ? 0 : (us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+
+    h->buckets[hist_index(v)]++;
+    h->count++;
+    if (v > h->max_us) {
+        h->max_us = v;
+    }
+}
+
+static uint32_t hist_percentile(const latency_hist_t *h, uint32_t count, uint32_t permille)
+{
+    uint64_t rank = ((uint64_t)count * permille + 999) / 1000;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank && seen > 0) {
+            return hist_value(i);
+        }
+    }
+    return h->max_us;
+}
+
+void latency_get_summary(latency_stage_t stage, latency_summary_t *out)
+{
+    const latency_hist_t *h = &hists[stage];
+    uint32_t count = h->count;
+
+    out->count = count;
+    out->max_us = h->max_us;
+    out->p50_us = count ? hist_percentile(h, count, 500) : 0;
+    out->p99_us = count ? hist_percentile(h, count, 990) : 0;
+    if (out->p99_us > out->max_us) {
+        out->p99_us = out->max_us;
+    }
+    if (out->p50_us > out->max_us) {
+        out->p50_us = out->max_us;
+    }
+}
+
+/* ============================================================
+ * SPSC QUEUES
+ * ============================================================ */
+typedef struct {
+    int32_t conn;
+    uint32_t seq;
+    uint64_t sender_ts_us;
+    int64_t sent_us;            /* Sender's stamp in our time, -1 = unknown */
+    int64_t rx_us;
+    int64_t apply_us;
+} probe_t;
+
+typedef struct {
+    probe_t items[LATENCY_QUEUE_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+} probe_queue_t;
+
+static probe_queue_t received;          /* network task -> LVGL task */
+static probe_queue_t finished;          /* LVGL task -> network task */
+
+static bool queue_push(probe_queue_t *q, const probe_t *p)
+{
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&q->tail, memory_order_acquire) >= LATENCY_QUEUE_SIZE) {
+        return false;
+    }
+    q->items[head % LATENCY_QUEUE_SIZE] = *p;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+static bool queue_pop(probe_queue_t *q, probe_t *p)
+{
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&q->head, memory_order_acquire)) {
+        return false;
+    }
+    *p = q->items[tail % LATENCY_QUEUE_SIZE];
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/* Probes applied by the UI, waiting for the next completed flush
+ * (LVGL task only) */
+static probe_t awaiting_flush[LATENCY_QUEUE_SIZE];
+static int awaiting_count;
+
+/* ============================================================
+ * PROBE LIFECYCLE
+ * ============================================================ */
+void latency_probe_received(int32_t conn, uint32_t seq, uint64_t sender_ts_us, int64_t sent_us,
+                            int64_t rx_us)
+{
+    probe_t p = {
+        .conn = conn,
+        .seq = seq,
+        .sender_ts_us = sender_ts_us,
+        .sent_us = sent_us,
+        .rx_us = rx_us,
+    };
+    queue_push(&received, &p);     /* Full queue: probe dropped, it's only a sample */
+}
+
+bool latency_mark_applied(int64_t now_us)
+{
+    probe_t p;
+
+    while (awaiting_count < LATENCY_QUEUE_SIZE && queue_pop(&received, &p)) {
+        p.apply_us = now_us;
+        hist_record(LATENCY_RECV_TO_APPLY, now_us - p.rx_us);
+        if (p.sent_us >= 0) {
+            hist_record(LATENCY_SEND_TO_RECV, p.rx_us - p.sent_us);
+        }
+        awaiting_flush[awaiting_count++] = p;
+    }
+    return awaiting_count > 0;
+}
+
+void latency_mark_flushed(int64_t now_us)
+{
+    for (int i = 0; i < awaiting_count; i++) {
+        probe_t *p = &awaiting_flush[i];
+        hist_record(LATENCY_APPLY_TO_FLUSH, now_us - p->apply_us);
+        hist_record(LATENCY_RECV_TO_FLUSH, now_us - p->rx_us);
+
+        /* Stash the flush time in rx-relative form for the ack */
+        p->rx_us = now_us - p->rx_us;               /* recv -> flush */
+        p->apply_us = now_us - p->apply_us;         /* apply -> flush */
+        queue_push(&finished, p);
+    }
+    awaiting_count = 0;
+}
+
+bool latency_pop_ack(latency_ack_t *ack)
+{
+    probe_t p;
+    if (!queue_pop(&finished, &p)) {
+        return false;
+    }
+
+    ack->conn = p.conn;
+    ack->seq = p.seq;
+    ack->sender_ts_us = p.sender_ts_us;
+    ack->apply_to_flush_us = (uint32_t)p.apply_us;
+    ack->recv_to_apply_us = (uint32_t)(p.rx_us - p.apply_us);
+    return true;
+}
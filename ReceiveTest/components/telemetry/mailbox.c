@@ -0,0 +1,112 @@
+/*
+ * mailbox.c
+ * Per-channel seqlock slots + a dirty bitmap
+ *
+ * Writer:  write slot under its seqlock -> set dirty bit
+ * Reader:  clear dirty word -> for each bit, copy slot under its seqlock
+ *
+ * The writer never waits for the reader. If the UI is slow it simply
+ * sees the newest value the next time it looks.
+ */
+
+#include "mailbox.h"
+#include "seqlock.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#define DIRTY_WORDS     ((MAILBOX_CHANNELS + 31) / 32)
+
+typedef struct {
+    atomic_uint seq;        /* Odd while the writer is inside the slot */
+    mailbox_msg_t msg;
+} mailbox_slot_t;
+
+static mailbox_slot_t slots[MAILBOX_CHANNELS];
+static atomic_uint dirty[DIRTY_WORDS];
+static mailbox_stats_t stats;
+
+/* ============================================================
+ * WRITER
+ * ============================================================ */
+static mailbox_slot_t *begin_write(uint16_t channel)
+{
+    if (channel >= MAILBOX_CHANNELS) {
+        stats.dropped++;
+        return NULL;
+    }
+
+    mailbox_slot_t *slot = &slots[channel];
+    seqlock_write_begin(&slot->seq);
+    return slot;
+}
+
+static void end_write(mailbox_slot_t *slot, uint16_t channel)
+{
+    seqlock_write_end(&slot->seq);
+
+    uint32_t bit = 1u << (channel % 32);
+    uint32_t prev = atomic_fetch_or_explicit(&dirty[channel / 32], bit, memory_order_release);
+    if (prev & bit) {
+        stats.coalesced++;
+    }
+    stats.posted++;
+}
+
+void mailbox_post_text(uint16_t channel, const char *text, size_t len, int64_t now_us)
+{
+    mailbox_slot_t *slot = begin_write(channel);
+    if (slot == NULL) {
+        return;
+    }
+
+    if (len > MAILBOX_TEXT_MAX - 1) {
+        len = MAILBOX_TEXT_MAX - 1;
+    }
+    slot->msg.channel = channel;
+    slot->msg.timestamp_us = now_us;
+    memcpy(slot->msg.text, text, len);
+    slot->msg.text[len] = '\0';
+
+    end_write(slot, channel);
+}
+
+/* ============================================================
+ * READER
+ * ============================================================ */
+
+/* Consistent copy of one slot */
+static void read_slot(const mailbox_slot_t *slot, mailbox_msg_t *out)
+{
+    unsigned start;
+    do {
+        start = seqlock_read_begin(&slot->seq);
+        memcpy(out, &slot->msg, sizeof(*out));
+    } while (seqlock_read_retry(&slot->seq, start));
+}
+
+size_t mailbox_drain(mailbox_visitor_t visit, void *ctx)
+{
+    size_t visited = 0;
+    mailbox_msg_t msg;
+
+    for (int w = 0; w < DIRTY_WORDS; w++) {
+        uint32_t bits = atomic_exchange_explicit(&dirty[w], 0, memory_order_acquire);
+        while (bits) {
+            int b = __builtin_ctz(bits);
+            bits &= bits - 1;
+
+            read_slot(&slots[w * 32 + b], &msg);
+            visit(&msg, ctx);
+            visited++;
+        }
+    }
+
+    stats.drained += visited;
+    return visited;
+}
+
+void mailbox_get_stats(mailbox_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,185 @@
+/*
+ * stats.c
+ * Structure-of-arrays running statistics with per-channel seqlocks
+ *
+ * Channels with statistics get a dense slot; every field is its own
+ * slot-indexed array, so a batch updating many channels walks a few
+ * small arrays instead of striding over big per-channel structs.
+ *
+ * Welford's mean and M2 are doubles. In float, M2 of a channel sitting
+ * far from zero (pack voltage is ~100000 counts) stops taking small
+ * deviations in after a few thousand samples, and a lap's variance
+ * drifts off (tools/statsbench checks against a two-pass reference).
+ * The P4's FPU is single precision, so this is soft-float - two
+ * accumulators per sample. The EWMAs stay float: they forget, so
+ * their error does not build up.
+ */
+
+#include "stats.h"
+#include "seqlock.h"
+
+#include <stdatomic.h>
+#include "esp_log.h"
+
+static const char *TAG = "STATS";
+
+/* ============================================================
+ * SLOTS
+ * ============================================================ */
+#define STATS_RANGE_SIZE(first, last)   + ((last) - (first) + 1)
+enum { STATS_MAX_SLOTS = 0 STATS_CHANNEL_LIST(STATS_RANGE_SIZE) };
+#undef STATS_RANGE_SIZE
+
+#define NO_SLOT         0xFF
+#define RESET_WORDS     ((TELEMETRY_CHANNEL_COUNT + 31) / 32)
+
+static const float ewma_tau_ms[STATS_EWMA_COUNT] = STATS_EWMA_TAU_MS;
+
+static uint8_t slot_of[TELEMETRY_CHANNEL_COUNT];
+static unsigned slot_count;
+
+/* ============================================================
+ * STATE (one entry per slot)
+ * ============================================================ */
+static uint32_t counts[STATS_MAX_SLOTS];
+static double means[STATS_MAX_SLOTS];
+static double m2s[STATS_MAX_SLOTS];            /* Welford: sum of squared deviations */
+static int32_t mins[STATS_MAX_SLOTS];
+static int32_t maxs[STATS_MAX_SLOTS];
+static float ewmas[STATS_EWMA_COUNT][STATS_MAX_SLOTS];
+static int64_t last_us[STATS_MAX_SLOTS];
+static int64_t reset_us[STATS_MAX_SLOTS];
+static uint8_t ewma_started[STATS_MAX_SLOTS];
+static atomic_uint seqs[STATS_MAX_SLOTS];
+static atomic_uint reset_requests[RESET_WORDS];    /* By channel, any task sets */
+
+/* ============================================================
+ * SETUP
+ * ============================================================ */
+void stats_init(void)
+{
+    static const struct { uint16_t first, last; } ranges[] = {
+#define STATS_RANGE(first, last) { first, last },
+        STATS_CHANNEL_LIST(STATS_RANGE)
+#undef STATS_RANGE
+    };
+
+    slot_count = 0;
+    for (int ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+        slot_of[ch] = NO_SLOT;
+    }
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        for (unsigned ch = ranges[r].first; ch <= ranges[r].last && ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+            if (slot_of[ch] == NO_SLOT) {
+                slot_of[ch] = (uint8_t)slot_count++;
+            }
+        }
+    }
+
+    ESP_LOGI(TAG, "Running statistics on %u channels, %d EWMAs each",
+             slot_count, STATS_EWMA_COUNT);
+}
+
+/* ============================================================
+ * WRITER (hot path)
+ * ============================================================ */
+void stats_update(uint16_t channel, int32_t value, int64_t now_us)
+{
+    if (channel >= TELEMETRY_CHANNEL_COUNT || slot_of[channel] == NO_SLOT) {
+        return;
+    }
+    unsigned s = slot_of[channel];
+    uint32_t bit = 1u << (channel % 32);
+    bool reset = atomic_load_explicit(&reset_requests[channel / 32], memory_order_relaxed) & bit;
+    if (reset) {
+        atomic_fetch_and_explicit(&reset_requests[channel / 32], ~bit, memory_order_relaxed);
+    }
+
+    seqlock_write_begin(&seqs[s]);
+
+    if (reset || counts[s] == 0) {
+        counts[s] = 0;
+        means[s] = 0.0;
+        m2s[s] = 0.0;
+        mins[s] = value;
+        maxs[s] = value;
+        reset_us[s] = now_us;
+    }
+
+    /* Welford: numerically stable, no running sum of squares */
+    double delta = (double)value - means[s];
+    counts[s]++;
+    means[s] += delta / (double)counts[s];
+    m2s[s] += delta * ((double)value - means[s]);
+
+    if (value < mins[s]) {
+        mins[s] = value;
+    }
+    if (value > maxs[s]) {
+        maxs[s] = value;
+    }
+
+    /* EWMA over time: weight dt / (tau + dt) is 1 - e^(-dt/tau) to
+     * first order, without an exp() per sample */
+    float x = (float)value;
+    if (!ewma_started[s]) {
+        for (int k = 0; k < STATS_EWMA_COUNT; k++) {
+            ewmas[k][s] = x;
+        }
+        ewma_started[s] = 1;
+    } else if (now_us > last_us[s]) {
+        float dt_ms = (float)(now_us - last_us[s]) / 1000.0f;
+        for (int k = 0; k < STATS_EWMA_COUNT; k++) {
+            ewmas[k][s] += (x - ewmas[k][s]) * dt_ms / (ewma_tau_ms[k] + dt_ms);
+        }
+    }
+    if (now_us > last_us[s]) {
+        last_us[s] = now_us;
+    }
+
+    seqlock_write_end(&seqs[s]);
+}
+
+/* ============================================================
+ * READERS
+ * ============================================================ */
+bool stats_read(uint16_t channel, stats_snapshot_t *out)
+{
+    if (channel >= TELEMETRY_CHANNEL_COUNT || slot_of[channel] == NO_SLOT) {
+        return false;
+    }
+    unsigned s = slot_of[channel];
+    unsigned start;
+    double m2;
+
+    do {
+        start = seqlock_read_begin(&seqs[s]);
+        out->count = counts[s];
+        out->mean = means[s];
+        m2 = m2s[s];
+        out->min = mins[s];
+        out->max = maxs[s];
+        for (int k = 0; k < STATS_EWMA_COUNT; k++) {
+            out->ewma[k] = ewmas[k][s];
+        }
+        out->reset_us = reset_us[s];
+    } while (seqlock_read_retry(&seqs[s], start));
+
+    out->variance = out->count > 1 ? m2 / (double)(out->count - 1) : 0.0;
+    return out->count > 0;
+}
+
+void stats_request_reset(uint16_t channel)
+{
+    if (channel < TELEMETRY_CHANNEL_COUNT) {
+        atomic_fetch_or_explicit(&reset_requests[channel / 32], 1u << (channel % 32),
+                                 memory_order_relaxed);
+    }
+}
+
+void stats_request_reset_all(void)
+{
+    for (int w = 0; w < RESET_WORDS; w++) {
+        atomic_store_explicit(&reset_requests[w], ~0u, memory_order_relaxed);
+    }
+}
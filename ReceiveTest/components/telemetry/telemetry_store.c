@@ -0,0 +1,139 @@
+/*
+ * telemetry_store.c
+ * Structure-of-arrays channel store with per-channel seqlocks
+ *
+ * Values, timestamps and flags live in separate arrays, so a reader
+ * scanning all values (UI, alarms) touches only the cache lines it needs.
+ */
+
+#include "telemetry_store.h"
+#include "seqlock.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+/* ============================================================
+ * GENERATED CHANNEL TABLE
+ * ============================================================ */
+#define TELEMETRY_CHANNEL_INFO(id, name, unit, decimals, stale_ms) \
+    [CH_##id] = { name, unit, decimals, stale_ms },
+const telemetry_channel_info_t telemetry_channel_info[TELEMETRY_CHANNEL_COUNT] = {
+    TELEMETRY_CHANNEL_LIST(TELEMETRY_CHANNEL_INFO)
+};
+#undef TELEMETRY_CHANNEL_INFO
+
+/* ============================================================
+ * STORE
+ * ============================================================ */
+#define DIRTY_WORDS     ((TELEMETRY_CHANNEL_COUNT + 31) / 32)
+
+static int32_t values[TELEMETRY_CHANNEL_COUNT];
+static int64_t timestamps[TELEMETRY_CHANNEL_COUNT];
+static uint8_t valid[TELEMETRY_CHANNEL_COUNT];
+static atomic_uint seqs[TELEMETRY_CHANNEL_COUNT];
+static atomic_uint dirty[DIRTY_WORDS];
+
+/* ============================================================
+ * WRITER
+ * ============================================================ */
+bool telemetry_store_update(uint16_t channel, int32_t value, int64_t now_us)
+{
+    if (channel >= TELEMETRY_CHANNEL_COUNT) {
+        return false;
+    }
+
+    seqlock_write_begin(&seqs[channel]);
+    values[channel] = value;
+    timestamps[channel] = now_us;
+    valid[channel] = 1;
+    seqlock_write_end(&seqs[channel]);
+
+    atomic_fetch_or_explicit(&dirty[channel / 32], 1u << (channel % 32), memory_order_release);
+    return true;
+}
+
+/* ============================================================
+ * READERS
+ * ============================================================ */
+static void read_channel(uint16_t channel, int64_t now_us, telemetry_sample_t *out)
+{
+    unsigned start;
+    uint8_t is_valid;
+
+    do {
+        start = seqlock_read_begin(&seqs[channel]);
+        out->value = values[channel];
+        out->timestamp_us = timestamps[channel];
+        is_valid = valid[channel];
+    } while (seqlock_read_retry(&seqs[channel], start));
+
+    out->flags = 0;
+    if (is_valid) {
+        out->flags |= TELEMETRY_FLAG_VALID;
+    }
+    if (!is_valid ||
+        now_us - out->timestamp_us > (int64_t)telemetry_channel_info[channel].stale_ms * 1000) {
+        out->flags |= TELEMETRY_FLAG_STALE;
+    }
+}
+
+bool telemetry_store_read(uint16_t channel, int64_t now_us, telemetry_sample_t *sample)
+{
+    if (channel >= TELEMETRY_CHANNEL_COUNT) {
+        return false;
+    }
+    read_channel(channel, now_us, sample);
+    return true;
+}
+
+size_t telemetry_store_drain(int64_t now_us, telemetry_visitor_t visit, void *ctx)
+{
+    size_t visited = 0;
+    telemetry_sample_t sample;
+
+    for (int w = 0; w < DIRTY_WORDS; w++) {
+        uint32_t bits = atomic_exchange_explicit(&dirty[w], 0, memory_order_acquire);
+        while (bits) {
+            int channel = w * 32 + __builtin_ctz(bits);
+            bits &= bits - 1;
+
+            read_channel(channel, now_us, &sample);
+            visit((telemetry_channel_t)channel, &sample, ctx);
+            visited++;
+        }
+    }
+    return visited;
+}
+
+/* ============================================================
+ * FORMATTING
+ * ============================================================ */
+int telemetry_format_bare(telemetry_channel_t channel, int32_t value, char *buf, size_t size)
+{
+    static const uint32_t pow10[] = { 1, 10, 100, 1000, 10000, 100000 };
+    int decimals = telemetry_channel_info[channel].decimals;
+    decimals = decimals < 6 ? decimals : 5;
+
+    if (decimals == 0) {
+        return snprintf(buf, size, "%ld", (long)value);
+    }
+
+    /* Integer split keeps this exact (no float rounding). The magnitude
+     * of INT32_MIN only fits unsigned - long is 32 bits on the ESP32. */
+    uint32_t mag = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    uint32_t scale = pow10[decimals];
+    return snprintf(buf, size, "%s%lu.%0*lu", value < 0 ? "-" : "",
+                    (unsigned long)(mag / scale), decimals, (unsigned long)(mag % scale));
+}
+
+int telemetry_format_value(telemetry_channel_t channel, int32_t value, char *buf, size_t size)
+{
+    int n = telemetry_format_bare(channel, value, buf, size);
+    if (n < 0) {
+        return n;
+    }
+
+    /* Unit behind whatever fitted; return the full length like snprintf */
+    size_t used = (size_t)n < size ? (size_t)n : (size > 0 ? size - 1 : 0);
+    return n + snprintf(buf + used, size - used, " %s", telemetry_channel_info[channel].unit);
+}
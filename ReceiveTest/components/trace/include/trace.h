@@ -0,0 +1,74 @@
+/*
+ * trace.h
+ * Deferred binary logging for the hot path
+ *
+ * TRACE(EVENT, args...) writes one fixed-size record (event id,
+ * esp_timer time, up to four int32 arguments) into a lock-free ring
+ * and returns. No formatting, no locks, no UART. A low-priority task formats the
+ * records a few times a second with the printf format from
+ * trace_events.h.
+ *
+ * Any task may trace. If the ring fills up before the trace task gets
+ * to it, the oldest records are overwritten and counted as dropped.
+ * Build with -DTRACE_ENABLE=0 to compile every TRACE() away.
+ *
+ * Cost: tools/tracebench measures about 60 ns per TRACE() on the host.
+ * It has not been measured on the P4. There the timestamp is a systimer
+ * read through esp_timer_get_time(), which may cost more than the rest
+ * of the call, so "tens of ns" is a host figure until someone times a
+ * loop of TRACE() against esp_cpu_get_cycle_count() on the board.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "trace_events.h"
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE        1
+#endif
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define TRACE_RING_SIZE     1024    /* Records (power of two), 32 bytes each */
+#define TRACE_FLUSH_MS      100     /* How often the trace task prints */
+#define TRACE_MAX_ARGS      4
+
+/* Event ids, generated from TRACE_EVENT_LIST */
+typedef enum {
+#define TRACE_EVENT_ENUM(id, fmt) TRACE_##id,
+    TRACE_EVENT_LIST(TRACE_EVENT_ENUM)
+#undef TRACE_EVENT_ENUM
+    TRACE_EVENT_COUNT
+} trace_event_t;
+
+/* Totals since boot */
+typedef struct {
+    uint32_t written;           /* Records traced */
+    uint32_t printed;           /* Records formatted by the trace task */
+    uint32_t dropped;           /* Overwritten before they were printed */
+} trace_stats_t;
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Start the trace task. Records written before this are kept and
+ * printed on its first pass. */
+void trace_init(void);
+
+/* Record one event - use the TRACE() macro instead */
+void trace_write(trace_event_t event, int32_t a0, int32_t a1, int32_t a2, int32_t a3);
+
+/* Print everything in the ring now (called by the trace task) */
+void trace_flush(void);
+
+void trace_get_stats(trace_stats_t *stats);
+
+/* TRACE(EVENT) .. TRACE(EVENT, a, b, c, d) - missing arguments are 0 */
+#if TRACE_ENABLE
+#define TRACE_ARGS_(a0, a1, a2, a3, ...) (int32_t)(a0), (int32_t)(a1), (int32_t)(a2), (int32_t)(a3)
+#define TRACE(event, ...) trace_write(TRACE_##event, TRACE_ARGS_(__VA_ARGS__ __VA_OPT__(,) 0, 0, 0, 0))
+#else
+#define TRACE(event, ...) ((void)0)
+#endif
@@ -0,0 +1,20 @@
+/*
+ * trace_events.h
+ * THE list of trace events - add a line here to add one
+ *
+ * The format string is only used when the record is printed later by
+ * the trace task, so it costs nothing on the hot path. Arguments are
+ * stored as int32 and passed to printf as long: use %ld / %lu / %lx.
+ * Strings cannot be traced (only their length) - that is the point.
+ */
+#pragma once
+
+/*  X(id,                  format) */
+#define TRACE_EVENT_LIST(X)                                                         \
+    X(NET_FRAME,           "Received frame: type=%ld channel=%ld length=%ld conn=%lx") \
+    X(TEXT_POSTED,         "Updating display with text: channel=%ld length=%ld")   \
+    X(UNKNOWN_CHANNEL,     "Unknown channel %ld")                                   \
+    X(UNKNOWN_FRAME_TYPE,  "Ignoring frame type %ld (channel %ld)")                 \
+    X(PROBE_ACK_DROPPED,   "Probe %lu ack dropped")                                 \
+    X(BAD_BATCH,           "Truncated batch after %ld samples (length %ld)")      \
+    X(DERIVED_SENT,        "Ignoring sample for derived channel %ld")
@@ -0,0 +1,157 @@
+/*
+ * trace.c
+ * Lock-free multi-producer trace ring + the task that prints it
+ *
+ * Writer:  claim an index with one atomic add -> fill the slot ->
+ *          publish it by storing index + 1 in the slot's seq
+ * Reader:  walk from the last printed index to head; a slot whose seq
+ *          is not index + 1 is either still being written (stop, try
+ *          again next pass) or already overwritten by a newer lap
+ *          (count as dropped)
+ *
+ * Timestamps are esp_timer_get_time(), not the CPU cycle counter: each
+ * core has its own cycle counter, so records written on different cores
+ * would not order against each other. esp_timer reads the systimer both
+ * cores share.
+ */
+
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "TRACE";
+
+#define RING_MASK   (TRACE_RING_SIZE - 1)
+
+typedef struct {
+    atomic_uint seq;            /* index + 1 once published, 0 while being written */
+    uint16_t event;
+    uint16_t reserved;
+    int64_t time_us;            /* esp_timer_get_time() */
+    int32_t args[TRACE_MAX_ARGS];
+} trace_slot_t;
+
+static trace_slot_t ring[TRACE_RING_SIZE];
+static atomic_uint head;                /* Next index to hand out */
+static uint32_t tail;                   /* Next index to print (trace task only) */
+static trace_stats_t stats;
+
+static const char *const formats[TRACE_EVENT_COUNT] = {
+#define TRACE_EVENT_FORMAT(id, fmt) [TRACE_##id] = fmt,
+    TRACE_EVENT_LIST(TRACE_EVENT_FORMAT)
+#undef TRACE_EVENT_FORMAT
+};
+
+/* ============================================================
+ * WRITER (any task)
+ * ============================================================ */
+void trace_write(trace_event_t event, int32_t a0, int32_t a1, int32_t a2, int32_t a3)
+{
+    unsigned index = atomic_fetch_add_explicit(&head, 1, memory_order_relaxed);
+    trace_slot_t *slot = &ring[index & RING_MASK];
+
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->time_us = esp_timer_get_time();
+    slot->event = (uint16_t)event;
+    slot->args[0] = a0;
+    slot->args[1] = a1;
+    slot->args[2] = a2;
+    slot->args[3] = a3;
+
+    atomic_store_explicit(&slot->seq, index + 1, memory_order_release);
+}
+
+/* ============================================================
+ * READER (trace task)
+ * ============================================================ */
+static void print_record(const trace_slot_t *rec)
+{
+    int64_t us = rec->time_us;
+    const char *fmt = rec->event < TRACE_EVENT_COUNT ? formats[rec->event] : "?";
+
+    printf("T (%lld.%03d) ", (long long)(us / 1000), (int)(us % 1000));
+    printf(fmt, (long)rec->args[0], (long)rec->args[1], (long)rec->args[2], (long)rec->args[3]);
+    putchar('\n');
+}
+
+void trace_flush(void)
+{
+    unsigned h = atomic_load_explicit(&head, memory_order_acquire);
+    uint32_t dropped = 0;
+
+    /* Writers lapped us: everything older than one ring is gone */
+    if (h - tail > TRACE_RING_SIZE) {
+        dropped += h - TRACE_RING_SIZE - tail;
+        tail = h - TRACE_RING_SIZE;
+    }
+
+    while (tail != h) {
+        trace_slot_t *slot = &ring[tail & RING_MASK];
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+        if (seq != tail + 1) {
+            if ((int)(seq - (tail + 1)) > 0) {
+                dropped++;              /* Already overwritten by a newer lap */
+                tail++;
+                continue;
+            }
+            break;                      /* Still being written - next pass */
+        }
+
+        trace_slot_t copy = {
+            .time_us = slot->time_us,
+            .event = slot->event,
+            .args = { slot->args[0], slot->args[1], slot->args[2], slot->args[3] },
+        };
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq) {
+            dropped++;                  /* Overwritten while we copied it */
+        } else {
+            print_record(&copy);
+            stats.printed++;
+        }
+        tail++;
+    }
+
+    if (dropped > 0) {
+        stats.dropped += dropped;
+        ESP_LOGW(TAG, "%lu records dropped (ring of %d)", (unsigned long)dropped, TRACE_RING_SIZE);
+    }
+    fflush(stdout);
+}
+
+static void trace_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(TRACE_FLUSH_MS));
+        trace_flush();
+    }
+}
+
+/* ============================================================
+ * PUBLIC API
+ * ============================================================ */
+void trace_init(void)
+{
+    /* Lowest priority above idle: printing must never delay ingest or
+     * rendering */
+    if (xTaskCreate(trace_task, "trace", 3072, NULL, 1, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create trace task");
+    }
+}
+
+void trace_get_stats(trace_stats_t *out)
+{
+    *out = stats;
+    out->written = atomic_load_explicit(&head, memory_order_relaxed);
+}
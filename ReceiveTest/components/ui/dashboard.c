@@ -0,0 +1,235 @@
+/*
+ * dashboard.c
+ * One int subject per bound channel, dirty bitmap per frame, label views
+ *
+ * Bound channels get a dense slot (as in stats.c). dashboard_stage()
+ * only records the value and sets the slot's dirty bit; the commit
+ * walks the set bits, so its cost follows the channels that changed.
+ *
+ * Each observing label has a view holding its formatter and the text it
+ * shows. The label points at that text (lv_label_set_text_static), so
+ * an update formats into a stack buffer, compares, and only on a
+ * difference copies it over and lets the label re-measure and
+ * invalidate itself. No allocation per update. Value labels have fixed
+ * sizes and positions, so a new text never reflows the grid.
+ */
+
+#include "dashboard.h"
+#include "glyph_atlas.h"
+#include "telemetry_store.h"
+
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "DASHBOARD";
+
+/* ============================================================
+ * SLOTS
+ * ============================================================ */
+#define DASHBOARD_RANGE_SIZE(first, last, format)   + ((last) - (first) + 1)
+enum { DASHBOARD_MAX_SLOTS = 0 DASHBOARD_BINDING_LIST(DASHBOARD_RANGE_SIZE) };
+#undef DASHBOARD_RANGE_SIZE
+
+#define DASHBOARD_MAX_VIEWS (DASHBOARD_MAX_SLOTS + DASHBOARD_EXTRA_VIEWS)
+#define NO_SLOT             0xFF
+#define DIRTY_WORDS         ((DASHBOARD_MAX_SLOTS + 31) / 32)
+
+static uint8_t slot_of[TELEMETRY_CHANNEL_COUNT];
+static unsigned slot_count;
+
+/* Per slot */
+static lv_subject_t subjects[DASHBOARD_MAX_SLOTS];
+static int32_t staged[DASHBOARD_MAX_SLOTS];
+static uint8_t channel_of[DASHBOARD_MAX_SLOTS];
+static uint8_t has_value[DASHBOARD_MAX_SLOTS];     /* Shown "--" until the first commit */
+static uint32_t dirty[DIRTY_WORDS];
+
+/* One per observing label */
+typedef struct {
+    dashboard_format_t format;
+    uint8_t slot;
+    char shown[DASHBOARD_TEXT_MAX];
+} dashboard_view_t;
+
+static dashboard_view_t views[DASHBOARD_MAX_VIEWS];
+static unsigned view_count;
+
+static dashboard_stats_t stats;
+
+/* slot_of[] is all zeros until dashboard_create() */
+static bool is_bound(telemetry_channel_t channel)
+{
+    return slot_count > 0 && channel < TELEMETRY_CHANNEL_COUNT && slot_of[channel] != NO_SLOT;
+}
+
+/* ============================================================
+ * VIEWS
+ * ============================================================ */
+static void view_observer_cb(lv_observer_t *observer, lv_subject_t *subject)
+{
+    dashboard_view_t *view = lv_observer_get_user_data(observer);
+    char text[DASHBOARD_TEXT_MAX];
+
+    if (has_value[view->slot]) {
+        view->format(channel_of[view->slot], lv_subject_get_int(subject), text, sizeof(text));
+    } else {
+        strcpy(text, "--");
+    }
+
+    /* "3.41" -> "3.41" is the common case at 50 Hz - leave the label alone */
+    if (strcmp(text, view->shown) == 0) {
+        return;
+    }
+    strcpy(view->shown, text);
+    lv_label_set_text_static(lv_observer_get_target_obj(observer), view->shown);
+    stats.redrawn++;
+}
+
+bool dashboard_bind_label(lv_obj_t *label, telemetry_channel_t channel, dashboard_format_t format)
+{
+    if (!is_bound(channel)) {
+        return false;
+    }
+    if (view_count >= DASHBOARD_MAX_VIEWS) {
+        ESP_LOGE(TAG, "No view left for channel %u - raise DASHBOARD_EXTRA_VIEWS", channel);
+        return false;
+    }
+
+    dashboard_view_t *view = &views[view_count++];
+    view->format = format != NULL ? format : telemetry_format_value;
+    view->slot = slot_of[channel];
+    view->shown[0] = '\0';
+
+    /* Runs the callback once right away, which sets the initial text */
+    lv_subject_add_observer_obj(&subjects[view->slot], view_observer_cb, label, view);
+    return true;
+}
+
+lv_subject_t *dashboard_subject(telemetry_channel_t channel)
+{
+    if (!is_bound(channel)) {
+        return NULL;
+    }
+    return &subjects[slot_of[channel]];
+}
+
+/* ============================================================
+ * SETUP
+ * ============================================================ */
+/* Shared by every tile - local styles would cost an allocation per
+ * property per label, and 50 tiles would not fit the LVGL heap */
+static lv_style_t name_style;
+static lv_style_t value_style;
+
+/* Two labels placed by slot index - no tile object, no layout pass */
+static void create_tile(lv_obj_t *grid, unsigned slot, telemetry_channel_t channel,
+                        dashboard_format_t format)
+{
+    int32_t x = slot % DASHBOARD_COLUMNS * DASHBOARD_TILE_W;
+    int32_t y = slot / DASHBOARD_COLUMNS * DASHBOARD_TILE_H;
+
+    lv_obj_t *name = lv_label_create(grid);
+    lv_label_set_text_static(name, telemetry_channel_info[channel].name);
+    lv_obj_add_style(name, &name_style, LV_PART_MAIN);
+    lv_obj_set_pos(name, x, y);
+
+    /* Fixed size: a longer or shorter text must not resize anything */
+    lv_obj_t *value = lv_label_create(grid);
+    lv_obj_set_size(value, DASHBOARD_TILE_W - 6, DASHBOARD_TILE_H - 20);
+    lv_label_set_long_mode(value, LV_LABEL_LONG_CLIP);
+    lv_obj_add_style(value, &value_style, LV_PART_MAIN);
+    lv_obj_set_pos(value, x, y + 18);
+
+    dashboard_bind_label(value, channel, format);
+}
+
+lv_obj_t *dashboard_create(lv_obj_t *parent)
+{
+    static const struct { uint16_t first, last; dashboard_format_t format; } ranges[] = {
+#define DASHBOARD_RANGE(first, last, format) { first, last, format },
+        DASHBOARD_BINDING_LIST(DASHBOARD_RANGE)
+#undef DASHBOARD_RANGE
+    };
+
+    slot_count = 0;
+    view_count = 0;
+    for (int ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+        slot_of[ch] = NO_SLOT;
+    }
+    for (int w = 0; w < DIRTY_WORDS; w++) {
+        dirty[w] = 0;
+    }
+
+    lv_style_init(&name_style);
+    lv_style_set_text_color(&name_style, lv_color_hex(0xAAAAAA));
+    lv_style_set_text_font(&name_style, &lv_font_montserrat_14);
+    lv_style_init(&value_style);
+    lv_style_set_text_color(&value_style, lv_color_white());
+    lv_style_set_text_font(&value_style, glyph_atlas_create(&lv_font_montserrat_24, GLYPH_ATLAS_DASHBOARD));
+
+    lv_obj_t *grid = lv_obj_create(parent);
+    lv_obj_remove_style_all(grid);
+    lv_obj_set_size(grid, DASHBOARD_COLUMNS * DASHBOARD_TILE_W,
+                    (DASHBOARD_MAX_SLOTS + DASHBOARD_COLUMNS - 1) / DASHBOARD_COLUMNS * DASHBOARD_TILE_H);
+    lv_obj_remove_flag(grid, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        for (unsigned ch = ranges[r].first; ch <= ranges[r].last && ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+            if (slot_of[ch] != NO_SLOT) {
+                continue;
+            }
+            unsigned s = slot_count++;
+            slot_of[ch] = (uint8_t)s;
+            channel_of[s] = (uint8_t)ch;
+            has_value[s] = 0;
+            lv_subject_init_int(&subjects[s], 0);
+            create_tile(grid, s, (telemetry_channel_t)ch, ranges[r].format);
+        }
+    }
+
+    ESP_LOGI(TAG, "Dashboard: %u channels bound", slot_count);
+    return grid;
+}
+
+/* ============================================================
+ * UPDATES (once per frame)
+ * ============================================================ */
+void dashboard_stage(telemetry_channel_t channel, int32_t value)
+{
+    if (!is_bound(channel)) {
+        return;
+    }
+    unsigned s = slot_of[channel];
+    staged[s] = value;
+    dirty[s / 32] |= 1u << (s % 32);
+    stats.staged++;
+}
+
+size_t dashboard_commit(void)
+{
+    size_t notified = 0;
+
+    for (int w = 0; w < DIRTY_WORDS; w++) {
+        while (dirty[w]) {
+            unsigned s = w * 32 + __builtin_ctz(dirty[w]);
+            dirty[w] &= dirty[w] - 1;
+
+            /* lv_subject_set_int() notifies even when nothing changed */
+            if (has_value[s] && lv_subject_get_int(&subjects[s]) == staged[s]) {
+                continue;
+            }
+            has_value[s] = 1;
+            lv_subject_set_int(&subjects[s], staged[s]);
+            notified++;
+        }
+    }
+
+    stats.notified += notified;
+    return notified;
+}
+
+void dashboard_get_stats(dashboard_stats_t *out)
+{
+    *out = stats;
+}
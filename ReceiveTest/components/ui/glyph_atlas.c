@@ -0,0 +1,209 @@
+/*
+ * glyph_atlas.c
+ * Font wrapper serving a fixed character set from pre-rendered A8
+ *
+ * The atlas font's get_glyph_dsc() answers only for characters in the
+ * atlas, from a 128-entry table; for anything else it returns false and
+ * LVGL moves on to the fallback, which is the original font. Kerning is
+ * kept: the advance of every pair inside the set is computed up front,
+ * and a pair with an outside character asks the original font.
+ *
+ * Coverage is stored exactly as the software renderer wants it (A8,
+ * LVGL's stride), each glyph wrapped in a static lv_draw_buf_t, so
+ * get_glyph_bitmap() returns a pointer and the blend reads it directly.
+ */
+
+#include "glyph_atlas.h"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "GLYPH_ATLAS";
+
+typedef struct {
+    lv_font_t font;                 /* Handed out; font.dsc points back here */
+    const lv_font_t *src;
+    uint8_t slot_of[128];           /* ASCII -> slot + 1, 0: not in the atlas */
+    uint8_t count;
+    char chars[GLYPH_ATLAS_MAX_GLYPHS];
+    lv_font_glyph_dsc_t glyph[GLYPH_ATLAS_MAX_GLYPHS];      /* Advance with no kerning */
+    uint16_t adv_pair[GLYPH_ATLAS_MAX_GLYPHS][GLYPH_ATLAS_MAX_GLYPHS];  /* [this][next] */
+    lv_draw_buf_t bitmap[GLYPH_ATLAS_MAX_GLYPHS];
+    uint8_t *pixels;
+} atlas_t;
+
+static atlas_t *atlases[GLYPH_ATLAS_MAX_FONTS];
+static glyph_atlas_stats_t stats;
+
+/* ============================================================
+ * FONT CALLBACKS (draw path)
+ * ============================================================ */
+static bool atlas_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *g,
+                                uint32_t letter, uint32_t letter_next)
+{
+    const atlas_t *a = font->dsc;
+    unsigned slot = letter < 128 ? a->slot_of[letter] : 0;
+    if (slot == 0) {
+        return false;           /* Fallback: the original font */
+    }
+    slot--;
+
+    *g = a->glyph[slot];
+    if (letter_next != 0) {
+        unsigned next = letter_next < 128 ? a->slot_of[letter_next] : 0;
+        lv_font_glyph_dsc_t k;
+        if (next != 0) {
+            g->adv_w = a->adv_pair[slot][next - 1];
+        } else if (a->src->get_glyph_dsc(a->src, &k, letter, letter_next)) {
+            g->adv_w = k.adv_w;
+        }
+    }
+    return true;
+}
+
+static const void *atlas_get_glyph_bitmap(lv_font_glyph_dsc_t *g, lv_draw_buf_t *draw_buf)
+{
+    const atlas_t *a = g->resolved_font->dsc;
+    return &a->bitmap[g->gid.index];
+}
+
+/* ============================================================
+ * BUILD
+ * ============================================================ */
+
+/* Descriptor from the original font, or false if `c` has no plain
+ * bitmap glyph there (image fonts, placeholders) */
+static bool source_glyph(const lv_font_t *src, char c, lv_font_glyph_dsc_t *g)
+{
+    if (!lv_font_get_glyph_dsc(src, g, (uint32_t)c, 0) || g->is_placeholder) {
+        return false;
+    }
+    return g->box_w == 0 || g->box_h == 0 ||
+           (g->format >= LV_FONT_GLYPH_FORMAT_A1 && g->format <= LV_FONT_GLYPH_FORMAT_A8);
+}
+
+static size_t glyph_bytes(const lv_font_glyph_dsc_t *g)
+{
+    size_t size = (size_t)lv_draw_buf_width_to_stride(g->box_w, LV_COLOR_FORMAT_A8) * g->box_h;
+    return (size + LV_DRAW_BUF_ALIGN - 1) / LV_DRAW_BUF_ALIGN * LV_DRAW_BUF_ALIGN;
+}
+
+/* Expand one glyph of the original font into `out` */
+static void render_glyph(lv_font_glyph_dsc_t *g, uint8_t *out)
+{
+    uint32_t stride = lv_draw_buf_width_to_stride(g->box_w, LV_COLOR_FORMAT_A8);
+    lv_draw_buf_t *tmp = lv_draw_buf_create(g->box_w, g->box_h, LV_COLOR_FORMAT_A8, stride);
+    if (tmp == NULL) {
+        memset(out, 0, (size_t)stride * g->box_h);
+        return;
+    }
+
+    const lv_draw_buf_t *bmp = lv_font_get_glyph_bitmap(g, tmp);
+    for (uint32_t y = 0; y < g->box_h; y++) {
+        if (bmp != NULL) {
+            memcpy(out + y * stride, bmp->data + y * bmp->header.stride, g->box_w);
+        } else {
+            memset(out + y * stride, 0, g->box_w);
+        }
+    }
+    lv_font_glyph_release_draw_data(g);
+    lv_draw_buf_destroy(tmp);
+}
+
+const lv_font_t *glyph_atlas_create(const lv_font_t *font, const char *chars)
+{
+#if GLYPH_ATLAS_ENABLED
+    int index = 0;
+    while (index < GLYPH_ATLAS_MAX_FONTS && atlases[index] != NULL) {
+        index++;
+    }
+    if (index == GLYPH_ATLAS_MAX_FONTS) {
+        ESP_LOGW(TAG, "All %d atlases in use - drawing from the font", GLYPH_ATLAS_MAX_FONTS);
+        return font;
+    }
+
+    atlas_t *a = heap_caps_calloc(1, sizeof(atlas_t), MALLOC_CAP_SPIRAM);
+    if (a == NULL) {
+        ESP_LOGW(TAG, "No memory for an atlas - drawing from the font");
+        return font;
+    }
+    a->src = font;
+
+    /* Pick the characters and size the bitmap block */
+    size_t bytes = 0;
+    lv_font_glyph_dsc_t src_glyph[GLYPH_ATLAS_MAX_GLYPHS];
+    for (const char *p = chars; *p != '\0'; p++) {
+        char c = *p;
+        if (c < ' ' || c > '~' || a->slot_of[(uint8_t)c] != 0) {
+            continue;
+        }
+        if (a->count == GLYPH_ATLAS_MAX_GLYPHS) {
+            ESP_LOGW(TAG, "More than %d characters - '%c' and on left out", GLYPH_ATLAS_MAX_GLYPHS, c);
+            break;
+        }
+        if (!source_glyph(font, c, &src_glyph[a->count])) {
+            continue;
+        }
+        a->chars[a->count] = c;
+        a->slot_of[(uint8_t)c] = ++a->count;
+        bytes += glyph_bytes(&src_glyph[a->count - 1]);
+    }
+
+    a->pixels = bytes > 0 ? heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, bytes, MALLOC_CAP_SPIRAM) : NULL;
+    if (bytes > 0 && a->pixels == NULL) {
+        ESP_LOGW(TAG, "No memory for %u bytes of glyphs - drawing from the font", (unsigned)bytes);
+        heap_caps_free(a);
+        return font;
+    }
+
+    /* Render, and take the pair advances while the font is at hand */
+    uint8_t *out = a->pixels;
+    for (unsigned s = 0; s < a->count; s++) {
+        lv_font_glyph_dsc_t *g = &src_glyph[s];
+        if (g->box_w > 0 && g->box_h > 0) {
+            render_glyph(g, out);
+            lv_draw_buf_init(&a->bitmap[s], g->box_w, g->box_h, LV_COLOR_FORMAT_A8,
+                             lv_draw_buf_width_to_stride(g->box_w, LV_COLOR_FORMAT_A8),
+                             out, (uint32_t)glyph_bytes(g));
+            out += glyph_bytes(g);
+        }
+
+        a->glyph[s] = *g;
+        a->glyph[s].format = LV_FONT_GLYPH_FORMAT_A8;
+        a->glyph[s].gid.index = s;
+        a->glyph[s].entry = NULL;
+
+        for (unsigned n = 0; n < a->count; n++) {
+            a->adv_pair[s][n] = lv_font_get_glyph_width(font, (uint32_t)a->chars[s], (uint32_t)a->chars[n]);
+        }
+    }
+
+    /* Same metrics as the original; everything else falls through to it */
+    a->font = *font;
+    a->font.get_glyph_dsc = atlas_get_glyph_dsc;
+    a->font.get_glyph_bitmap = atlas_get_glyph_bitmap;
+    a->font.release_glyph = NULL;
+    a->font.dsc = a;
+    a->font.fallback = font;
+    a->font.user_data = NULL;
+
+    atlases[index] = a;
+    stats.fonts++;
+    stats.glyphs += a->count;
+    stats.bitmap_bytes += bytes;
+    stats.table_bytes += sizeof(atlas_t);
+
+    ESP_LOGI(TAG, "Atlas %d: %u glyphs, line height %ld px, %u bytes of bitmaps + %u of tables",
+             index, a->count, (long)font->line_height, (unsigned)bytes, (unsigned)sizeof(atlas_t));
+    return &a->font;
+#else
+    (void)chars;
+    return font;
+#endif
+}
+
+void glyph_atlas_get_stats(glyph_atlas_stats_t *out)
+{
+    *out = stats;
+}
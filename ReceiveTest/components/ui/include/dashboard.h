@@ -0,0 +1,80 @@
+/*
+ * dashboard.h
+ * Telemetry channels bound to widgets through lv_observer subjects
+ *
+ * Every channel in DASHBOARD_BINDING_LIST gets one integer subject
+ * holding its fixed-point value, and a tile on the dashboard grid
+ * observing it. Other widgets can observe the same subject.
+ *
+ * Updates are staged as they are drained from the telemetry store and
+ * committed once per frame: a channel that changed ten times in a frame
+ * notifies its observers once, and one whose value came back the same
+ * does not notify at all. A label is only touched (and invalidated)
+ * when its formatted text differs from what it shows, so a frame costs
+ * what its changed widgets cost, not what the screen holds.
+ *
+ * LVGL task only (lock held), except dashboard_get_stats().
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lvgl.h"
+#include "telemetry_channels.h"
+
+/* Turns a fixed-point value into the text a widget shows. Same contract
+ * as telemetry_format_value(). */
+typedef int (*dashboard_format_t)(telemetry_channel_t channel, int32_t value, char *buf, size_t size);
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+
+/*  X(first channel,     last channel,      formatter) */
+#define DASHBOARD_BINDING_LIST(X)                                       \
+    X(CH_PACK_VOLTAGE,   CH_SOC,            telemetry_format_value)     \
+    X(CH_PACK_POWER,     CH_SOC_ENERGY,     telemetry_format_value)     \
+    X(CH_CELL_TEMP_1,    CH_CELL_TEMP_8,    telemetry_format_value)     \
+    X(CH_CELL_V_1,       CH_CELL_V_30,      telemetry_format_bare)
+
+#define DASHBOARD_TEXT_MAX      24      /* Formatted value, with terminator */
+#define DASHBOARD_EXTRA_VIEWS   16      /* dashboard_bind_label() calls beyond the tiles */
+
+/* Tile grid: 10 x 6 tiles fill the band between the data readout and
+ * the status line (1280 x 800 after rotation) */
+#define DASHBOARD_COLUMNS       10
+#define DASHBOARD_TILE_W        126
+#define DASHBOARD_TILE_H        48
+
+/* Counters since boot (read with dashboard_get_stats) */
+typedef struct {
+    uint32_t staged;        /* Channel updates handed to dashboard_stage() */
+    uint32_t notified;      /* Subject notifications (at most one per channel per commit) */
+    uint32_t redrawn;       /* Labels whose text actually changed */
+} dashboard_stats_t;
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Create the subjects and one tile per bound channel inside a new
+ * container on `parent`. Returns the container, for positioning. */
+lv_obj_t *dashboard_create(lv_obj_t *parent);
+
+/* Show `channel` on `label` as well, through its subject. Returns false
+ * if the channel is not bound or the view pool is full. */
+bool dashboard_bind_label(lv_obj_t *label, telemetry_channel_t channel, dashboard_format_t format);
+
+/* The subject behind `channel` (NULL if not bound), for binding other
+ * widgets - arcs, sliders - with the stock lv_*_bind_* helpers */
+lv_subject_t *dashboard_subject(telemetry_channel_t channel);
+
+/* Remember the newest value of `channel`. Unbound channels are ignored. */
+void dashboard_stage(telemetry_channel_t channel, int32_t value);
+
+/* Notify the observers of every channel staged since the last commit
+ * whose value changed. Returns the number of notifications. */
+size_t dashboard_commit(void);
+
+void dashboard_get_stats(dashboard_stats_t *stats);
@@ -0,0 +1,50 @@
+/*
+ * glyph_atlas.h
+ * Pre-rendered A8 glyphs for the characters dashboards draw all the time
+ *
+ * The built-in fonts store 4-bit glyphs. Every character drawn costs a
+ * binary search for its descriptor and an expansion of its bitmap to
+ * 8-bit coverage before it can be blended - for each character, every
+ * frame. glyph_atlas_create() does both once at startup for a chosen
+ * set of characters and returns a font that serves those from the
+ * atlas (a table lookup and a pointer), falling back to the original
+ * font for anything else. Same metrics, same kerning, same pixels.
+ *
+ * The coverage bitmaps go to PSRAM; a Montserrat 48 digit is about
+ * 1 KB.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "lvgl.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define GLYPH_ATLAS_ENABLED     1       /* 0: glyph_atlas_create() hands back the font as is */
+#define GLYPH_ATLAS_MAX_FONTS   4
+#define GLYPH_ATLAS_MAX_GLYPHS  32      /* Characters per font */
+
+/* Digits, separators, signs and the telemetry units */
+#define GLYPH_ATLAS_NUMERIC     "0123456789.,:-+% "
+#define GLYPH_ATLAS_DASHBOARD   GLYPH_ATLAS_NUMERIC "/ACVWhkmpr"
+
+/* Totals over all atlases (read with glyph_atlas_get_stats) */
+typedef struct {
+    unsigned fonts;
+    unsigned glyphs;
+    size_t bitmap_bytes;        /* A8 coverage, PSRAM */
+    size_t table_bytes;         /* Descriptors and kerning, PSRAM */
+} glyph_atlas_stats_t;
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Build an atlas of `chars` (printable ASCII) for `font`. Returns the
+ * font to use instead, or `font` itself when disabled, out of slots or
+ * out of memory - the caller never has to check. LVGL task only. */
+const lv_font_t *glyph_atlas_create(const lv_font_t *font, const char *chars);
+
+void glyph_atlas_get_stats(glyph_atlas_stats_t *stats);
@@ -0,0 +1,48 @@
+/*
+ * readout.h
+ * Numeric readout: fixed-pitch digits, redraws only the cells that change
+ *
+ * A label re-measures its whole text and invalidates its whole area on
+ * every lv_label_set_text(), even when only the last digit of "98.234 V"
+ * moved. A readout lays its text out in cells instead: every digit gets
+ * the same advance (the widest digit of the font), so a digit changing
+ * never moves anything after it. Other characters keep their natural
+ * width. readout_set_text() compares the new layout with the current
+ * one cell by cell and invalidates only the cells whose character or
+ * position changed - a ticking clock repaints one or two digits.
+ *
+ * Printable ASCII only (anything else shows as '?'). Text and layout
+ * live in a fixed slot - no allocation per update.
+ *
+ * LVGL task only (lock held), like any widget.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define READOUT_MAX_WIDGETS     4       /* Readouts alive at once */
+#define READOUT_MAX_CELLS       40      /* Characters per readout */
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Create a readout for up to `cells` characters (READOUT_MAX_CELLS at
+ * most) in `font`. Sized for `cells` digits and one line; resize it
+ * freely. Returns NULL when all READOUT_MAX_WIDGETS slots are taken. */
+lv_obj_t *readout_create(lv_obj_t *parent, const lv_font_t *font, uint8_t cells);
+
+/* Where the text sits when it is narrower than the widget (default:
+ * LV_TEXT_ALIGN_RIGHT, so units digits stay put as numbers grow) */
+void readout_set_align(lv_obj_t *obj, lv_text_align_t align);
+
+/* Show `text` (cut at the readout's cell count), invalidating only the
+ * cells that differ from what is shown */
+void readout_set_text(lv_obj_t *obj, const char *text);
+
+/* Current text */
+const char *readout_get_text(lv_obj_t *obj);
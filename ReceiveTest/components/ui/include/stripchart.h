@@ -0,0 +1,74 @@
+/*
+ * stripchart.h
+ * Sweeping strip chart: rasterizes and flushes the new columns only
+ *
+ * lv_chart in LV_CHART_UPDATE_MODE_SHIFT draws every point of every
+ * series and all division lines again after each lv_chart_set_next_value()
+ * - the cost of a frame grows with the width of the chart. A strip chart
+ * keeps its own RGB565 pixel buffer instead, used as a ring of columns.
+ * stripchart_advance() rasterizes only the new columns into it
+ * (background, grid, then each series) at the write position and moves
+ * the position on, wrapping at the right edge, like the sweep of a
+ * patient monitor. The image itself never moves on screen, so only the
+ * new columns are invalidated: the per-frame work, rendering and flush,
+ * is one column height per new column. (Scrolling the image instead
+ * would change every pixel of the widget, and in partial render mode
+ * all of them would have to be flushed again.)
+ *
+ * Samples pushed between two advances make up one column: every series
+ * draws the min..max of those samples as an envelope (its color blended
+ * with the background) and a line from the previous column's last sample
+ * to this one's. A column with no new samples holds the last value.
+ *
+ * Values are int32 like the telemetry store's fixed-point ones. The
+ * min/max/last of every column is kept too, so a new range, grid or
+ * colors re-rasterize the whole chart from it.
+ *
+ * The pixels are rasterized ahead of drawing, so the colors are set with
+ * stripchart_set_colors(), not through styles. The size is fixed at
+ * creation.
+ *
+ * LVGL task only (lock held), like any widget.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define STRIPCHART_MAX_WIDGETS      2       /* Strip charts alive at once */
+#define STRIPCHART_MAX_SERIES       4       /* Series per chart */
+#define STRIPCHART_MAX_WIDTH        1280    /* Columns (pixels) */
+#define STRIPCHART_ENVELOPE_OPA     LV_OPA_40   /* Envelope: series color over the background */
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+/* Create a `width` x `height` strip chart. Pixels and column history go
+ * to PSRAM (width * height * 2 + width * 48 bytes). Returns NULL when
+ * all STRIPCHART_MAX_WIDGETS slots are taken or out of memory. */
+lv_obj_t *stripchart_create(lv_obj_t *parent, int32_t width, int32_t height);
+
+/* Values drawn at the bottom and the top row (default 0..100) */
+void stripchart_set_range(lv_obj_t *obj, int32_t min, int32_t max);
+
+/* Background and grid colors (default black and dark gray) */
+void stripchart_set_colors(lv_obj_t *obj, lv_color_t bg, lv_color_t grid);
+
+/* Horizontal division lines (`rows` bands) and a vertical line every
+ * `column_spacing` columns. 0 turns either off. */
+void stripchart_set_grid(lv_obj_t *obj, uint8_t rows, uint16_t column_spacing);
+
+/* Add a series drawn in `color`. Returns its index, or -1 when the chart
+ * has STRIPCHART_MAX_SERIES already. */
+int stripchart_add_series(lv_obj_t *obj, lv_color_t color);
+
+/* Add a sample to the column being collected */
+void stripchart_push(lv_obj_t *obj, int series, int32_t value);
+
+/* Close the column being collected and sweep on by `columns` (the ones
+ * after the first hold the last values) */
+void stripchart_advance(lv_obj_t *obj, uint16_t columns);
@@ -1,7 +1,8 @@
 #pragma once
 #include "lvgl.h"
 
-/* Initialize the UI with a display */
+/* Initialize the UI with a display. Also starts the refresh timer that
+ * drains the telemetry mailbox once per frame (see mailbox.h). */
 void ui_init(lv_display_t *disp);
 
 /* Update the main display text (can be number, time, or any string) */
@@ -9,3 +10,7 @@ void ui_set_text(const char *text);
 
 /* Set the status line (shows IP address, connection status, etc.) */
 void ui_set_status(const char *status);
+
+/* Refresh and redraw now instead of at the next refresh period (for
+ * critical-lane frames). Never blocks - callable from the network task. */
+void ui_wake(void);
@@ -0,0 +1,270 @@
+/*
+ * readout.c
+ * Cell layout, per-cell diff and a draw callback that skips clean cells
+ *
+ * A readout is a plain lv_obj with no styles of its own besides the
+ * text font and color; its LV_EVENT_DRAW_MAIN handler draws one glyph
+ * per cell with lv_draw_character(), and only for cells that reach into
+ * the area being redrawn. Glyph advances of the printable ASCII range
+ * are looked up once at creation, so laying out a new text is a table
+ * walk, not a font search per character.
+ */
+
+#include "readout.h"
+
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "READOUT";
+
+/* Glyphs may overhang their advance by a pixel or two - invalidate and
+ * draw with this much margin either side of a cell */
+#define CELL_MARGIN     2
+
+#define FIRST_CHAR      ' '
+#define LAST_CHAR       '~'
+
+typedef struct {
+    lv_obj_t *obj;              /* NULL: slot free */
+    uint8_t cells;
+    uint8_t len;
+    lv_text_align_t align;
+    int32_t layout_w;           /* Widget width the cells were placed for */
+    uint8_t pitch;              /* Advance of every digit */
+    uint8_t advance[LAST_CHAR - FIRST_CHAR + 1];
+    char text[READOUT_MAX_CELLS + 1];
+    int16_t x[READOUT_MAX_CELLS];   /* Cell left edge, relative to the widget */
+    uint8_t w[READOUT_MAX_CELLS];
+} readout_t;
+
+static readout_t readouts[READOUT_MAX_WIDGETS];
+
+static readout_t *get(lv_obj_t *obj)
+{
+    readout_t *r = lv_obj_get_user_data(obj);
+    return r != NULL && r->obj == obj ? r : NULL;
+}
+
+/* ============================================================
+ * LAYOUT
+ * ============================================================ */
+typedef struct {
+    uint8_t len;
+    char text[READOUT_MAX_CELLS + 1];
+    int16_t x[READOUT_MAX_CELLS];
+    uint8_t w[READOUT_MAX_CELLS];
+} readout_layout_t;
+
+static void lay_out(const readout_t *r, const char *text, int32_t width, readout_layout_t *out)
+{
+    int32_t total = 0;
+    uint8_t n = 0;
+
+    for (; n < r->cells && text[n] != '\0'; n++) {
+        char c = text[n];
+        if (c < FIRST_CHAR || c > LAST_CHAR) {
+            c = '?';
+        }
+        out->text[n] = c;
+        out->w[n] = c >= '0' && c <= '9' ? r->pitch : r->advance[c - FIRST_CHAR];
+        total += out->w[n];
+    }
+    out->text[n] = '\0';
+    out->len = n;
+
+    int32_t x = r->align == LV_TEXT_ALIGN_LEFT ? 0 :
+                r->align == LV_TEXT_ALIGN_CENTER ? (width - total) / 2 : width - total;
+    for (uint8_t i = 0; i < n; i++) {
+        out->x[i] = (int16_t)x;
+        x += out->w[i];
+    }
+}
+
+/* Invalidate [x1, x2) of the widget, full height */
+static void invalidate_span(lv_obj_t *obj, int32_t x1, int32_t x2)
+{
+    lv_area_t area;
+    lv_obj_get_coords(obj, &area);
+    int32_t left = area.x1;
+    area.x1 = left + x1 - CELL_MARGIN;
+    area.x2 = left + x2 - 1 + CELL_MARGIN;
+    lv_obj_invalidate_area(obj, &area);
+}
+
+/* Apply a new layout, invalidating one span per run of changed cells */
+static void apply(readout_t *r, const readout_layout_t *next)
+{
+    uint8_t longest = r->len > next->len ? r->len : next->len;
+    int32_t run_x1 = 0, run_x2 = 0;
+    bool in_run = false;
+
+    for (uint8_t i = 0; i <= longest; i++) {
+        bool changed = false;
+        int32_t x1 = INT32_MAX, x2 = INT32_MIN;
+
+        if (i < longest) {
+            bool in_old = i < r->len, in_new = i < next->len;
+            changed = in_old != in_new ||
+                      r->text[i] != next->text[i] || r->x[i] != next->x[i] || r->w[i] != next->w[i];
+            if (changed && in_old) {
+                x1 = r->x[i];
+                x2 = r->x[i] + r->w[i];
+            }
+            if (changed && in_new) {
+                x1 = LV_MIN(x1, next->x[i]);
+                x2 = LV_MAX(x2, next->x[i] + next->w[i]);
+            }
+        }
+
+        if (changed && in_run) {
+            run_x1 = LV_MIN(run_x1, x1);
+            run_x2 = LV_MAX(run_x2, x2);
+        } else if (changed) {
+            run_x1 = x1;
+            run_x2 = x2;
+            in_run = true;
+        } else if (in_run) {
+            invalidate_span(r->obj, run_x1, run_x2);
+            in_run = false;
+        }
+    }
+
+    r->len = next->len;
+    memcpy(r->text, next->text, next->len + 1);
+    memcpy(r->x, next->x, next->len * sizeof(r->x[0]));
+    memcpy(r->w, next->w, next->len);
+}
+
+/* ============================================================
+ * EVENTS
+ * ============================================================ */
+static void draw_cells(readout_t *r, lv_layer_t *layer)
+{
+    lv_obj_t *obj = r->obj;
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    lv_obj_init_draw_label_dsc(obj, LV_PART_MAIN, &dsc);
+
+    const lv_area_t *clip = &layer->_clip_area;
+    for (uint8_t i = 0; i < r->len; i++) {
+        char c = r->text[i];
+        int32_t x = coords.x1 + r->x[i];
+        if (c == ' ' || x + r->w[i] + CELL_MARGIN <= clip->x1 || x - CELL_MARGIN > clip->x2) {
+            continue;
+        }
+
+        /* Digits are centred in their cell */
+        lv_point_t at = { x, coords.y1 };
+        if (c >= '0' && c <= '9') {
+            at.x += (r->pitch - r->advance[c - FIRST_CHAR]) / 2;
+        }
+        lv_draw_character(layer, &dsc, &at, (uint32_t)c);
+    }
+}
+
+static void readout_event_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    readout_t *r = get(obj);
+    if (r == NULL) {
+        return;
+    }
+
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_DRAW_MAIN:
+            draw_cells(r, lv_event_get_layer(e));
+            break;
+
+        case LV_EVENT_SIZE_CHANGED: {
+            /* Cells are placed for a width - place them again */
+            readout_layout_t next;
+            r->layout_w = lv_obj_get_width(obj);
+            lay_out(r, r->text, r->layout_w, &next);
+            apply(r, &next);
+            break;
+        }
+
+        case LV_EVENT_DELETE:
+            r->obj = NULL;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* ============================================================
+ * API
+ * ============================================================ */
+lv_obj_t *readout_create(lv_obj_t *parent, const lv_font_t *font, uint8_t cells)
+{
+    readout_t *r = NULL;
+    for (int i = 0; i < READOUT_MAX_WIDGETS; i++) {
+        if (readouts[i].obj == NULL) {
+            r = &readouts[i];
+            break;
+        }
+    }
+    if (r == NULL) {
+        ESP_LOGE(TAG, "All %d readouts in use - raise READOUT_MAX_WIDGETS", READOUT_MAX_WIDGETS);
+        return NULL;
+    }
+
+    memset(r, 0, sizeof(*r));
+    r->cells = cells < READOUT_MAX_CELLS ? cells : READOUT_MAX_CELLS;
+    r->align = LV_TEXT_ALIGN_RIGHT;
+    for (char c = FIRST_CHAR; c <= LAST_CHAR; c++) {
+        r->advance[c - FIRST_CHAR] = (uint8_t)lv_font_get_glyph_width(font, (uint32_t)c, 0);
+        if (c >= '0' && c <= '9' && r->advance[c - FIRST_CHAR] > r->pitch) {
+            r->pitch = r->advance[c - FIRST_CHAR];
+        }
+    }
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_style_text_font(obj, font, LV_PART_MAIN);
+    lv_obj_set_size(obj, r->cells * r->pitch, lv_font_get_line_height(font));
+    lv_obj_set_user_data(obj, r);
+    r->obj = obj;
+    r->layout_w = r->cells * r->pitch;
+
+    lv_obj_add_event_cb(obj, readout_event_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, readout_event_cb, LV_EVENT_SIZE_CHANGED, NULL);
+    lv_obj_add_event_cb(obj, readout_event_cb, LV_EVENT_DELETE, NULL);
+    return obj;
+}
+
+void readout_set_align(lv_obj_t *obj, lv_text_align_t align)
+{
+    readout_t *r = get(obj);
+    if (r == NULL || r->align == align) {
+        return;
+    }
+    r->align = align;
+
+    readout_layout_t next;
+    lay_out(r, r->text, r->layout_w, &next);
+    apply(r, &next);
+}
+
+void readout_set_text(lv_obj_t *obj, const char *text)
+{
+    readout_t *r = get(obj);
+    if (r == NULL || text == NULL) {
+        return;
+    }
+
+    readout_layout_t next;
+    lay_out(r, text, r->layout_w, &next);
+    apply(r, &next);
+}
+
+const char *readout_get_text(lv_obj_t *obj)
+{
+    readout_t *r = get(obj);
+    return r != NULL ? r->text : "";
+}
@@ -0,0 +1,405 @@
+/*
+ * stripchart.c
+ * Column ring, column rasterizer and the sweep invalidation
+ *
+ * The pixel buffer is an ordinary row-major RGB565 image, drawn as it is
+ * (buffer column x is screen column x), but its columns are used as a
+ * ring: `head` is the next column to write, and the newest column sits
+ * just before it. Writing a new column overwrites the oldest one and
+ * moves `head` on by one - nothing else in the buffer is touched, and
+ * only that column's area of the screen is invalidated.
+ *
+ * The column history runs in step with the pixels (same ring, same
+ * index), holding min/max/last per series, which is all a column needs
+ * to be drawn again.
+ */
+
+#include "stripchart.h"
+#include "src/lvgl_private.h"      /* lv_inv_area() */
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "STRIPCHART";
+
+#define NO_DATA     INT32_MIN       /* column_t.last of a series with no samples yet */
+
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int32_t last;
+} column_t;
+
+typedef struct {
+    lv_obj_t *obj;              /* NULL: slot free */
+    int32_t w, h;
+    uint16_t head;              /* Next buffer column to write (the oldest) */
+
+    int32_t range_min, range_max;
+    uint8_t grid_rows;
+    uint16_t grid_spacing;
+
+    uint8_t series_count;
+    lv_color_t series_color[STRIPCHART_MAX_SERIES];
+    uint16_t line_px[STRIPCHART_MAX_SERIES];
+    uint16_t envelope_px[STRIPCHART_MAX_SERIES];
+    lv_color_t bg_color;
+    uint16_t bg_px, grid_px;
+
+    column_t pending[STRIPCHART_MAX_SERIES];    /* Column being collected */
+    bool pending_has[STRIPCHART_MAX_SERIES];
+
+    column_t *history;          /* [w][STRIPCHART_MAX_SERIES], PSRAM */
+    uint16_t *pixels;           /* [h][w], PSRAM */
+    lv_image_dsc_t image;       /* Wraps `pixels` for lv_draw_image() */
+} stripchart_t;
+
+static stripchart_t charts[STRIPCHART_MAX_WIDGETS];
+
+static stripchart_t *get(lv_obj_t *obj)
+{
+    stripchart_t *s = obj != NULL ? lv_obj_get_user_data(obj) : NULL;
+    return s != NULL && s->obj == obj ? s : NULL;
+}
+
+/* ============================================================
+ * RASTER
+ * ============================================================ */
+
+/* Row of `value`, top row 0, clamped to the chart */
+static int32_t value_row(const stripchart_t *s, int32_t value)
+{
+    if (value <= s->range_min) {
+        return s->h - 1;
+    }
+    if (value >= s->range_max) {
+        return 0;
+    }
+    int64_t range = (int64_t)s->range_max - s->range_min;
+    int64_t from_bottom = (((int64_t)value - s->range_min) * (s->h - 1) + range / 2) / range;
+    return s->h - 1 - (int32_t)from_bottom;
+}
+
+/* Fill rows y1..y2 (either order) of the column starting at `px` */
+static void fill_span(const stripchart_t *s, uint16_t *px, int32_t y1, int32_t y2, uint16_t color)
+{
+    if (y1 > y2) {
+        int32_t t = y1;
+        y1 = y2;
+        y2 = t;
+    }
+    for (int32_t y = y1; y <= y2; y++) {
+        px[y * s->w] = color;
+    }
+}
+
+/* Draw buffer column `b` from its history. `prev` is the column before
+ * it in time, or NULL for the oldest. */
+static void raster_column(const stripchart_t *s, uint16_t b, const column_t *prev)
+{
+    uint16_t *px = s->pixels + b;
+    const column_t *col = &s->history[b * STRIPCHART_MAX_SERIES];
+
+    bool vertical = s->grid_spacing > 0 && b % s->grid_spacing == 0;
+    fill_span(s, px, 0, s->h - 1, vertical ? s->grid_px : s->bg_px);
+    if (!vertical && s->grid_rows > 0) {
+        for (int32_t r = 0; r <= s->grid_rows; r++) {
+            px[r * (s->h - 1) / s->grid_rows * s->w] = s->grid_px;
+        }
+    }
+
+    /* Envelopes first, so no series' line disappears under another's envelope */
+    for (uint8_t i = 0; i < s->series_count; i++) {
+        if (col[i].last != NO_DATA && col[i].min != col[i].max) {
+            fill_span(s, px, value_row(s, col[i].min), value_row(s, col[i].max), s->envelope_px[i]);
+        }
+    }
+    for (uint8_t i = 0; i < s->series_count; i++) {
+        if (col[i].last == NO_DATA) {
+            continue;
+        }
+        int32_t y = value_row(s, col[i].last);
+        int32_t from = prev != NULL && prev[i].last != NO_DATA ? value_row(s, prev[i].last) : y;
+        fill_span(s, px, from, y, s->line_px[i]);
+    }
+}
+
+static const column_t *prev_column(const stripchart_t *s, uint16_t b)
+{
+    return &s->history[((b + s->w - 1) % s->w) * STRIPCHART_MAX_SERIES];
+}
+
+/* Draw every column again */
+static void raster_all(stripchart_t *s)
+{
+    for (int32_t x = 0; x < s->w; x++) {
+        raster_column(s, (uint16_t)x, x != s->head ? prev_column(s, (uint16_t)x) : NULL);
+    }
+    lv_obj_invalidate(s->obj);
+}
+
+/* Invalidate buffer columns first..first+count-1 (no wrap) */
+static void invalidate_columns(const stripchart_t *s, int32_t first, int32_t count)
+{
+    lv_area_t area;
+    lv_obj_get_coords(s->obj, &area);
+    area.x1 += first;
+    area.x2 = area.x1 + count - 1;
+    area.y2 = area.y1 + s->h - 1;
+
+    /* Not lv_obj_invalidate_area(): LVGL 9.2 grows every area by a pixel
+     * right and down on its way through the transform, which would flush
+     * two columns per column. The chart is never transformed, so clip
+     * the visible part back to the columns and invalidate that. */
+    lv_area_t visible = area;
+    if (lv_obj_area_is_visible(s->obj, &visible) && lv_area_intersect(&area, &area, &visible)) {
+        lv_inv_area(lv_obj_get_display(s->obj), &area);
+    }
+}
+
+/* Pixel values of the background, grid and envelope colors */
+static void set_colors(stripchart_t *s, lv_color_t bg, lv_color_t grid)
+{
+    s->bg_color = bg;
+    s->bg_px = lv_color_to_u16(bg);
+    s->grid_px = lv_color_to_u16(grid);
+    for (uint8_t i = 0; i < s->series_count; i++) {
+        s->envelope_px[i] = lv_color_to_u16(lv_color_mix(s->series_color[i], bg, STRIPCHART_ENVELOPE_OPA));
+    }
+}
+
+/* ============================================================
+ * EVENTS
+ * ============================================================ */
+
+/* The buffer is drawn as it is - the sweep needs no rearranging */
+static void draw_image(stripchart_t *s, lv_layer_t *layer)
+{
+    lv_area_t coords;
+    lv_obj_get_coords(s->obj, &coords);
+
+    lv_draw_image_dsc_t dsc;
+    lv_draw_image_dsc_init(&dsc);
+    lv_obj_init_draw_image_dsc(s->obj, LV_PART_MAIN, &dsc);
+    dsc.src = &s->image;
+
+    lv_area_t at = { coords.x1, coords.y1, coords.x1 + s->w - 1, coords.y1 + s->h - 1 };
+    lv_draw_image(layer, &dsc, &at);
+}
+
+static void stripchart_event_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    stripchart_t *s = get(obj);
+    if (s == NULL) {
+        return;
+    }
+
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_DRAW_MAIN:
+            draw_image(s, lv_event_get_layer(e));
+            break;
+
+        case LV_EVENT_COVER_CHECK: {
+            /* Opaque: nothing behind the chart needs drawing */
+            const lv_area_t *area = lv_event_get_cover_area(e);
+            lv_area_t coords;
+            lv_obj_get_coords(obj, &coords);
+            coords.x2 = LV_MIN(coords.x2, coords.x1 + s->w - 1);
+            coords.y2 = LV_MIN(coords.y2, coords.y1 + s->h - 1);
+            bool inside = area->x1 >= coords.x1 && area->x2 <= coords.x2 &&
+                          area->y1 >= coords.y1 && area->y2 <= coords.y2;
+            lv_event_set_cover_res(e, inside && lv_obj_get_style_opa_recursive(obj, LV_PART_MAIN) == LV_OPA_COVER ?
+                                      LV_COVER_RES_COVER : LV_COVER_RES_NOT_COVER);
+            break;
+        }
+
+        case LV_EVENT_DELETE:
+            heap_caps_free(s->pixels);
+            heap_caps_free(s->history);
+            s->obj = NULL;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* ============================================================
+ * API
+ * ============================================================ */
+lv_obj_t *stripchart_create(lv_obj_t *parent, int32_t width, int32_t height)
+{
+    if (width < 2 || width > STRIPCHART_MAX_WIDTH || height < 2) {
+        ESP_LOGE(TAG, "Bad size %ldx%ld", (long)width, (long)height);
+        return NULL;
+    }
+
+    stripchart_t *s = NULL;
+    for (int i = 0; i < STRIPCHART_MAX_WIDGETS; i++) {
+        if (charts[i].obj == NULL) {
+            s = &charts[i];
+            break;
+        }
+    }
+    if (s == NULL) {
+        ESP_LOGE(TAG, "All %d strip charts in use - raise STRIPCHART_MAX_WIDGETS", STRIPCHART_MAX_WIDGETS);
+        return NULL;
+    }
+
+    size_t pixel_bytes = (size_t)width * height * sizeof(uint16_t);
+    size_t history_bytes = (size_t)width * STRIPCHART_MAX_SERIES * sizeof(column_t);
+    uint16_t *pixels = heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, pixel_bytes, MALLOC_CAP_SPIRAM);
+    column_t *history = heap_caps_malloc(history_bytes, MALLOC_CAP_SPIRAM);
+    if (pixels == NULL || history == NULL) {
+        ESP_LOGE(TAG, "No memory for a %ldx%ld strip chart", (long)width, (long)height);
+        heap_caps_free(pixels);
+        heap_caps_free(history);
+        return NULL;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->w = width;
+    s->h = height;
+    s->range_min = 0;
+    s->range_max = 100;
+    s->pixels = pixels;
+    s->history = history;
+    for (size_t i = 0; i < (size_t)width * STRIPCHART_MAX_SERIES; i++) {
+        history[i] = (column_t){ NO_DATA, NO_DATA, NO_DATA };
+    }
+
+    s->image.header.magic = LV_IMAGE_HEADER_MAGIC;
+    s->image.header.cf = LV_COLOR_FORMAT_RGB565;
+    s->image.header.w = width;
+    s->image.header.h = height;
+    s->image.header.stride = width * sizeof(uint16_t);
+    s->image.data = (const uint8_t *)pixels;
+    s->image.data_size = pixel_bytes;
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_size(obj, width, height);
+    lv_obj_set_user_data(obj, s);
+    s->obj = obj;
+
+    set_colors(s, lv_color_black(), lv_color_hex(0x404040));
+    raster_all(s);
+
+    lv_obj_add_event_cb(obj, stripchart_event_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, stripchart_event_cb, LV_EVENT_COVER_CHECK, NULL);
+    lv_obj_add_event_cb(obj, stripchart_event_cb, LV_EVENT_DELETE, NULL);
+
+    ESP_LOGI(TAG, "Strip chart %ldx%ld: %u bytes of pixels + %u of history",
+             (long)width, (long)height, (unsigned)pixel_bytes, (unsigned)history_bytes);
+    return obj;
+}
+
+void stripchart_set_range(lv_obj_t *obj, int32_t min, int32_t max)
+{
+    stripchart_t *s = get(obj);
+    if (s == NULL || min >= max || (s->range_min == min && s->range_max == max)) {
+        return;
+    }
+    s->range_min = min;
+    s->range_max = max;
+    raster_all(s);
+}
+
+void stripchart_set_colors(lv_obj_t *obj, lv_color_t bg, lv_color_t grid)
+{
+    stripchart_t *s = get(obj);
+    if (s == NULL) {
+        return;
+    }
+    set_colors(s, bg, grid);
+    raster_all(s);
+}
+
+void stripchart_set_grid(lv_obj_t *obj, uint8_t rows, uint16_t column_spacing)
+{
+    stripchart_t *s = get(obj);
+    if (s == NULL || (s->grid_rows == rows && s->grid_spacing == column_spacing)) {
+        return;
+    }
+    s->grid_rows = rows;
+    s->grid_spacing = column_spacing;
+    raster_all(s);
+}
+
+int stripchart_add_series(lv_obj_t *obj, lv_color_t color)
+{
+    stripchart_t *s = get(obj);
+    if (s == NULL || s->series_count == STRIPCHART_MAX_SERIES) {
+        return -1;
+    }
+
+    /* No samples yet, so nothing to draw again */
+    int i = s->series_count++;
+    s->series_color[i] = color;
+    s->line_px[i] = lv_color_to_u16(color);
+    s->envelope_px[i] = lv_color_to_u16(lv_color_mix(color, s->bg_color, STRIPCHART_ENVELOPE_OPA));
+    return i;
+}
+
+void stripchart_push(lv_obj_t *obj, int series, int32_t value)
+{
+    stripchart_t *s = get(obj);
+    if (s == NULL || series < 0 || series >= s->series_count || value == NO_DATA) {
+        return;
+    }
+
+    column_t *c = &s->pending[series];
+    if (!s->pending_has[series]) {
+        *c = (column_t){ value, value, value };
+        s->pending_has[series] = true;
+    } else {
+        c->min = LV_MIN(c->min, value);
+        c->max = LV_MAX(c->max, value);
+        c->last = value;
+    }
+}
+
+void stripchart_advance(lv_obj_t *obj, uint16_t columns)
+{
+    stripchart_t *s = get(obj);
+    if (s == NULL || columns == 0) {
+        return;
+    }
+
+    /* Sweeping the full width or more redraws it all anyway: skip to
+     * where the sweep ends up */
+    if (columns > s->w) {
+        s->head = (uint16_t)((s->head + columns - s->w) % s->w);
+        columns = (uint16_t)s->w;
+    }
+
+    uint16_t first = s->head;
+    for (uint16_t k = 0; k < columns; k++) {
+        uint16_t b = s->head;
+        column_t *col = &s->history[b * STRIPCHART_MAX_SERIES];
+        const column_t *prev = prev_column(s, b);
+
+        for (uint8_t i = 0; i < STRIPCHART_MAX_SERIES; i++) {
+            if (k == 0 && s->pending_has[i]) {
+                col[i] = s->pending[i];
+            } else {
+                col[i] = (column_t){ prev[i].last, prev[i].last, prev[i].last };
+            }
+        }
+
+        raster_column(s, b, prev);
+        s->head = (uint16_t)((b + 1) % s->w);
+    }
+    memset(s->pending_has, 0, sizeof(s->pending_has));
+
+    /* Only the new columns changed: up to the right edge, then from the
+     * left edge if the sweep wrapped */
+    int32_t to_edge = LV_MIN((int32_t)columns, s->w - first);
+    invalidate_columns(s, first, to_edge);
+    if (columns > to_edge) {
+        invalidate_columns(s, 0, columns - to_edge);
+    }
+}
@@ -1,23 +1,369 @@
 /*
  * ui.c
  * Simple UI with updatable text display and status line
+ *
+ * Incoming data does not touch LVGL directly: the network side posts
+ * into the mailbox (text) and the telemetry store (values), and a
+ * refresh timer running inside the LVGL task drains both once per
+ * display refresh period. ui_wake() runs that refresh (and a redraw)
+ * right away, for critical-lane frames.
  */
 
 #include "ui.h"
+#include "dashboard.h"
+#include "readout.h"
+#include "glyph_atlas.h"
+#include "stripchart.h"
+#include "mailbox.h"
+#include "telemetry_store.h"
+#include "history.h"
+#include "alarm.h"
+#include "stats.h"
+#include "latency.h"
+#include "link_quality.h"
 #include "esp_lvgl_port.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "lvgl.h"
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
 /* Widget pointers - stored globally so we can update them later */
-static lv_obj_t *data_label = NULL;    /* Main data display (time, number, text) */
+static lv_obj_t *data_readout = NULL;  /* Main data display (time, number, text) */
 static lv_obj_t *status_label = NULL;  /* Status line at bottom (IP address) */
+static lv_obj_t *alarm_label = NULL;   /* Alarm banner at top (hidden when no alarm) */
+static lv_obj_t *link_label = NULL;    /* Link quality, top left */
+static lv_obj_t *lap_label = NULL;     /* Lap statistics, top right */
+static lv_obj_t *trace_chart = NULL;   /* Live current trace, top */
+
+/* Drain the mailbox as often as LVGL redraws - more often is wasted work */
+#define UI_REFRESH_PERIOD_MS    LV_DEF_REFR_PERIOD
+
+/* Main data readout: characters kept and width (most of the 1280 px) */
+#define UI_DATA_CELLS           READOUT_MAX_CELLS
+#define UI_DATA_WIDTH           1200
+
+/* Live trace: pack and motor current over the last two minutes, one
+ * column per 100 ms. A column is fed from the history (history.h): one
+ * bucket over its 100 ms, so the envelope is the true min and max of
+ * every sample - the mailbox only keeps the newest value per frame. */
+#define UI_TRACE_WIDTH          1200
+#define UI_TRACE_HEIGHT         150
+#define UI_TRACE_COLUMN_US      100000
+#define UI_TRACE_MIN            0           /* 0 A (fixed-point, 3 decimals) */
+#define UI_TRACE_MAX            100000      /* 100 A */
+
+static const struct {
+    telemetry_channel_t channel;
+    uint32_t color;
+} ui_traces[] = {
+    { CH_PACK_CURRENT,  0x00FF00 },
+    { CH_MOTOR_CURRENT, 0xFFCC00 },
+};
+
+/* How often the latency figures on the status line are redrawn */
+#define UI_LATENCY_PERIOD_US    1000000
+
+/* Link quality indicator: window it is computed over, and the share of
+ * sequenced frames that must arrive for green / amber */
+#define UI_LINK_PERIOD_US       1000000
+#define UI_LINK_GOOD_PERMILLE   995
+#define UI_LINK_FAIR_PERMILLE   970
+
+/* Lap tile: mean and spread of one channel since the last lap marker
+ * (stats.h), redrawn once a second */
+#define UI_LAP_CHANNEL          CH_PACK_CURRENT
+#define UI_LAP_PERIOD_US        1000000
+
+/* ui_wake() helper task: must be able to preempt the LVGL task (4) */
+#define UI_WAKE_TASK_PRIORITY   5
+
+static const char *TAG = "UI";
+
+static lv_display_t *display = NULL;
+static lv_timer_t *refresh_timer = NULL;
+static TaskHandle_t wake_task = NULL;
+static bool wake_requested;             /* LVGL lock held for both read and write */
+
+/* Status text set by ui_set_status(), latency figures get appended */
+static char status_text[64] = "Initializing network...";
+static int64_t latency_shown_us;
+static uint32_t latency_shown_count;
+
+static int64_t link_shown_us;
+static link_stats_t link_shown;         /* Totals at the last indicator update */
+
+static int64_t lap_shown_us;
+
+static int64_t trace_column_us;         /* Start of the next trace column */
+
+/* ============================================================
+ * REFRESH
+ * Runs inside the LVGL task (lock already held)
+ * ============================================================ */
+
+/* Newest thing that arrived during this refresh period */
+typedef struct {
+    int64_t timestamp_us;
+    char text[MAILBOX_TEXT_MAX];
+} ui_newest_t;
+
+static void pick_newest_text(const mailbox_msg_t *msg, void *ctx)
+{
+    ui_newest_t *newest = ctx;
+    if (msg->timestamp_us >= newest->timestamp_us) {
+        newest->timestamp_us = msg->timestamp_us;
+        strcpy(newest->text, msg->text);
+    }
+}
+
+static void pick_newest_value(telemetry_channel_t channel, const telemetry_sample_t *sample,
+                              void *ctx)
+{
+    ui_newest_t *newest = ctx;
+    dashboard_stage(channel, sample->value);
+    if (sample->timestamp_us >= newest->timestamp_us) {
+        int n = snprintf(newest->text, sizeof(newest->text), "%s: ",
+                         telemetry_channel_info[channel].name);
+        telemetry_format_value(channel, sample->value, newest->text + n, sizeof(newest->text) - n);
+        newest->timestamp_us = sample->timestamp_us;
+    }
+}
+
+/* After alarm transitions, show the newest alarm still raised (the
+ * published summary, not the last event - that may be a clear) */
+static void apply_alarm_events(void)
+{
+    alarm_event_t ev;
+    bool changed = false;
+
+    while (alarm_pop_event(&ev)) {
+        changed = true;
+    }
+    if (!changed) {
+        return;
+    }
+
+    alarm_summary_t now;
+    alarm_get_summary(&now);
+    if (now.active == 0) {
+        lv_obj_add_flag(alarm_label, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+
+    char value[32];
+    telemetry_format_value(now.channel, now.value, value, sizeof(value));
+    lv_label_set_text_fmt(alarm_label, "%s %s: %s", telemetry_channel_info[now.channel].name,
+                          alarm_rule_name(now.rule), value);
+    lv_obj_set_style_bg_color(alarm_label,
+                              lv_color_hex(now.severity == ALARM_CRITICAL ? 0xCC0000 : 0xCC8800),
+                              LV_PART_MAIN);
+    lv_obj_remove_flag(alarm_label, LV_OBJ_FLAG_HIDDEN);
+}
+
+/* "LINK 99.8%  jitter 1.2 ms" over the last second. Loss only counts
+ * frames that carry sequence numbers; jitter is the worst channel. */
+static void update_link_label(int64_t now)
+{
+    link_stats_t total;
+    link_quality_get_total(&total);
+
+    uint32_t sequenced = total.sequenced - link_shown.sequenced;
+    uint32_t lost = total.lost - link_shown.lost;
+    uint32_t received = total.received - link_shown.received;
+    link_shown = total;
+
+    if (received == 0) {
+        lv_label_set_text(link_label, "LINK idle");
+        lv_obj_set_style_text_color(link_label, lv_color_hex(0xAAAAAA), LV_PART_MAIN);
+        return;
+    }
+
+    uint32_t worst_jitter = 0;
+    for (uint16_t ch = 0; ch < LINK_MAX_CHANNELS; ch++) {
+        link_stats_t s;
+        if (link_quality_get_channel(ch, &s) && now - s.last_rx_us < UI_LINK_PERIOD_US &&
+            s.jitter_us > worst_jitter) {
+            worst_jitter = s.jitter_us;
+        }
+    }
+
+    /* lost can be "negative" when late frames filled older gaps */
+    uint32_t expected = sequenced + ((int32_t)lost > 0 ? lost : 0);
+    uint32_t permille = expected ? (uint32_t)((uint64_t)sequenced * 1000 / expected) : 1000;
+    if (permille > 1000) {
+        permille = 1000;
+    }
+
+    lv_label_set_text_fmt(link_label, "LINK %lu.%lu%%  jitter %lu.%lu ms",
+                          (unsigned long)(permille / 10), (unsigned long)(permille % 10),
+                          (unsigned long)(worst_jitter / 1000),
+                          (unsigned long)(worst_jitter / 100 % 10));
+    lv_obj_set_style_text_color(link_label,
+                                lv_color_hex(permille >= UI_LINK_GOOD_PERMILLE ? 0x00CC44 :
+                                             permille >= UI_LINK_FAIR_PERMILLE ? 0xCC8800 : 0xCC0000),
+                                LV_PART_MAIN);
+}
+
+/* "LAP 3:07  Pack current avg 41.250 A  sd 6.004 A" since the last lap
+ * marker. The window restarts with the channel's first sample after
+ * the marker, so the time is from there. */
+static void update_lap_label(int64_t now)
+{
+    stats_snapshot_t s;
+    if (!stats_read(UI_LAP_CHANNEL, &s)) {
+        lv_label_set_text(lap_label, "LAP --");
+        return;
+    }
+
+    char mean[DASHBOARD_TEXT_MAX], sd[DASHBOARD_TEXT_MAX];
+    telemetry_format_value(UI_LAP_CHANNEL, (int32_t)lround(s.mean), mean, sizeof(mean));
+    telemetry_format_value(UI_LAP_CHANNEL, (int32_t)lround(sqrt(s.variance)), sd, sizeof(sd));
+
+    int64_t secs = (now - s.reset_us) / 1000000;
+    lv_label_set_text_fmt(lap_label, "LAP %lu:%02lu  %s avg %s  sd %s",
+                          (unsigned long)(secs / 60), (unsigned long)(secs % 60),
+                          telemetry_channel_info[UI_LAP_CHANNEL].name, mean, sd);
+}
+
+/* Close every trace column that has ended, each from the history of
+ * its own UI_TRACE_COLUMN_US. A late refresh catches up column by
+ * column; one later than the whole width only needs the last width. */
+static void advance_trace(int64_t now)
+{
+    int64_t due = (now - trace_column_us) / UI_TRACE_COLUMN_US;
+    if (due > UI_TRACE_WIDTH) {
+        trace_column_us += (due - UI_TRACE_WIDTH) * UI_TRACE_COLUMN_US;
+        due = UI_TRACE_WIDTH;
+    }
+
+    for (; due > 0; due--, trace_column_us += UI_TRACE_COLUMN_US) {
+        uint32_t from_ms = (uint32_t)(trace_column_us / 1000);
+        uint32_t to_ms = (uint32_t)((trace_column_us + UI_TRACE_COLUMN_US) / 1000) - 1;
+        for (size_t i = 0; i < sizeof(ui_traces) / sizeof(ui_traces[0]); i++) {
+            history_bucket_t bucket;
+            if (history_query_buckets(ui_traces[i].channel, from_ms, to_ms, &bucket, 1) == 0) {
+                continue;
+            }
+            /* The envelope, then the mean: the line runs through it */
+            stripchart_push(trace_chart, (int)i, bucket.min);
+            stripchart_push(trace_chart, (int)i, bucket.max);
+            stripchart_push(trace_chart, (int)i, history_bucket_mean(&bucket));
+        }
+        stripchart_advance(trace_chart, 1);
+    }
+}
+
+/* Status line: "<status>  |  p50 1.2 ms  p99 3.4 ms  max 5.6 ms" */
+static void update_status_label(const latency_summary_t *total)
+{
+    latency_shown_count = total->count;
+
+    if (total->count == 0) {
+        lv_label_set_text(status_label, status_text);
+        return;
+    }
+    lv_label_set_text_fmt(status_label, "%s  |  p50 %lu.%lu ms  p99 %lu.%lu ms  max %lu.%lu ms",
+                          status_text,
+                          (unsigned long)(total->p50_us / 1000), (unsigned long)(total->p50_us / 100 % 10),
+                          (unsigned long)(total->p99_us / 1000), (unsigned long)(total->p99_us / 100 % 10),
+                          (unsigned long)(total->max_us / 1000), (unsigned long)(total->max_us / 100 % 10));
+}
+
+static void ui_refresh_cb(lv_timer_t *timer)
+{
+    int64_t now = esp_timer_get_time();
+
+    apply_alarm_events();
+
+    ui_newest_t newest = { .timestamp_us = -1 };
+    size_t changed = mailbox_drain(pick_newest_text, &newest);
+    changed += telemetry_store_drain(now, pick_newest_value, &newest);
+
+    /* At most one readout update per frame, however many packets came
+     * in - and it only repaints the characters that changed */
+    if (changed > 0) {
+        readout_set_text(data_readout, newest.text);
+    }
+    dashboard_commit();
+
+    /* One trace column per UI_TRACE_COLUMN_US */
+    advance_trace(now);
+
+    /* Probes count as applied once this frame's updates are in. If
+     * nothing else changed, redraw the status line so a flush happens
+     * and the probe still gets its pixel timestamp. */
+    bool probes_waiting = latency_mark_applied(now);
+
+    if (now - latency_shown_us >= UI_LATENCY_PERIOD_US) {
+        latency_summary_t total;
+        latency_get_summary(LATENCY_RECV_TO_FLUSH, &total);
+        if (total.count != latency_shown_count) {
+            update_status_label(&total);
+        }
+        latency_shown_us = now;
+    }
+
+    if (now - link_shown_us >= UI_LINK_PERIOD_US) {
+        update_link_label(now);
+        link_shown_us = now;
+    }
+
+    if (now - lap_shown_us >= UI_LAP_PERIOD_US) {
+        update_lap_label(now);
+        lap_shown_us = now;
+    }
+
+    if (probes_waiting) {
+        lv_obj_invalidate(status_label);
+    }
+
+    /* Woken for a critical frame: draw now rather than on the display's
+     * next refresh period */
+    if (wake_requested) {
+        wake_requested = false;
+        lv_refr_now(display);
+    }
+}
+
+/* ============================================================
+ * WAKE
+ * The network task must never wait for the LVGL lock (a render can
+ * hold it for milliseconds), so ui_wake() only notifies this task,
+ * which waits for the lock instead.
+ * ============================================================ */
+static void ui_wake_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        lvgl_port_lock(0);
+        wake_requested = true;
+        lv_timer_ready(refresh_timer);
+        lvgl_port_unlock();
+        lvgl_port_task_wake(LVGL_PORT_EVENT_USER, NULL);
+    }
+}
+
+/* Last area of a frame handed to the panel */
+static void ui_flush_finish_cb(lv_event_t *e)
+{
+    lv_display_t *disp = lv_event_get_target(e);
+    if (lv_display_flush_is_last(disp)) {
+        latency_mark_flushed(esp_timer_get_time());
+    }
+}
 
 void ui_init(lv_display_t *disp)
 {
     /* Lock LVGL - required before any UI changes */
     lvgl_port_lock(0);
 
+    display = disp;
+
     /* Get the active screen (root container) */
     lv_obj_t *scr = lv_display_get_screen_active(disp);
 
@@ -38,40 +384,115 @@ void ui_init(lv_display_t *disp)
     lv_obj_align(title, LV_ALIGN_CENTER, 0, -100);
 
     /* --------------------------------------------------------
-     * Data label - shows the actual data (time, number, text)
-     * Green text, 48px, centered
+     * Data readout - shows the actual data (time, number, text)
+     * Green text, 48px, centered, fixed-pitch digits (readout.h),
+     * digits and units pre-rendered (glyph_atlas.h)
+     * -------------------------------------------------------- */
+    const lv_font_t *data_font = glyph_atlas_create(&lv_font_montserrat_48, GLYPH_ATLAS_DASHBOARD);
+    data_readout = readout_create(scr, data_font, UI_DATA_CELLS);
+    lv_obj_set_width(data_readout, UI_DATA_WIDTH);
+    readout_set_align(data_readout, LV_TEXT_ALIGN_CENTER);
+    readout_set_text(data_readout, "Waiting...");
+    lv_obj_set_style_text_color(data_readout, lv_color_hex(0x00FF00), LV_PART_MAIN);
+    lv_obj_align(data_readout, LV_ALIGN_CENTER, 0, 0);
+
+    /* --------------------------------------------------------
+     * Dashboard - one tile per bound channel (dashboard.h)
+     * Below the data readout, above the status line
      * -------------------------------------------------------- */
-    data_label = lv_label_create(scr);
-    lv_label_set_text(data_label, "Waiting...");
-    lv_obj_set_style_text_color(data_label, lv_color_hex(0x00FF00), LV_PART_MAIN);
-    lv_obj_set_style_text_font(data_label, &lv_font_montserrat_48, LV_PART_MAIN);
-    lv_obj_set_style_text_align(data_label, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
-    lv_obj_align(data_label, LV_ALIGN_CENTER, 0, 0);
+    lv_obj_t *dashboard = dashboard_create(scr);
+    lv_obj_align(dashboard, LV_ALIGN_BOTTOM_MID, 0, -70);
+
+    /* --------------------------------------------------------
+     * Live trace - pack and motor current (stripchart.h)
+     * Above the title, below the link indicator
+     * -------------------------------------------------------- */
+    trace_chart = stripchart_create(scr, UI_TRACE_WIDTH, UI_TRACE_HEIGHT);
+    if (trace_chart != NULL) {
+        stripchart_set_colors(trace_chart, lv_color_hex(0x001A33), lv_color_hex(0x335577));
+        stripchart_set_range(trace_chart, UI_TRACE_MIN, UI_TRACE_MAX);
+        stripchart_set_grid(trace_chart, 4, UI_TRACE_WIDTH / 12);
+        for (size_t i = 0; i < sizeof(ui_traces) / sizeof(ui_traces[0]); i++) {
+            stripchart_add_series(trace_chart, lv_color_hex(ui_traces[i].color));
+        }
+        lv_obj_align(trace_chart, LV_ALIGN_TOP_MID, 0, 70);
+    }
+    trace_column_us = esp_timer_get_time();
 
     /* --------------------------------------------------------
      * Status label - shows IP address and connection info
      * Gray text, 24px, bottom of screen
      * -------------------------------------------------------- */
     status_label = lv_label_create(scr);
-    lv_label_set_text(status_label, "Initializing network...");
+    lv_label_set_text(status_label, status_text);
     lv_obj_set_style_text_color(status_label, lv_color_hex(0xAAAAAA), LV_PART_MAIN);
     lv_obj_set_style_text_font(status_label, &lv_font_montserrat_24, LV_PART_MAIN);
     lv_obj_align(status_label, LV_ALIGN_BOTTOM_MID, 0, -30);
 
+    /* --------------------------------------------------------
+     * Alarm banner - shows the newest raised alarm
+     * White on red, 32px, top of screen, hidden until needed
+     * -------------------------------------------------------- */
+    alarm_label = lv_label_create(scr);
+    lv_label_set_text(alarm_label, "");
+    lv_obj_set_style_text_color(alarm_label, lv_color_white(), LV_PART_MAIN);
+    lv_obj_set_style_text_font(alarm_label, &lv_font_montserrat_32, LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(alarm_label, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(alarm_label, 12, LV_PART_MAIN);
+    lv_obj_align(alarm_label, LV_ALIGN_TOP_MID, 0, 30);
+    lv_obj_add_flag(alarm_label, LV_OBJ_FLAG_HIDDEN);
+
+    /* --------------------------------------------------------
+     * Link quality - share of frames that made it + jitter
+     * Gray until data arrives, 24px, top left
+     * -------------------------------------------------------- */
+    link_label = lv_label_create(scr);
+    lv_label_set_text(link_label, "LINK idle");
+    lv_obj_set_style_text_color(link_label, lv_color_hex(0xAAAAAA), LV_PART_MAIN);
+    lv_obj_set_style_text_font(link_label, &lv_font_montserrat_24, LV_PART_MAIN);
+    lv_obj_align(link_label, LV_ALIGN_TOP_LEFT, 20, 20);
+
+    /* --------------------------------------------------------
+     * Lap statistics - mean and spread since the last lap marker
+     * Gray, 24px, top right
+     * -------------------------------------------------------- */
+    lap_label = lv_label_create(scr);
+    lv_label_set_text(lap_label, "LAP --");
+    lv_obj_set_style_text_color(lap_label, lv_color_hex(0xAAAAAA), LV_PART_MAIN);
+    lv_obj_set_style_text_font(lap_label, &lv_font_montserrat_24, LV_PART_MAIN);
+    lv_obj_align(lap_label, LV_ALIGN_TOP_RIGHT, -20, 20);
+
+    /* --------------------------------------------------------
+     * Refresh timer - applies incoming data once per frame
+     * -------------------------------------------------------- */
+    refresh_timer = lv_timer_create(ui_refresh_cb, UI_REFRESH_PERIOD_MS, NULL);
+    lv_display_add_event_cb(disp, ui_flush_finish_cb, LV_EVENT_FLUSH_FINISH, NULL);
+
     /* Unlock LVGL - let background task render */
     lvgl_port_unlock();
+
+    if (xTaskCreate(ui_wake_task, "ui_wake", 2048, NULL, UI_WAKE_TASK_PRIORITY, &wake_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create wake task - critical frames wait for the next refresh");
+    }
+}
+
+void ui_wake(void)
+{
+    if (wake_task != NULL) {
+        xTaskNotifyGive(wake_task);
+    }
 }
 
 void ui_set_text(const char *text)
 {
     /* Safety check */
-    if (data_label == NULL || text == NULL) {
+    if (data_readout == NULL || text == NULL) {
         return;
     }
 
     /* Lock, update, unlock */
     lvgl_port_lock(0);
-    lv_label_set_text(data_label, text);
+    readout_set_text(data_readout, text);
     lvgl_port_unlock();
 }
 
@@ -84,6 +505,9 @@ void ui_set_status(const char *status)
 
     /* Lock, update, unlock */
     lvgl_port_lock(0);
-    lv_label_set_text(status_label, status);
+    snprintf(status_text, sizeof(status_text), "%s", status);
+    latency_summary_t total;
+    latency_get_summary(LATENCY_RECV_TO_FLUSH, &total);
+    update_status_label(&total);
     lvgl_port_unlock();
 }
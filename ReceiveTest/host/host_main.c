@@ -0,0 +1,216 @@
+/*
+ * host_main.c
+ * Linux entry point for the host build of ReceiveTest
+ *
+ * Runs the unmodified app_main() from main/main.c on its own thread
+ * (like the ESP-IDF main task) and replaces the two board-only pieces:
+ * the MIPI DSI panel bring-up and the Ethernet setup. The TCP/UDP
+ * server itself is the real net_server.c on POSIX sockets.
+ *
+ * Usage: receivetest_host [-d seconds] [-o screenshot.ppm] [-r recording.bin] [-q | -v]
+ *   -d  exit after this many seconds (default: run until killed)
+ *   -o  on exit, save the panel contents (headless backend only)
+ *   -r  flight recorder partition file (HOST_RECORDER_BYTES, created
+ *       if missing; without it the recorder is off)
+ *   -q  only warnings and errors    -v  debug logging
+ *
+ * On exit it prints the per-lane ingest counters (lanes.h) and the
+ * receive buffer pool occupancy (rx_pool.h), the clock sync estimate
+ * of every synced sender (clock_sync.h), the lap statistics of the
+ * pack current (stats.h), how many dashboard updates turned into
+ * redrawn labels (dashboard.h) and, with -r, the flight recorder
+ * counters (recorder.h).
+ */
+
+#include "display_init.h"
+#include "dashboard.h"
+#include "network.h"
+#include "net_server.h"
+#include "lanes.h"
+#include "link_quality.h"
+#include "rx_pool.h"
+#include "recorder.h"
+#include "clock_sync.h"
+#include "latency.h"
+#include "stats.h"
+#include "esp_partition.h"
+#include "esp_log.h"
+#include "esp_lvgl_port.h"
+#include "freertos/task.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define HOST_TCP_PORT   5000
+#define HOST_UDP_PORT   5001
+#define HOST_RECORDER_BYTES     (16 * 1024 * 1024)
+
+static const char *TAG = "HOST";
+
+void app_main(void);
+
+/* ============================================================
+ * BOARD REPLACEMENTS
+ * ============================================================ */
+
+/* No panel to bring up - the display backend lives in esp_lvgl_port.c */
+esp_lcd_panel_handle_t display_init(void)
+{
+    return NULL;
+}
+
+/* No Ethernet to bring up - listen on every local interface */
+esp_err_t network_init(network_data_callback_t callback, network_poll_callback_t poll)
+{
+    ESP_LOGI(TAG, "Host network: TCP %d, UDP %d", HOST_TCP_PORT, HOST_UDP_PORT);
+    return net_server_start(HOST_TCP_PORT, HOST_UDP_PORT, callback, poll);
+}
+
+const char *network_get_ip(void)
+{
+    return "0.0.0.0";
+}
+
+/* ============================================================
+ * MAIN
+ * ============================================================ */
+static void print_lane_stats(void)
+{
+    static const char *const names[NETWORK_LANE_COUNT] = { "critical", "bulk" };
+
+    for (int lane = 0; lane < NETWORK_LANE_COUNT; lane++) {
+        lane_stats_t s;
+        lanes_get_stats((network_lane_t)lane, &s);
+        if (s.dispatched == 0) {
+            continue;
+        }
+        printf("lane %-8s %9lu frames  wait p50 <%lu p99 <%lu max %lu us  "
+               "depth max %lu  overflows %lu\n",
+               names[lane], (unsigned long)s.dispatched, (unsigned long)s.p50_us + 1,
+               (unsigned long)s.p99_us + 1, (unsigned long)s.max_us,
+               (unsigned long)s.max_depth, (unsigned long)s.overflows);
+    }
+
+    rx_pool_stats_t pool;
+    net_server_stats_t server;
+    rx_pool_get_stats(&pool);
+    net_server_get_stats(&server);
+    printf("rx pool %lu/%d buffers high water, %lu in use, %lu gets, %lu exhausted, "
+           "%lu read stalls\n",
+           (unsigned long)pool.high_water, RX_POOL_BUFFERS, (unsigned long)pool.in_use,
+           (unsigned long)pool.gets, (unsigned long)pool.exhausted,
+           (unsigned long)server.pool_stalls);
+    printf("replies %lu held back for a full socket, %lu dropped (tx queue full)\n",
+           (unsigned long)server.tx_queued, (unsigned long)server.tx_dropped);
+    printf("server loop longest pass %lu us, stack %lu of %d bytes never used\n",
+           (unsigned long)server.pass_max_us, (unsigned long)server.stack_free_min,
+           NET_TASK_STACK_SIZE);
+
+    link_stats_t link;
+    link_quality_get_total(&link);
+    printf("link %lu frames (%lu sequenced, %lu lost, %lu duplicates, %lu reordered), "
+           "%lu on unknown channel ids\n",
+           (unsigned long)link.received, (unsigned long)link.sequenced, (unsigned long)link.lost,
+           (unsigned long)link.duplicates, (unsigned long)link.reordered,
+           (unsigned long)link.untracked);
+
+    recorder_stats_t rec;
+    recorder_get_stats(&rec);
+    if (rec.slots > 0) {
+        printf("recorder session %u: %lu frames, %lu dropped, %lu blocks (%lu write errors), "
+               "staged max %lu, slowest write %lu us\n",
+               rec.session, (unsigned long)rec.frames, (unsigned long)rec.dropped,
+               (unsigned long)rec.blocks, (unsigned long)rec.write_errors,
+               (unsigned long)rec.staged_max, (unsigned long)rec.write_max_us);
+    }
+
+    for (int i = 0; i < CLOCK_SYNC_MAX_PEERS; i++) {
+        clock_sync_peer_t peer;
+        if (!clock_sync_get_peer(i, &peer) || !peer.synced) {
+            continue;
+        }
+        printf("clock conn %lx: offset %lld us +-%lu, drift %.3f ppm, %lu exchanges "
+               "(%lu outliers)\n",
+               (unsigned long)peer.conn, (long long)peer.offset_us, (unsigned long)peer.error_us,
+               peer.drift_ppb / 1000.0, (unsigned long)peer.exchanges,
+               (unsigned long)peer.rejected);
+    }
+
+    latency_summary_t wire;
+    latency_get_summary(LATENCY_SEND_TO_RECV, &wire);
+    if (wire.count > 0) {
+        printf("probe send -> recv (synced clock) p50 %lu p99 %lu max %lu us\n",
+               (unsigned long)wire.p50_us, (unsigned long)wire.p99_us,
+               (unsigned long)wire.max_us);
+    }
+
+    stats_snapshot_t lap;
+    if (stats_read(CH_PACK_CURRENT, &lap)) {
+        printf("lap stats %s: %lu samples, mean %.3f sd %.3f [%ld, %ld] (raw units)\n",
+               telemetry_channel_info[CH_PACK_CURRENT].name, (unsigned long)lap.count,
+               lap.mean, sqrt(lap.variance), (long)lap.min, (long)lap.max);
+    }
+
+    dashboard_stats_t dash;
+    dashboard_get_stats(&dash);
+    if (dash.staged > 0) {
+        printf("dashboard %lu updates staged, %lu notified, %lu labels redrawn\n",
+               (unsigned long)dash.staged, (unsigned long)dash.notified,
+               (unsigned long)dash.redrawn);
+    }
+}
+
+static void app_main_task(void *arg)
+{
+    (void)arg;
+    app_main();
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = 0;
+    const char *screenshot = NULL;
+    int c;
+
+    while ((c = getopt(argc, argv, "d:o:r:qv")) != -1) {
+        switch (c) {
+            case 'd': seconds = atoi(optarg); break;
+            case 'o': screenshot = optarg; break;
+            case 'r':
+                if (esp_partition_host_attach(RECORDER_PARTITION_LABEL, RECORDER_PARTITION_SUBTYPE,
+                                              optarg, HOST_RECORDER_BYTES) != ESP_OK) {
+                    fprintf(stderr, "cannot open %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'q': esp_log_level_set("*", ESP_LOG_WARN); break;
+            case 'v': esp_log_level_set("*", ESP_LOG_DEBUG); break;
+            default:
+                fprintf(stderr, "usage: %s [-d seconds] [-o screenshot.ppm] [-r recording.bin] [-q | -v]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    xTaskCreate(app_main_task, "main", 8192, NULL, 1, NULL);
+
+    if (seconds <= 0) {
+        while (1) {
+            pause();
+        }
+    }
+    vTaskDelay(pdMS_TO_TICKS(seconds * 1000));
+
+    /* Exit from here (not from a task) so sanitizers and gprof see a
+     * normal process exit */
+    if (screenshot != NULL) {
+        lvgl_port_lock(0);
+        if (!lvgl_port_host_screenshot(screenshot)) {
+            ESP_LOGW(TAG, "Could not write %s", screenshot);
+        }
+        lvgl_port_unlock();
+    }
+    print_lane_stats();
+    return 0;
+}
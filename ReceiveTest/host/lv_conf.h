@@ -0,0 +1,63 @@
+/*
+ * lv_conf.h
+ * LVGL configuration for the host build - mirrors the CONFIG_LV_*
+ * values in ../sdkconfig so the host renders what the board renders.
+ * Anything not set here takes LVGL's default (lv_conf_internal.h).
+ */
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+/* Color / memory (CONFIG_LV_COLOR_DEPTH, CONFIG_LV_MEM_SIZE_KILOBYTES) */
+#define LV_COLOR_DEPTH              16
+#define LV_USE_STDLIB_MALLOC        LV_STDLIB_BUILTIN
+#define LV_USE_STDLIB_STRING        LV_STDLIB_BUILTIN
+#define LV_USE_STDLIB_SPRINTF       LV_STDLIB_BUILTIN
+#define LV_MEM_SIZE                 (128 * 1024U)
+
+/* Timing */
+#define LV_DEF_REFR_PERIOD          33
+#define LV_DPI_DEF                  130
+
+/* esp_lvgl_port provides the locking, LVGL itself is single-threaded */
+#define LV_USE_OS                   LV_OS_NONE
+
+/* Software renderer */
+#define LV_USE_DRAW_SW              1
+#define LV_DRAW_SW_DRAW_UNIT_CNT    1
+#define LV_DRAW_SW_COMPLEX          1
+#define LV_DRAW_SW_SHADOW_CACHE_SIZE 0
+#define LV_DRAW_SW_CIRCLE_CACHE_SIZE 4
+#define LV_DRAW_BUF_STRIDE_ALIGN    1
+#define LV_DRAW_BUF_ALIGN           4
+#define LV_DRAW_LAYER_SIMPLE_BUF_SIZE (24 * 1024)
+
+#define LV_USE_ASSERT_NULL          1
+#define LV_USE_ASSERT_MALLOC        1
+
+#define LV_CACHE_DEF_SIZE           0
+#define LV_IMAGE_HEADER_CACHE_DEF_CNT 0
+#define LV_GRADIENT_MAX_STOPS       2
+
+/* Fonts used by the UI */
+#define LV_FONT_MONTSERRAT_14       1
+#define LV_FONT_MONTSERRAT_24       1
+#define LV_FONT_MONTSERRAT_32       1
+#define LV_FONT_MONTSERRAT_48       1
+#define LV_FONT_DEFAULT             &lv_font_montserrat_14
+
+/* Others */
+#define LV_USE_OBSERVER             1
+
+/* Host display backends (selected by CMake) */
+#ifdef HOST_DISPLAY_SDL
+#define LV_USE_SDL                  1
+#define LV_SDL_INCLUDE_PATH         <SDL2/SDL.h>
+#define LV_SDL_RENDER_MODE          LV_DISPLAY_RENDER_MODE_PARTIAL
+#endif
+
+#ifdef HOST_DISPLAY_FBDEV
+#define LV_USE_LINUX_FBDEV          1
+#define LV_LINUX_FBDEV_RENDER_MODE  LV_DISPLAY_RENDER_MODE_PARTIAL
+#endif
+
+#endif /* LV_CONF_H */
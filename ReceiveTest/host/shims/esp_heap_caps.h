@@ -0,0 +1,37 @@
+/*
+ * esp_heap_caps.h (host shim)
+ * There is only one kind of memory on the host; caps are ignored.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_DEFAULT      (1 << 0)
+#define MALLOC_CAP_DMA          (1 << 1)
+#define MALLOC_CAP_SPIRAM       (1 << 2)
+#define MALLOC_CAP_INTERNAL     (1 << 3)
+#define MALLOC_CAP_8BIT         (1 << 4)
+
+static inline void *heap_caps_malloc(size_t size, unsigned caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void *heap_caps_calloc(size_t n, size_t size, unsigned caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+static inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, unsigned caps)
+{
+    (void)caps;
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static inline void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
@@ -0,0 +1,8 @@
+/*
+ * esp_lcd_panel_ops.h (host shim)
+ * The panel is owned by the host display backend (see esp_lvgl_port.c);
+ * the handle only has to exist so display_init.h compiles.
+ */
+#pragma once
+
+typedef struct esp_lcd_panel_t *esp_lcd_panel_handle_t;
@@ -0,0 +1,305 @@
+/*
+ * esp_lvgl_port.c (host shim)
+ * LVGL task, lock and display registration for the Linux build
+ *
+ * Mirrors what esp_lvgl_port does on the board: one task owns LVGL and
+ * runs lv_timer_handler() behind a recursive mutex, sleeping until the
+ * next timer is due or lvgl_port_task_wake() is called.
+ *
+ * Display backends (pick with -DHOST_DISPLAY=... at configure time):
+ *   headless  A draw buffer plus an 800x1280 "panel" frame buffer in
+ *             RAM. The flush does the same software rotation and copy
+ *             as the DSI path, so render cost is comparable.
+ *   sdl       LVGL's SDL window driver
+ *   fbdev     LVGL's Linux frame buffer driver ($FRAMEBUFFER or /dev/fb0)
+ */
+
+#include "esp_lvgl_port.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "LVGL_PORT";
+
+static pthread_mutex_t lvgl_mux;
+static pthread_mutex_t wake_mux = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake_cond;
+static uint32_t wake_events;
+static int max_sleep_ms;
+
+/* ============================================================
+ * TICK + TASK
+ * ============================================================ */
+static uint32_t host_tick_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* Sleep up to `ms`, or until lvgl_port_task_wake() */
+static void wait_for_event(uint32_t ms)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (long)(ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&wake_mux);
+    while (wake_events == 0 &&
+           pthread_cond_timedwait(&wake_cond, &wake_mux, &deadline) == 0) {
+    }
+    wake_events = 0;
+    pthread_mutex_unlock(&wake_mux);
+}
+
+static void lvgl_port_task(void *arg)
+{
+    uint32_t task_delay_ms = 0;
+
+    ESP_LOGI(TAG, "Starting LVGL task");
+    while (1) {
+        wait_for_event(task_delay_ms >= 1 ? task_delay_ms : 1);
+
+        if (lv_display_get_default() && lvgl_port_lock(0)) {
+            task_delay_ms = lv_timer_handler();
+            lvgl_port_unlock();
+        } else {
+            task_delay_ms = 1;
+        }
+
+        if (task_delay_ms == LV_NO_TIMER_READY) {
+            task_delay_ms = max_sleep_ms;
+        }
+    }
+}
+
+esp_err_t lvgl_port_init(const lvgl_port_cfg_t *cfg)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&lvgl_mux, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&wake_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    max_sleep_ms = cfg->task_max_sleep_ms ? cfg->task_max_sleep_ms : 500;
+
+    lv_init();
+    lv_tick_set_cb(host_tick_ms);
+
+    if (xTaskCreate(lvgl_port_task, "taskLVGL", cfg->task_stack, NULL,
+                    cfg->task_priority, NULL) != pdPASS) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+bool lvgl_port_lock(uint32_t timeout_ms)
+{
+    if (timeout_ms == 0) {
+        return pthread_mutex_lock(&lvgl_mux) == 0;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    return pthread_mutex_timedlock(&lvgl_mux, &deadline) == 0;
+}
+
+void lvgl_port_unlock(void)
+{
+    pthread_mutex_unlock(&lvgl_mux);
+}
+
+esp_err_t lvgl_port_task_wake(lvgl_port_event_type_t event, void *param)
+{
+    (void)param;
+    pthread_mutex_lock(&wake_mux);
+    wake_events |= event;
+    pthread_cond_signal(&wake_cond);
+    pthread_mutex_unlock(&wake_mux);
+    return ESP_OK;
+}
+
+/* ============================================================
+ * DISPLAY
+ * ============================================================ */
+#if defined(HOST_DISPLAY_SDL)
+
+lv_display_t *lvgl_port_add_disp_dsi(const lvgl_port_display_cfg_t *disp_cfg,
+                                     const lvgl_port_display_dsi_cfg_t *dsi_cfg)
+{
+    (void)dsi_cfg;
+    lv_display_t *disp = lv_sdl_window_create(disp_cfg->hres, disp_cfg->vres);
+    if (disp != NULL) {
+        lv_display_set_color_format(disp, disp_cfg->color_format);
+    }
+    return disp;
+}
+
+bool lvgl_port_host_screenshot(const char *path)
+{
+    (void)path;
+    return false;
+}
+
+#elif defined(HOST_DISPLAY_FBDEV)
+
+lv_display_t *lvgl_port_add_disp_dsi(const lvgl_port_display_cfg_t *disp_cfg,
+                                     const lvgl_port_display_dsi_cfg_t *dsi_cfg)
+{
+    (void)disp_cfg;
+    (void)dsi_cfg;
+    const char *fb = getenv("FRAMEBUFFER");
+
+    /* The frame buffer device decides resolution and pixel format */
+    lv_display_t *disp = lv_linux_fbdev_create();
+    if (disp != NULL) {
+        lv_linux_fbdev_set_file(disp, fb != NULL ? fb : "/dev/fb0");
+    }
+    return disp;
+}
+
+bool lvgl_port_host_screenshot(const char *path)
+{
+    (void)path;
+    return false;
+}
+
+#else /* headless */
+
+typedef struct {
+    uint8_t *rotate_buf;        /* Like draw_buffs[2] in the real port */
+    uint8_t *panel;             /* What the DSI panel would be showing */
+    uint32_t hres;
+    uint32_t vres;
+    uint32_t px_size;
+    bool sw_rotate;
+} host_panel_t;
+
+static host_panel_t panel;
+
+/* Same steps as lvgl_port_flush_callback() for the DSI panel: rotate in
+ * software, then copy the area into the panel's frame buffer */
+static void headless_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    lv_area_t a = *area;
+    lv_display_rotation_t rotation = lv_display_get_rotation(disp);
+
+    if (panel.sw_rotate && rotation != LV_DISPLAY_ROTATION_0) {
+        lv_color_format_t cf = lv_display_get_color_format(disp);
+        int32_t w = lv_area_get_width(&a);
+        int32_t h = lv_area_get_height(&a);
+        uint32_t w_stride = lv_draw_buf_width_to_stride(w, cf);
+        uint32_t h_stride = lv_draw_buf_width_to_stride(h, cf);
+
+        if (rotation == LV_DISPLAY_ROTATION_180) {
+            lv_draw_sw_rotate(px_map, panel.rotate_buf, w, h, w_stride, w_stride, rotation, cf);
+        } else {
+            lv_draw_sw_rotate(px_map, panel.rotate_buf, w, h, w_stride, h_stride, rotation, cf);
+        }
+        px_map = panel.rotate_buf;
+        lv_display_rotate_area(disp, &a);
+    }
+
+    /* "esp_lcd_panel_draw_bitmap" */
+    uint32_t row_bytes = lv_area_get_width(&a) * panel.px_size;
+    for (int32_t y = a.y1; y <= a.y2; y++) {
+        memcpy(panel.panel + ((size_t)y * panel.hres + a.x1) * panel.px_size, px_map, row_bytes);
+        px_map += row_bytes;
+    }
+
+    lv_display_flush_ready(disp);
+}
+
+lv_display_t *lvgl_port_add_disp_dsi(const lvgl_port_display_cfg_t *disp_cfg,
+                                     const lvgl_port_display_dsi_cfg_t *dsi_cfg)
+{
+    (void)dsi_cfg;
+
+    lv_display_t *disp = lv_display_create(disp_cfg->hres, disp_cfg->vres);
+    if (disp == NULL) {
+        return NULL;
+    }
+    lv_display_set_color_format(disp, disp_cfg->color_format);
+
+    panel.hres = disp_cfg->hres;
+    panel.vres = disp_cfg->vres;
+    panel.px_size = lv_color_format_get_size(disp_cfg->color_format);
+    panel.sw_rotate = disp_cfg->flags.sw_rotate;
+
+    size_t buf_bytes = (size_t)disp_cfg->buffer_size * panel.px_size;
+    uint8_t *buf1 = heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, buf_bytes, MALLOC_CAP_SPIRAM);
+    uint8_t *buf2 = disp_cfg->double_buffer ?
+                    heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, buf_bytes, MALLOC_CAP_SPIRAM) : NULL;
+    panel.rotate_buf = panel.sw_rotate ? heap_caps_malloc(buf_bytes, MALLOC_CAP_SPIRAM) : NULL;
+    panel.panel = heap_caps_calloc(1, (size_t)panel.hres * panel.vres * panel.px_size,
+                                   MALLOC_CAP_SPIRAM);
+    if (buf1 == NULL || (disp_cfg->double_buffer && buf2 == NULL) ||
+        (panel.sw_rotate && panel.rotate_buf == NULL) || panel.panel == NULL) {
+        ESP_LOGE(TAG, "Not enough memory for display buffers");
+        return NULL;
+    }
+
+    lv_display_set_buffers(disp, buf1, buf2, buf_bytes,
+                           disp_cfg->flags.full_refresh ? LV_DISPLAY_RENDER_MODE_FULL :
+                           disp_cfg->flags.direct_mode ? LV_DISPLAY_RENDER_MODE_DIRECT :
+                           LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(disp, headless_flush_cb);
+
+    ESP_LOGI(TAG, "Headless display %lux%lu, %lu bytes/px",
+             (unsigned long)panel.hres, (unsigned long)panel.vres, (unsigned long)panel.px_size);
+    return disp;
+}
+
+bool lvgl_port_host_screenshot(const char *path)
+{
+    if (panel.panel == NULL) {
+        return false;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return false;
+    }
+
+    /* PPM wants RGB; LVGL's RGB888 is stored B, G, R */
+    fprintf(f, "P6\n%lu %lu\n255\n", (unsigned long)panel.hres, (unsigned long)panel.vres);
+    const uint8_t *px = panel.panel;
+    for (size_t i = 0; i < (size_t)panel.hres * panel.vres; i++, px += panel.px_size) {
+        uint8_t rgb[3];
+        if (panel.px_size >= 3) {
+            rgb[0] = px[2];
+            rgb[1] = px[1];
+            rgb[2] = px[0];
+        } else {
+            uint16_t c = (uint16_t)(px[0] | (px[1] << 8));     /* RGB565 */
+            rgb[0] = (uint8_t)((c >> 11) << 3);
+            rgb[1] = (uint8_t)(((c >> 5) & 0x3F) << 2);
+            rgb[2] = (uint8_t)((c & 0x1F) << 3);
+        }
+        fwrite(rgb, 1, sizeof(rgb), f);
+    }
+    return fclose(f) == 0;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * esp_lvgl_port.h (host shim)
+ * The subset of esp_lvgl_port 2.x that the firmware uses, with the same
+ * types and names. The LVGL task runs on a pthread; the display goes to
+ * the backend chosen at configure time (HOST_DISPLAY in CMakeLists.txt).
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_ops.h"
+#include "lvgl.h"
+
+typedef enum {
+    LVGL_PORT_EVENT_DISPLAY = 0x01,
+    LVGL_PORT_EVENT_TOUCH   = 0x02,
+    LVGL_PORT_EVENT_USER    = 0x80,
+} lvgl_port_event_type_t;
+
+typedef struct {
+    int task_priority;
+    int task_stack;
+    int task_affinity;
+    int task_max_sleep_ms;
+    unsigned task_stack_caps;
+    int timer_period_ms;
+} lvgl_port_cfg_t;
+
+#define ESP_LVGL_PORT_INIT_CONFIG()                \
+    {                                              \
+        .task_priority = 4,                        \
+        .task_stack = 7168,                        \
+        .task_affinity = -1,                       \
+        .task_max_sleep_ms = 500,                  \
+        .task_stack_caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_DEFAULT, \
+        .timer_period_ms = 5,                      \
+    }
+
+typedef struct {
+    bool swap_xy;
+    bool mirror_x;
+    bool mirror_y;
+} lvgl_port_rotation_cfg_t;
+
+typedef struct {
+    void *io_handle;
+    esp_lcd_panel_handle_t panel_handle;
+    esp_lcd_panel_handle_t control_handle;
+
+    uint32_t buffer_size;           /* In pixels */
+    bool double_buffer;
+    uint32_t trans_size;
+
+    uint32_t hres;
+    uint32_t vres;
+
+    bool monochrome;
+
+    lvgl_port_rotation_cfg_t rotation;
+    lv_color_format_t color_format;
+    struct {
+        unsigned int buff_dma: 1;
+        unsigned int buff_spiram: 1;
+        unsigned int sw_rotate: 1;
+        unsigned int swap_bytes: 1;
+        unsigned int full_refresh: 1;
+        unsigned int direct_mode: 1;
+    } flags;
+} lvgl_port_display_cfg_t;
+
+typedef struct {
+    struct {
+        unsigned int avoid_tearing: 1;
+    } flags;
+} lvgl_port_display_dsi_cfg_t;
+
+esp_err_t lvgl_port_init(const lvgl_port_cfg_t *cfg);
+
+lv_display_t *lvgl_port_add_disp_dsi(const lvgl_port_display_cfg_t *disp_cfg,
+                                     const lvgl_port_display_dsi_cfg_t *dsi_cfg);
+
+/* Recursive, like the real one. timeout_ms == 0 waits forever. */
+bool lvgl_port_lock(uint32_t timeout_ms);
+void lvgl_port_unlock(void);
+
+esp_err_t lvgl_port_task_wake(lvgl_port_event_type_t event, void *param);
+
+/* ---- Host only ---- */
+
+/* Write what is on the (emulated) panel to a binary PPM, in panel
+ * orientation. Only the headless backend keeps a copy; returns false
+ * for the others or on I/O errors. Call with the LVGL lock held. */
+bool lvgl_port_host_screenshot(const char *path);
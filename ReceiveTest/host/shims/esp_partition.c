@@ -0,0 +1,100 @@
+/*
+ * esp_partition.c (host shim)
+ * One file-backed data partition, read/written with pread/pwrite
+ */
+
+#include "esp_partition.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ERASE_SIZE  4096
+
+static esp_partition_t attached = { .fd = -1 };
+
+static bool in_range(const esp_partition_t *p, size_t offset, size_t size)
+{
+    return p == &attached && p->fd >= 0 && offset <= p->size && size <= p->size - offset;
+}
+
+esp_err_t esp_partition_host_attach(const char *label, esp_partition_subtype_t subtype,
+                                    const char *path, uint32_t size)
+{
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return ESP_FAIL;
+    }
+
+    /* A new (or shorter) file gets erased sectors up to `size` */
+    struct stat st;
+    fstat(fd, &st);
+    if ((uint64_t)st.st_size < size) {
+        uint8_t erased[ERASE_SIZE];
+        memset(erased, 0xFF, sizeof(erased));
+        for (off_t off = st.st_size / ERASE_SIZE * ERASE_SIZE; off < (off_t)size; off += ERASE_SIZE) {
+            if (pwrite(fd, erased, ERASE_SIZE, off) != ERASE_SIZE) {
+                close(fd);
+                return ESP_FAIL;
+            }
+        }
+    }
+
+    attached = (esp_partition_t){
+        .type = ESP_PARTITION_TYPE_DATA,
+        .subtype = subtype,
+        .size = size / ERASE_SIZE * ERASE_SIZE,
+        .erase_size = ERASE_SIZE,
+        .fd = fd,
+    };
+    strncpy(attached.label, label, sizeof(attached.label) - 1);
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    if (attached.fd < 0 || attached.type != type || attached.subtype != subtype ||
+        (label != NULL && strcmp(label, attached.label) != 0)) {
+        return NULL;
+    }
+    return &attached;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset,
+                             void *dst, size_t size)
+{
+    if (!in_range(partition, offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return pread(partition->fd, dst, size, (off_t)offset) == (ssize_t)size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset,
+                              const void *src, size_t size)
+{
+    if (!in_range(partition, offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return pwrite(partition->fd, src, size, (off_t)offset) == (ssize_t)size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset,
+                                    size_t size)
+{
+    if (!in_range(partition, offset, size) || offset % ERASE_SIZE || size % ERASE_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t erased[ERASE_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+    for (size_t off = offset; off < offset + size; off += ERASE_SIZE) {
+        if (pwrite(partition->fd, erased, ERASE_SIZE, (off_t)off) != ERASE_SIZE) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
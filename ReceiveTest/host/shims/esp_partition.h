@@ -0,0 +1,44 @@
+/*
+ * esp_partition.h (host shim)
+ * Data partitions backed by files. A partition only exists once
+ * host_main.c has attached a file to its label; erase fills with 0xFF
+ * like NOR flash.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP  = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    uint32_t erase_size;
+    char label[17];
+    int fd;                 /* Host only: the backing file */
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char *label);
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset,
+                             void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset,
+                              const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset,
+                                    size_t size);
+
+/* Host only: back the data partition `label` with `path`, `size` bytes
+ * (created erased if it does not exist yet). Call before app_main(). */
+esp_err_t esp_partition_host_attach(const char *label, esp_partition_subtype_t subtype,
+                                    const char *path, uint32_t size);
@@ -0,0 +1,10 @@
+/*
+ * esp_timer.h (host shim)
+ */
+#pragma once
+
+#include <stdint.h>
+
+/* Microseconds of CLOCK_MONOTONIC (any fixed origin works - only
+ * differences are used) */
+int64_t esp_timer_get_time(void);
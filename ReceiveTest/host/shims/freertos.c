@@ -0,0 +1,213 @@
+/*
+ * freertos.c (host shim)
+ * FreeRTOS task calls on top of pthreads, plus the esp_timer clock
+ * and the esp_log level
+ */
+
+#define _GNU_SOURCE     /* pthread_setname_np() */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Every task stack is stack_depth plus this much, so host code (glibc,
+ * 64-bit pointers) can overrun the board's size without crashing - the
+ * high water mark below still reports the overrun. */
+#define HOST_STACK_SLACK        (1024 * 1024)
+#define HOST_STACK_PAINT        0xA5    /* Same fill FreeRTOS uses */
+
+/* What a TaskHandle_t points to. Never freed, like a FreeRTOS TCB of a
+ * task that is never deleted. */
+struct host_task {
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t mux;
+    pthread_cond_t cond;
+    uint32_t notify_count;
+    uint8_t *stack;             /* Lowest usable byte, NULL for foreign threads */
+    size_t stack_size;
+    uint8_t *stack_top;         /* Frame of the task function: glibc keeps its
+                                 * thread descriptor and TLS above it */
+    uint32_t stack_depth;       /* What the task asked for, in bytes */
+};
+
+static __thread struct host_task *current_task;
+
+static struct host_task *task_alloc(void)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task != NULL) {
+        pthread_condattr_t cond_attr;
+        pthread_condattr_init(&cond_attr);
+        pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+        pthread_mutex_init(&task->mux, NULL);
+        pthread_cond_init(&task->cond, &cond_attr);
+        pthread_condattr_destroy(&cond_attr);
+    }
+    return task;
+}
+
+static void *task_trampoline(void *p)
+{
+    current_task = p;
+    current_task->stack_top = __builtin_frame_address(0);
+    current_task->fn(current_task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)priority;
+
+    struct host_task *task = task_alloc();
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+
+    /* Own, painted stack with a guard page below it, so
+     * uxTaskGetStackHighWaterMark() can measure it */
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = ((size_t)stack_depth + HOST_STACK_SLACK + page - 1) / page * page;
+    uint8_t *map = mmap(NULL, size + page, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (map == MAP_FAILED) {
+        free(task);
+        return pdFAIL;
+    }
+    mprotect(map, page, PROT_NONE);
+    task->stack = map + page;
+    task->stack_size = size;
+    task->stack_depth = stack_depth;
+    memset(task->stack, HOST_STACK_PAINT, size);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, task->stack, size);
+    pthread_t thread;
+    int err = pthread_create(&thread, &attr, task_trampoline, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        munmap(map, size + page);
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+#ifdef __GLIBC__
+    pthread_setname_np(thread, name);   /* Shows up in perf / gdb */
+#endif
+
+    if (handle != NULL) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core)
+{
+    (void)core;
+    return xTaskCreate(fn, name, stack_depth, arg, priority, handle);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->mux);
+    task->notify_count++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->mux);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    if (current_task == NULL) {
+        current_task = task_alloc();    /* A thread not started by xTaskCreate */
+    }
+    struct host_task *task = current_task;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += ticks / 1000;
+    deadline.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&task->mux);
+    while (task->notify_count == 0) {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&task->cond, &task->mux);
+        } else if (pthread_cond_timedwait(&task->cond, &task->mux, &deadline) != 0) {
+            break;
+        }
+    }
+    uint32_t count = task->notify_count;
+    if (count > 0) {
+        task->notify_count = clear_on_exit ? 0 : count - 1;
+    }
+    pthread_mutex_unlock(&task->mux);
+    return count;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL) {
+        pthread_exit(NULL);
+    }
+    abort();    /* Killing another task is not supported */
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    if (task == NULL) {
+        task = current_task;
+    }
+    if (task == NULL || task->stack == NULL) {
+        return 0;
+    }
+
+    /* Stacks grow down: the paint left at the bottom was never touched */
+    size_t untouched = 0;
+    while (untouched < task->stack_size && task->stack[untouched] == HOST_STACK_PAINT) {
+        untouched++;
+    }
+    size_t used = (size_t)(task->stack_top - task->stack) - untouched;
+    return used < task->stack_depth ? (UBaseType_t)(task->stack_depth - used) : 0;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = { ticks / 1000, (long)(ticks % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+/* ============================================================
+ * esp_timer / esp_log
+ * ============================================================ */
+esp_log_level_t host_log_level = ESP_LOG_INFO;
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,22 @@
+/*
+ * FreeRTOS.h (host shim)
+ * Just enough of the FreeRTOS types for the firmware to build on Linux.
+ * One tick is one millisecond.
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 0
+#define pdTRUE                  1
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+
+#define configTICK_RATE_HZ      1000
+#define portTICK_PERIOD_MS      1
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
@@ -0,0 +1,35 @@
+/*
+ * task.h (host shim)
+ * FreeRTOS tasks mapped onto detached pthreads. Priorities and core
+ * affinity are accepted and ignored - the host scheduler decides. Stack
+ * sizes are only measured (uxTaskGetStackHighWaterMark), not enforced.
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core);
+
+/* Direct-to-task notifications, counting semaphore style only */
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+/* Only vTaskDelete(NULL) (end the calling task) is supported */
+void vTaskDelete(TaskHandle_t task);
+
+/* Bytes of the task's stack_depth never used so far (NULL = calling
+ * task), 0 once it has used all of it. Host code is 64-bit and calls
+ * glibc, so this is a guide to the board's figure, not the figure. */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+
+TickType_t xTaskGetTickCount(void);
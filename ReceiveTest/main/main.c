@@ -4,6 +4,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "lvgl.h"
 #include "esp_lvgl_port.h"
@@ -12,19 +13,211 @@
 #include "display_config.h"
 #include "ui.h"
 #include "network.h"
+#include "net_server.h"
+#include "frame_batch.h"
+#include "mailbox.h"
+#include "telemetry_store.h"
+#include "history.h"
+#include "alarm.h"
+#include "derived.h"
+#include "stats.h"
+#include "latency.h"
+#include "clock_sync.h"
+#include "trace.h"
+#include "recorder.h"
 
 static const char *TAG = "ReceiveTest";
 
+/*
+ * A value now in the store: history for charts, running statistics,
+ * and alarm rules checked right away (not on the next UI frame).
+ * Derived channels come through here too.
+ **/
+static void publish_value(uint16_t channel, int32_t value, int64_t now)
+{
+    history_append(channel, value, now);
+    stats_update(channel, value, now);
+    alarm_evaluate(channel, value, now);
+}
+
+/*
+ * One received numeric sample. Derived channels that read it are only
+ * marked here and recomputed once at the end of the frame.
+ **/
+static void handle_value(uint16_t channel, int32_t value, int64_t now)
+{
+    if (derived_is_output(channel)) {
+        TRACE(DERIVED_SENT, channel);
+        return;
+    }
+    if (!telemetry_store_update(channel, value, now)) {
+        TRACE(UNKNOWN_CHANNEL, channel);
+        return;
+    }
+    publish_value(channel, value, now);
+    derived_input_changed(channel);
+}
+
+/*
+ * Many samples in one frame. Each is timestamped by its age relative to
+ * `base` - when the frame arrived, or for BATCH_TS frames when it was
+ * sent, mapped to our clock.
+ **/
+static void handle_batch(const uint8_t *payload, size_t length, int64_t base)
+{
+    frame_batch_reader_t reader;
+    frame_batch_sample_t sample;
+    int32_t count = 0;
+
+    frame_batch_reader_init(&reader, payload, length);
+    while (frame_batch_next(&reader, &sample)) {
+        handle_value(sample.channel, sample.value, base - sample.age_us);
+        count++;
+    }
+    if (reader.error) {
+        TRACE(BAD_BATCH, count, length);
+    }
+}
+
+/*
+ * A time on the sender's clock in ours. Falls back to the arrival time
+ * until the sender is synced, and never later than that - nothing
+ * arrives before it was sent.
+ **/
+static int64_t sender_to_local(const network_rx_info_t *rx, uint64_t sender_us)
+{
+    int64_t local;
+    if (!clock_sync_to_local(rx->conn, sender_us, &local) || local > rx->rx_time_us) {
+        return rx->rx_time_us;
+    }
+    return local;
+}
+
+/*
+ * Clock sync request: answer right away (t3 as late as possible) and
+ * let clock_sync finish the previous exchange.
+ **/
+static void handle_time_request(const frame_t *frame, const network_rx_info_t *rx)
+{
+    uint8_t payload[FRAME_TIME_RESP_SIZE];
+    uint8_t out[FRAME_HEADER_SIZE + FRAME_TIME_RESP_SIZE + FRAME_CRC_SIZE];
+    uint32_t seq = frame_read_u32(frame->payload);
+    uint64_t t1 = frame_read_u64(frame->payload + 4);
+    uint64_t prev_t4 = frame_read_u64(frame->payload + 12);
+
+    frame_write_u32(payload, seq);
+    frame_write_u64(payload + 4, t1);
+    frame_write_u64(payload + 12, (uint64_t)rx->rx_time_us);
+
+    int64_t t3 = esp_timer_get_time();
+    frame_write_u64(payload + 20, (uint64_t)t3);
+    size_t n = frame_encode(out, sizeof(out), FRAME_TYPE_TIME_RESP, 0, payload, sizeof(payload));
+    if (net_server_send(rx->conn, out, n) < 0) {
+        return;     /* Never reached the sender - no exchange to finish */
+    }
+    clock_sync_exchange(rx->conn, seq, t1, prev_t4, rx->rx_time_us, t3);
+}
+
 /* 
  * DATA CALLBACK
- * Called by network component when TCP data arrives
+ * Called by network component for every complete frame.
+ * Runs in the network task - only writes to the mailbox / telemetry
+ * store, never touches LVGL. The UI picks up the newest values on its
+ * next refresh, or right away for frames from the critical lane.
+ **/
+static void on_data_received(const frame_t *frame, const network_rx_info_t *rx)
+{
+    int64_t now = rx->rx_time_us;
+
+    switch (frame->type) {
+        case FRAME_TYPE_TEXT:
+            TRACE(TEXT_POSTED, frame->channel, frame->length);
+            mailbox_post_text(frame->channel, (const char *)frame->payload, frame->length, now);
+            break;
+        case FRAME_TYPE_VALUE:
+            if (frame->length == 4) {
+                handle_value(frame->channel, (int32_t)frame_read_u32(frame->payload), now);
+                derived_flush(now, publish_value);
+            }
+            break;
+        case FRAME_TYPE_BATCH:
+            handle_batch(frame->payload, frame->length, now);
+            derived_flush(now, publish_value);
+            break;
+        case FRAME_TYPE_BATCH_TS:
+            if (frame->length >= FRAME_BATCH_STAMP_SIZE) {
+                handle_batch(frame->payload + FRAME_BATCH_STAMP_SIZE,
+                             frame->length - FRAME_BATCH_STAMP_SIZE,
+                             sender_to_local(rx, frame_read_u64(frame->payload)));
+                derived_flush(now, publish_value);
+            }
+            break;
+        case FRAME_TYPE_PROBE:
+            if (frame->length == FRAME_PROBE_SIZE) {
+                /* A probe that came over UDP is answered (and its clock
+                 * synced) on the TCP connection from the same sender */
+                int32_t conn = rx->conn == NETWORK_CONN_UDP ? net_server_find_conn(rx->peer_addr)
+                                                            : rx->conn;
+                uint64_t sender_ts = frame_read_u64(frame->payload + 4);
+                int64_t sent;
+                if (!clock_sync_to_local(conn, sender_ts, &sent)) {
+                    sent = -1;
+                }
+                latency_probe_received(conn, frame_read_u32(frame->payload), sender_ts,
+                                       sent, now);
+            }
+            break;
+        case FRAME_TYPE_TIME_REQ:
+            if (frame->length == FRAME_TIME_REQ_SIZE && rx->conn != NETWORK_CONN_UDP) {
+                handle_time_request(frame, rx);
+            }
+            break;
+        case FRAME_TYPE_LAP:
+            /* Mean/variance/min/max start over with each channel's
+             * next sample */
+            stats_request_reset_all();
+            break;
+        default:
+            TRACE(UNKNOWN_FRAME_TYPE, frame->type, frame->channel);
+            break;
+    }
+
+    if (rx->lane == NETWORK_LANE_CRITICAL) {
+        ui_wake();
+    }
+}
+
+/*
+ * POLL CALLBACK
+ * Runs in the network task between receives. Sends back latency probes
+ * the UI has finished putting on screen, and lets the flight recorder
+ * hand a quiet block to flash.
  **/
-static void on_data_received(const char *data, int length)
+static void on_network_poll(void)
 {
-    ESP_LOGI(TAG, "Updating display with: %s", data);
+    latency_ack_t ack;
+    latency_summary_t total;
+    uint8_t payload[FRAME_PROBE_ACK_SIZE];
+    uint8_t out[FRAME_HEADER_SIZE + FRAME_PROBE_ACK_SIZE + FRAME_CRC_SIZE];
 
-    /* Update the main display with received data */
-    ui_set_text(data);
+    while (latency_pop_ack(&ack)) {
+        latency_get_summary(LATENCY_RECV_TO_FLUSH, &total);
+
+        frame_write_u32(payload + 0, ack.seq);
+        frame_write_u64(payload + 4, ack.sender_ts_us);
+        frame_write_u32(payload + 12, ack.recv_to_apply_us);
+        frame_write_u32(payload + 16, ack.apply_to_flush_us);
+        frame_write_u32(payload + 20, total.p50_us);
+        frame_write_u32(payload + 24, total.p99_us);
+        frame_write_u32(payload + 28, total.max_us);
+
+        size_t n = frame_encode(out, sizeof(out), FRAME_TYPE_PROBE_ACK, 0, payload, sizeof(payload));
+        if (net_server_send(ack.conn, out, n) < 0) {
+            TRACE(PROBE_ACK_DROPPED, ack.seq);
+        }
+    }
+
+    recorder_poll(esp_timer_get_time());
 }
 
 // MAIN ENTRY POINT
@@ -32,6 +225,9 @@ void app_main(void)
 {
     ESP_LOGI(TAG, "Starting ReceiveTest");
 
+    /* Deferred logging first, so every later step can trace */
+    trace_init();
+
     /* 
      * Step 1: Initialize display hardware
      * - Turns on backlight
@@ -76,12 +272,36 @@ void app_main(void)
     ui_init(disp);
 
     /*
-     * Step 5: Initialize network
+     * Step 5: Allocate channel history, compile alarm rules and the
+     * derived channel graph
+     * - Per-channel ring buffers in PSRAM (last few minutes of data)
+     * - Alarm rules from alarm_rules.h, checked on every sample
+     * - Derived channels from derived_rules.h (pack power, min cell...)
+     * - Running mean/variance/EWMAs for the channels in stats.h
+     **/
+    history_init(HISTORY_DEFAULT_BUDGET_BYTES);
+    alarm_init();
+    derived_init();
+    stats_init();
+
+    /*
+     * Step 5b: Start the flight recorder
+     * - Every received frame goes to the "recorder" flash partition,
+     *   straight from the parser (before dedup and the lanes)
+     * - Runs without it if the partition is missing
+     **/
+    if (recorder_init() == ESP_OK) {
+        net_server_set_frame_tap(recorder_record);
+    }
+
+    /*
+     * Step 6: Initialize network
      * - Sets up Ethernet with static IP (192.168.1.100)
      * - Starts TCP server on port 5000
      * - Calls on_data_received() when data arrives
+     * - Calls on_network_poll() between receives (probe acks)
      **/
-    network_init(on_data_received);
+    network_init(on_data_received, on_network_poll);
 
     /* Update status with IP address */
     char status_msg[64];
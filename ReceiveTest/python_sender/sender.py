@@ -10,7 +10,9 @@ Usage:
 3. Run this script: python sender.py
 """
 
+import binascii
 import socket
+import struct
 import time
 import tkinter as tk
 from tkinter import ttk
@@ -23,6 +25,134 @@ import threading
 ESP32_IP = "192.168.1.100"
 ESP32_PORT = 5000
 
+# ============================================================
+# FRAMING - Must match components/network/include/frame.h
+# ============================================================
+FRAME_SYNC = 0xA5
+FRAME_VERSION = 0x01
+FRAME_MAX_PAYLOAD = 512
+
+FRAME_TYPE_TEXT = 0x01
+FRAME_TYPE_VALUE = 0x02
+FRAME_TYPE_PROBE = 0x03
+FRAME_TYPE_PROBE_ACK = 0x04
+FRAME_TYPE_BATCH = 0x05
+FRAME_TYPE_TIME_REQ = 0x06
+FRAME_TYPE_TIME_RESP = 0x07
+FRAME_TYPE_BATCH_TS = 0x08
+FRAME_TYPE_LAP = 0x09
+
+FRAME_FLAG_SEQ = 0x01
+FRAME_FLAG_CRITICAL = 0x02      # Receiver handles it ahead of all bulk traffic
+
+FRAME_BATCH_CHANNEL = 0xFFFF    # Header channel of batch frames
+FRAME_BATCH_MAX_PAYLOAD = FRAME_MAX_PAYLOAD - 2
+
+def encode_frame(frame_type, channel, payload, seq=None, critical=False):
+    """Build one length-prefixed frame: header + payload + CRC-16/CCITT-FALSE.
+    With `seq`, the frame carries that per-channel sequence number.
+    `critical` is for faults and trips: they skip the receiver's bulk queue."""
+    flags = FRAME_FLAG_CRITICAL if critical else 0
+    if seq is not None:
+        flags |= FRAME_FLAG_SEQ
+        payload = struct.pack("<H", seq & 0xFFFF) + payload
+    if len(payload) > FRAME_MAX_PAYLOAD:
+        raise ValueError(f"payload too long ({len(payload)} > {FRAME_MAX_PAYLOAD})")
+    body = struct.pack("<BBBBHH", FRAME_SYNC, FRAME_VERSION, frame_type, flags,
+                       channel, len(payload)) + payload
+    return body + struct.pack("<H", binascii.crc_hqx(body, 0xFFFF))
+
+# Next sequence number per channel, so the receiver can spot gaps
+_channel_seq = {}
+
+def next_seq(channel):
+    seq = _channel_seq.get(channel, 0)
+    _channel_seq[channel] = (seq + 1) & 0xFFFF
+    return seq
+
+def encode_text(text, critical=False):
+    return encode_frame(FRAME_TYPE_TEXT, 0, text.encode('utf-8'), next_seq(0), critical)
+
+def encode_value(channel, value):
+    return encode_frame(FRAME_TYPE_VALUE, channel, struct.pack("<i", value), next_seq(channel))
+
+def _varint(v):
+    out = bytearray()
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+    return out
+
+def _zigzag(v):
+    """Signed -> unsigned varint input (0, -1, 1, -2 ... -> 0, 1, 2, 3 ...)"""
+    v = ((v + 0x80000000) & 0xFFFFFFFF) - 0x80000000     # wrap like int32
+    return ((v << 1) ^ (v >> 31)) & 0xFFFFFFFF
+
+def encode_batch(samples, stamp_us=None):
+    """Many samples in as few BATCH frames as fit (see frame_batch.h).
+    `samples` is a list of (channel, age_us, value); age_us is how long
+    ago the sample was taken. With `stamp_us` (our clock now), sends
+    BATCH_TS frames so a receiver synced to our clock can place the
+    samples exactly. Returns the frames as one bytes object."""
+    frame_type = FRAME_TYPE_BATCH if stamp_us is None else FRAME_TYPE_BATCH_TS
+    prefix = b"" if stamp_us is None else struct.pack("<Q", stamp_us)
+    out = bytearray()
+    payload = bytearray(prefix)
+    last_ch = last_age = last_val = 0
+
+    # Channel-major, oldest first: keeps the deltas small
+    for ch, age, val in sorted(samples, key=lambda s: (s[0], -s[1])):
+        base = last_val if ch == last_ch else 0
+        tup = _varint(_zigzag(ch - last_ch)) + _varint(_zigzag(age - last_age)) + \
+              _varint(_zigzag(val - base))
+        if len(payload) + len(tup) > FRAME_BATCH_MAX_PAYLOAD:
+            out += encode_frame(frame_type, FRAME_BATCH_CHANNEL, bytes(payload),
+                                next_seq(FRAME_BATCH_CHANNEL))
+            payload = bytearray(prefix)
+            last_ch = last_age = last_val = 0
+            tup = _varint(_zigzag(ch)) + _varint(_zigzag(age)) + _varint(_zigzag(val))
+        payload += tup
+        last_ch, last_age, last_val = ch, age, val
+
+    if len(payload) > len(prefix):
+        out += encode_frame(frame_type, FRAME_BATCH_CHANNEL, bytes(payload),
+                            next_seq(FRAME_BATCH_CHANNEL))
+    return bytes(out)
+
+def encode_lap():
+    """Lap marker: the ESP32 restarts its lap statistics (mean, spread, min/max)"""
+    return encode_frame(FRAME_TYPE_LAP, 0, b"")
+
+def encode_probe(seq):
+    """Latency probe stamped with our clock; the ESP32 echoes it back once on screen"""
+    return encode_frame(FRAME_TYPE_PROBE, 0, struct.pack("<IQ", seq, time.monotonic_ns() // 1000))
+
+def decode_probe_ack(payload):
+    """PROBE_ACK payload -> dict of stage latencies (us), plus our round trip"""
+    seq, sent_us, recv_apply, apply_flush, p50, p99, max_us = struct.unpack("<IQIIIII", payload)
+    return {
+        "seq": seq,
+        "rtt_us": time.monotonic_ns() // 1000 - sent_us,
+        "recv_to_apply_us": recv_apply,
+        "apply_to_flush_us": apply_flush,
+        "p50_us": p50,
+        "p99_us": p99,
+        "max_us": max_us,
+    }
+
+def encode_time_request(seq, prev_t4=0):
+    """Clock sync request stamped with our clock. `prev_t4` is when the
+    TIME_RESP to request seq - 1 arrived (0 if it did not): the ESP32
+    estimates the clock offset from it, so send one every second or so."""
+    return encode_frame(FRAME_TYPE_TIME_REQ, 0,
+                        struct.pack("<IQQ", seq, time.monotonic_ns() // 1000, prev_t4))
+
+def decode_time_response(payload):
+    """TIME_RESP payload -> (seq, t4); t4 goes into the next request"""
+    seq, _t1, _t2, _t3 = struct.unpack("<IQQQ", payload)
+    return seq, time.monotonic_ns() // 1000
+
 # ============================================================
 # MAIN APPLICATION CLASS
 # ============================================================
@@ -87,6 +217,7 @@ class SenderApp:
         ttk.Button(quick_frame, text="67", command=lambda: self.send("67")).pack(side="left", padx=2)
         ttk.Button(quick_frame, text="Who's GOATed?", command=lambda: self.send("The Telly team")).pack(side="left", padx=2)
         ttk.Button(quick_frame, text="Clear", command=lambda: self.send("---")).pack(side="left", padx=2)
+        ttk.Button(quick_frame, text="New lap", command=self.send_lap).pack(side="left", padx=2)
 
         # --------------------------------------------------------
         # Log Frame
@@ -150,7 +281,7 @@ class SenderApp:
             return False
 
         try:
-            self.socket.send(data.encode('utf-8'))
+            self.socket.sendall(encode_text(data))
             self.log(f"Sent: {data}")
             return True
         except Exception as e:
@@ -158,6 +289,18 @@ class SenderApp:
             self.disconnect()
             return False
 
+    def send_lap(self):
+        """Start a new lap on the ESP32's statistics"""
+        if not self.connected:
+            self.log("Not connected!")
+            return
+        try:
+            self.socket.sendall(encode_lap())
+            self.log("New lap")
+        except Exception as e:
+            self.log(f"Send failed: {e}")
+            self.disconnect()
+
     def send_text(self):
         """Send text from entry box"""
         text = self.text_entry.get()
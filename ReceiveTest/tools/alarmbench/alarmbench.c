@@ -0,0 +1,223 @@
+/*
+ * alarmbench.c
+ * Per-sample cost of alarm_evaluate() + a check of the banner summary
+ *
+ * Feeds the compiled rules from alarm_rules.h the way the network task
+ * does, one sample at a time, round-robin over every channel:
+ *
+ *   quiet     every value well inside its limits (the normal case)
+ *   tripping  the cell voltages swing across the undervoltage limit
+ *             every few samples, so alarms raise and clear constantly
+ *             and the summary is republished on every transition
+ *
+ * Reports ns per sample and per rule checked. The event queue is
+ * drained every 1000 samples, like a UI frame would.
+ *
+ * Then checks the published summary: with two alarms raised, clearing
+ * the newer one must leave the older one on the banner, and clearing
+ * both must leave none. Exits non-zero if it does not.
+ *
+ * Usage: alarmbench [-n samples] [-r repeats]
+ */
+
+#define _GNU_SOURCE
+
+#include "alarm.h"
+#include "alarm_rules.h"
+#include "telemetry_channels.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+
+esp_log_level_t host_log_level = ESP_LOG_WARN;
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define DRAIN_EVERY     1000        /* Samples between event queue drains */
+
+typedef struct {
+    int samples;
+    int repeats;
+} options_t;
+
+static options_t opt = {
+    .samples = 2000000,
+    .repeats = 5,
+};
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static bool is_cell_voltage(int ch)
+{
+    return ch >= CH_CELL_V_1 && ch <= CH_CELL_V_30;
+}
+
+/* A value that trips nothing on `ch` */
+static int32_t nominal(int ch)
+{
+    if (is_cell_voltage(ch)) {
+        return 3700;
+    }
+    return ch == CH_PACK_VOLTAGE ? 110000 : 0;
+}
+
+static void drain_events(void)
+{
+    alarm_event_t ev;
+    while (alarm_pop_event(&ev)) {
+    }
+}
+
+/* ============================================================
+ * BENCHMARK
+ * ============================================================ */
+
+/* Rules alarm_evaluate() walks for each channel, from the same table */
+static int rules_on[TELEMETRY_CHANNEL_COUNT];
+
+static void count_rules(void)
+{
+#define COUNT_RULE(name, first, last, op, threshold, hysteresis, debounce, severity) \
+    for (int ch = (first); ch <= (last); ch++) {                                   \
+        rules_on[ch]++;                                                            \
+    }
+    ALARM_RULE_LIST(COUNT_RULE)
+#undef COUNT_RULE
+}
+
+static int32_t sample_value(int n, bool tripping)
+{
+    int ch = n % TELEMETRY_CHANNEL_COUNT;
+
+    /* Four rounds below the limit, four above: past the debounce (3)
+     * both ways, so every cell raises and clears */
+    if (tripping && is_cell_voltage(ch) && (n / TELEMETRY_CHANNEL_COUNT) % 8 < 4) {
+        return 2700;
+    }
+    return nominal(ch);
+}
+
+static void run(const char *name, bool tripping)
+{
+    int64_t best = INT64_MAX;
+    uint64_t rules_checked = 0;
+    uint32_t transitions = 0;
+
+    for (int n = 0; n < opt.samples; n++) {
+        rules_checked += (uint64_t)rules_on[n % TELEMETRY_CHANNEL_COUNT];
+    }
+
+    for (int r = 0; r < opt.repeats; r++) {
+        alarm_event_t ev;
+        alarm_init();
+        drain_events();
+        transitions = 0;
+
+        int64_t t0 = now_ns();
+        for (int n = 0; n < opt.samples; n++) {
+            alarm_evaluate((uint16_t)(n % TELEMETRY_CHANNEL_COUNT), sample_value(n, tripping),
+                           (int64_t)n * 100);
+            if (n % DRAIN_EVERY == DRAIN_EVERY - 1) {
+                while (alarm_pop_event(&ev)) {
+                    transitions++;
+                }
+            }
+        }
+        int64_t t = now_ns() - t0;
+        best = t < best ? t : best;
+
+        while (alarm_pop_event(&ev)) {
+            transitions++;
+        }
+    }
+
+    printf("%-9s %9d samples  %8u transitions  %5.2f rules/sample  %6.1f ns/sample  %5.2f ns/rule\n",
+           name, opt.samples, transitions, (double)rules_checked / opt.samples,
+           (double)best / opt.samples, (double)best / (double)rules_checked);
+}
+
+/* ============================================================
+ * BANNER CHECK
+ * ============================================================ */
+static bool expect(const char *step, int active, int channel, int32_t value)
+{
+    alarm_summary_t s;
+    alarm_get_summary(&s);
+    if (s.active == active && (active == 0 || (s.channel == channel && s.value == value))) {
+        return true;
+    }
+    fprintf(stderr, "FAIL: %s: %d active, newest on channel %u value %ld "
+            "(expected %d active, channel %d value %ld)\n", step, s.active, s.channel,
+            (long)s.value, active, channel, (long)value);
+    return false;
+}
+
+static void feed(int ch, int32_t value, int times, int64_t *t_us)
+{
+    for (int i = 0; i < times; i++) {
+        alarm_evaluate((uint16_t)ch, value, (*t_us += 1000));
+    }
+}
+
+static bool check_summary(void)
+{
+    int64_t t = 0;
+    bool ok = true;
+
+    alarm_init();
+    feed(CH_CELL_TEMP_1, 600, 3, &t);           /* overtemp (550), debounce 3 */
+    ok &= expect("older raised", 1, CH_CELL_TEMP_1, 600);
+    feed(CH_CELL_V_5, 2700, 3, &t);             /* undervoltage (2800) */
+    ok &= expect("newer raised", 2, CH_CELL_V_5, 2700);
+    feed(CH_CELL_V_5, 3000, 3, &t);             /* back past 2850 */
+    ok &= expect("newer cleared", 1, CH_CELL_TEMP_1, 600);
+    feed(CH_CELL_TEMP_1, 400, 3, &t);
+    ok &= expect("both cleared", 0, 0, 0);
+    drain_events();
+    return ok;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-n samples] [-r repeats]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:r:h")) != -1) {
+        switch (c) {
+            case 'n': opt.samples = atoi(optarg); break;
+            case 'r': opt.repeats = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.samples < 1 || opt.repeats < 1) {
+        usage(argv[0]);
+    }
+
+    count_rules();
+    printf("%d channels, best of %d\n\n", TELEMETRY_CHANNEL_COUNT, opt.repeats);
+    run("quiet", false);
+    run("tripping", true);
+
+    bool ok = check_summary();
+    printf("\nbanner summary after clears  %s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
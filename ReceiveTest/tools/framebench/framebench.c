@@ -0,0 +1,281 @@
+/*
+ * framebench.c
+ * Wire size and decode cost of the three ways to send samples
+ *
+ *   text    one TEXT frame per sample, "channel=value" in ASCII (the
+ *           original one-string-per-message protocol)
+ *   value   one VALUE frame per sample, with a sequence number
+ *   batch   BATCH frames, one per burst (see frame_batch.h)
+ *
+ * Each encoding of the same synthetic stream is built once, then
+ * decoded repeatedly the way the receiver does it: frame_parse_buffer()
+ * into a handler that writes every sample into a per-channel array.
+ * Reports bytes per sample and ns per decoded sample, and checks that
+ * all three decode to the same values.
+ *
+ * Usage: framebench [-c channels] [-n ticks] [-b burst] [-r repeats]
+ */
+
+#define _GNU_SOURCE
+
+#include "frame.h"
+#include "frame_batch.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define MAX_CHANNELS    1024
+#define RATE_HZ         100
+
+typedef struct {
+    int channels;
+    int ticks;
+    int burst;
+    int repeats;
+} options_t;
+
+static options_t opt = {
+    .channels = 32,
+    .ticks = 10000,
+    .burst = 10,
+    .repeats = 20,
+};
+
+/* Stand-in for the telemetry store */
+typedef struct {
+    int32_t values[MAX_CHANNELS];
+    uint64_t samples;
+    uint64_t checksum;          /* Order-independent, so all formats agree */
+} sink_t;
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void store(sink_t *sink, uint16_t channel, int32_t value)
+{
+    if (channel < MAX_CHANNELS) {
+        sink->values[channel] = value;
+        sink->samples++;
+        sink->checksum += (uint64_t)(uint32_t)value * (channel + 1u);
+    }
+}
+
+/* Slow sine + a little noise, like a real sensor after fixed-point scaling */
+static int32_t synth_value(int channel, int tick)
+{
+    double t = (double)tick / RATE_HZ;
+    return (int32_t)(50000 + 40000 * sin(t * 0.5 + channel * 0.37)) + rand() % 16;
+}
+
+/* ============================================================
+ * ENCODERS
+ * All write into one growing buffer, as if it were the TCP stream.
+ * ============================================================ */
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} stream_t;
+
+static uint8_t *stream_reserve(stream_t *s, size_t n)
+{
+    if (s->len + n > s->cap) {
+        s->cap = (s->len + n) * 2;
+        s->data = realloc(s->data, s->cap);
+        if (s->data == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    return s->data + s->len;
+}
+
+static void encode_text(stream_t *s, uint16_t channel, int32_t value)
+{
+    char text[32];
+    int n = snprintf(text, sizeof(text), "%u=%ld", channel, (long)value);
+    s->len += frame_encode(stream_reserve(s, FRAME_MAX_SIZE), FRAME_MAX_SIZE, FRAME_TYPE_TEXT,
+                           0, text, (uint16_t)n);
+}
+
+static void encode_value(stream_t *s, uint16_t channel, uint16_t seq, int32_t value)
+{
+    uint8_t payload[4];
+    frame_write_u32(payload, (uint32_t)value);
+    s->len += frame_encode_seq(stream_reserve(s, FRAME_MAX_SIZE), FRAME_MAX_SIZE,
+                               FRAME_TYPE_VALUE, channel, seq, payload, sizeof(payload));
+}
+
+static void emit_batch(stream_t *s, frame_batch_writer_t *w, uint16_t *seq)
+{
+    if (w->count > 0) {
+        s->len += frame_encode_seq(stream_reserve(s, FRAME_MAX_SIZE), FRAME_MAX_SIZE,
+                                   FRAME_TYPE_BATCH, FRAME_BATCH_CHANNEL, (*seq)++, w->buf,
+                                   (uint16_t)w->len);
+    }
+    frame_batch_writer_init(w);
+}
+
+/* ============================================================
+ * DECODERS (frame handlers)
+ * ============================================================ */
+static void on_text(const frame_t *frame, void *ctx)
+{
+    char text[32];
+    size_t n = frame->length < sizeof(text) - 1 ? frame->length : sizeof(text) - 1;
+    memcpy(text, frame->payload, n);
+    text[n] = '\0';
+
+    char *end;
+    unsigned long channel = strtoul(text, &end, 10);
+    if (*end == '=') {
+        store(ctx, (uint16_t)channel, (int32_t)strtol(end + 1, NULL, 10));
+    }
+}
+
+static void on_value(const frame_t *frame, void *ctx)
+{
+    if (frame->type == FRAME_TYPE_VALUE && frame->length == 4) {
+        store(ctx, frame->channel, (int32_t)frame_read_u32(frame->payload));
+    }
+}
+
+static void on_batch(const frame_t *frame, void *ctx)
+{
+    frame_batch_reader_t reader;
+    frame_batch_sample_t sample;
+
+    frame_batch_reader_init(&reader, frame->payload, frame->length);
+    while (frame_batch_next(&reader, &sample)) {
+        store(ctx, sample.channel, sample.value);
+    }
+}
+
+/* ============================================================
+ * BENCHMARK
+ * ============================================================ */
+static uint64_t run(const char *name, const stream_t *s, frame_handler_t handler,
+                    uint64_t samples, uint64_t frames)
+{
+    sink_t sink;
+    int64_t best = INT64_MAX;
+
+    for (int r = 0; r < opt.repeats; r++) {
+        memset(&sink, 0, sizeof(sink));
+        int64_t t0 = now_ns();
+        frame_parse_buffer(s->data, s->len, handler, &sink, NULL);
+        int64_t t = now_ns() - t0;
+        best = t < best ? t : best;
+    }
+
+    if (sink.samples != samples) {
+        fprintf(stderr, "%s: decoded %llu samples, expected %llu\n", name,
+                (unsigned long long)sink.samples, (unsigned long long)samples);
+        exit(1);
+    }
+    printf("%-6s %10zu bytes  %6.2f bytes/sample  %8llu frames  %7.1f ns/sample\n",
+           name, s->len, (double)s->len / samples, (unsigned long long)frames,
+           (double)best / samples);
+    return sink.checksum;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-c channels] [-n ticks] [-b burst] [-r repeats]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "c:n:b:r:h")) != -1) {
+        switch (c) {
+            case 'c': opt.channels = atoi(optarg); break;
+            case 'n': opt.ticks = atoi(optarg); break;
+            case 'b': opt.burst = atoi(optarg); break;
+            case 'r': opt.repeats = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.channels < 1 || opt.channels > MAX_CHANNELS || opt.ticks < 1 || opt.burst < 1 ||
+        opt.repeats < 1) {
+        usage(argv[0]);
+    }
+
+    /* The stream: `ticks` samples of every channel, sent `burst` ticks at a time */
+    uint64_t samples = (uint64_t)opt.channels * opt.ticks;
+    int32_t *values = malloc(samples * sizeof(*values));
+    for (int t = 0; t < opt.ticks; t++) {
+        for (int ch = 0; ch < opt.channels; ch++) {
+            values[(size_t)t * opt.channels + ch] = synth_value(ch, t);
+        }
+    }
+
+    stream_t text = { 0 }, value = { 0 }, batch = { 0 };
+    uint16_t seq[MAX_CHANNELS] = { 0 };
+    uint16_t batch_seq = 0;
+    frame_batch_writer_t w;
+    uint64_t batches = 0;
+
+    for (int t0 = 0; t0 < opt.ticks; t0 += opt.burst) {
+        int t1 = t0 + opt.burst < opt.ticks ? t0 + opt.burst : opt.ticks;
+
+        /* One frame per sample, in the order they were taken */
+        for (int t = t0; t < t1; t++) {
+            for (int ch = 0; ch < opt.channels; ch++) {
+                int32_t v = values[(size_t)t * opt.channels + ch];
+                encode_text(&text, (uint16_t)ch, v);
+                encode_value(&value, (uint16_t)ch, seq[ch]++, v);
+            }
+        }
+
+        /* Batched: channel-major, oldest first, age relative to the last tick */
+        frame_batch_writer_init(&w);
+        for (int ch = 0; ch < opt.channels; ch++) {
+            for (int t = t0; t < t1; t++) {
+                int32_t v = values[(size_t)t * opt.channels + ch];
+                uint32_t age_us = (uint32_t)((t1 - 1 - t) * (1000000 / RATE_HZ));
+                if (!frame_batch_add(&w, (uint16_t)ch, age_us, v)) {
+                    emit_batch(&batch, &w, &batch_seq);
+                    batches++;
+                    frame_batch_add(&w, (uint16_t)ch, age_us, v);
+                }
+            }
+        }
+        if (w.count > 0) {
+            batches++;
+        }
+        emit_batch(&batch, &w, &batch_seq);
+    }
+
+    printf("%d channels x %d ticks = %llu samples, burst %d, best of %d\n\n",
+           opt.channels, opt.ticks, (unsigned long long)samples, opt.burst, opt.repeats);
+
+    uint64_t sum_text = run("text", &text, on_text, samples, samples);
+    uint64_t sum_value = run("value", &value, on_value, samples, samples);
+    uint64_t sum_batch = run("batch", &batch, on_batch, samples, batches);
+    if (sum_text != sum_value || sum_value != sum_batch) {
+        fprintf(stderr, "decoded values differ between formats\n");
+        return 1;
+    }
+
+    free(values);
+    free(text.data);
+    free(value.data);
+    free(batch.data);
+    return 0;
+}
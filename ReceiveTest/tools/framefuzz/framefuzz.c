@@ -0,0 +1,390 @@
+/*
+ * framefuzz.c
+ * Split-stream fuzz test for the frame reassembler
+ *
+ * Builds random streams of frames (every type, SEQ and CRITICAL flags,
+ * payloads from empty to FRAME_MAX_PAYLOAD) and feeds each one to the
+ * receiver's decoders cut into pieces the way TCP might deliver it:
+ *
+ *   whole    the entire stream in one frame_parser_feed() call
+ *   bytes    one byte per call
+ *   small    random pieces of 1..16 bytes
+ *   large    random pieces of 1..3000 bytes
+ *   stream   frame_parse_stream() with the partial frame carried to
+ *            the front of the next buffer, as net_server.c does
+ *
+ * Clean streams must decode to exactly the frames that were encoded.
+ * Dirty streams also get random noise between frames and single bytes
+ * flipped inside some frames: every frame that was not touched must
+ * still come out, in order (bar the rare CRC-16 collision, which is
+ * counted). In both cases every split must deliver the same frames and
+ * count the same errors as the whole-stream feed.
+ *
+ * Exits non-zero on the first mismatch, printing the seed to reproduce.
+ *
+ * Usage: framefuzz [-i iterations] [-s seed]
+ */
+
+#define _GNU_SOURCE
+
+#include "frame.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define MAX_FRAMES      200         /* Frames per stream */
+#define MAX_STREAM      ((MAX_FRAMES + 1) * (FRAME_MAX_SIZE + 64))
+#define MAX_CHUNK       3000        /* Largest piece in "large" mode */
+
+typedef struct {
+    int iterations;
+    uint64_t seed;
+} options_t;
+
+static options_t opt = {
+    .iterations = 2000,
+    .seed = 1,
+};
+
+/* One frame, as encoded or as delivered to the handler */
+typedef struct {
+    uint8_t type;
+    uint8_t flags;
+    uint16_t channel;
+    uint16_t seq;
+    uint16_t length;
+    uint32_t hash;              /* FNV-1a of the payload */
+} record_t;
+
+typedef struct {
+    record_t frames[MAX_FRAMES * 4];
+    size_t count;
+    bool overflow;
+} capture_t;
+
+typedef struct {
+    uint8_t data[MAX_STREAM];
+    size_t len;
+    record_t sent[MAX_FRAMES];
+    bool intact[MAX_FRAMES];    /* Not hit by a flipped byte */
+    size_t count;
+} stream_t;
+
+static uint64_t rng_state;
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static uint32_t rng(void)
+{
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static uint32_t rng_range(uint32_t lo, uint32_t hi)
+{
+    return lo + rng() % (hi - lo + 1);
+}
+
+static uint32_t fnv1a(const uint8_t *p, size_t n)
+{
+    uint32_t h = 2166136261u;
+    while (n--) {
+        h = (h ^ *p++) * 16777619u;
+    }
+    return h;
+}
+
+static bool same(const record_t *a, const record_t *b)
+{
+    return a->type == b->type && a->flags == b->flags && a->channel == b->channel &&
+           a->seq == b->seq && a->length == b->length && a->hash == b->hash;
+}
+
+static void on_frame(const frame_t *frame, void *ctx)
+{
+    capture_t *cap = ctx;
+    if (cap->count == sizeof(cap->frames) / sizeof(cap->frames[0])) {
+        cap->overflow = true;
+        return;
+    }
+    cap->frames[cap->count++] = (record_t) {
+        .type = frame->type,
+        .flags = frame->flags,
+        .channel = frame->channel,
+        .seq = (frame->flags & FRAME_FLAG_SEQ) ? frame->seq : 0,
+        .length = frame->length,
+        .hash = fnv1a(frame->payload, frame->length),
+    };
+}
+
+/* ============================================================
+ * STREAM BUILDER
+ * ============================================================ */
+static void build(stream_t *s, bool dirty)
+{
+    static const uint8_t flag_sets[] = {
+        0, FRAME_FLAG_SEQ, FRAME_FLAG_CRITICAL, FRAME_FLAG_SEQ | FRAME_FLAG_CRITICAL,
+    };
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+
+    s->len = 0;
+    s->count = rng_range(1, MAX_FRAMES);
+
+    for (size_t i = 0; i < s->count; i++) {
+        if (dirty && rng() % 4 == 0) {
+            size_t noise = rng_range(1, 40);
+            for (size_t n = 0; n < noise; n++) {
+                s->data[s->len++] = rng() % 8 == 0 ? FRAME_SYNC : (uint8_t)rng();
+            }
+        }
+
+        record_t *r = &s->sent[i];
+        r->type = (uint8_t)rng_range(FRAME_TYPE_TEXT, FRAME_TYPE_BATCH_TS);
+        r->flags = flag_sets[rng() % 4];
+        r->channel = (uint16_t)rng();
+        r->seq = (r->flags & FRAME_FLAG_SEQ) ? (uint16_t)rng() : 0;
+
+        /* Mostly small payloads, now and then up to the limit */
+        uint16_t max = FRAME_MAX_PAYLOAD - ((r->flags & FRAME_FLAG_SEQ) ? FRAME_SEQ_SIZE : 0);
+        r->length = (uint16_t)(rng() % 8 == 0 ? rng_range(0, max) : rng_range(0, 24));
+        for (uint16_t n = 0; n < r->length; n++) {
+            payload[n] = (uint8_t)rng();
+        }
+        r->hash = fnv1a(payload, r->length);
+
+        size_t size = frame_encode_flags(s->data + s->len, MAX_STREAM - s->len, r->type,
+                                         r->flags, r->channel, r->seq, payload, r->length);
+        s->intact[i] = true;
+        if (dirty && rng() % 8 == 0) {
+            s->data[s->len + rng() % size] ^= (uint8_t)rng_range(1, 255);
+            s->intact[i] = false;
+        }
+        s->len += size;
+    }
+
+    /* A flipped length near the end can claim bytes that never come;
+     * enough filler to complete any frame flushes the tail frames out */
+    if (dirty) {
+        memset(s->data + s->len, 0, FRAME_MAX_SIZE);
+        s->len += FRAME_MAX_SIZE;
+    }
+}
+
+/* ============================================================
+ * FEEDERS
+ * ============================================================ */
+typedef enum { SPLIT_WHOLE, SPLIT_BYTES, SPLIT_SMALL, SPLIT_LARGE } split_t;
+
+static size_t piece(split_t split, size_t left)
+{
+    size_t n;
+    switch (split) {
+        case SPLIT_BYTES: n = 1; break;
+        case SPLIT_SMALL: n = rng_range(1, 16); break;
+        case SPLIT_LARGE: n = rng_range(1, MAX_CHUNK); break;
+        default: n = left; break;
+    }
+    return n < left ? n : left;
+}
+
+static void feed_parser(const stream_t *s, split_t split, capture_t *cap,
+                        frame_parser_stats_t *stats)
+{
+    static frame_parser_t parser;
+    frame_parser_init(&parser);
+
+    for (size_t off = 0; off < s->len;) {
+        size_t n = piece(split, s->len - off);
+        frame_parser_feed(&parser, s->data + off, n, on_frame, cap);
+        off += n;
+    }
+    *stats = parser.stats;
+}
+
+/* frame_parse_stream() the way net_server.c drives it: each read lands
+ * after the partial frame left over from the previous one */
+static void feed_stream(const stream_t *s, capture_t *cap, frame_parser_stats_t *stats)
+{
+    static uint8_t buf[FRAME_MAX_SIZE + MAX_CHUNK];
+    size_t carry = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    for (size_t off = 0; off < s->len;) {
+        size_t n = piece(SPLIT_LARGE, s->len - off);
+        memcpy(buf + carry, s->data + off, n);
+        off += n;
+
+        size_t consumed;
+        frame_parse_stream(buf, carry + n, on_frame, cap, stats, &consumed);
+        carry = carry + n - consumed;
+        if (carry >= FRAME_MAX_SIZE) {
+            fprintf(stderr, "stream: %zu bytes left over, more than one frame\n", carry);
+            exit(1);
+        }
+        memmove(buf, buf + consumed, carry);
+    }
+}
+
+/* ============================================================
+ * CHECKS
+ * ============================================================ */
+static bool same_stats(const frame_parser_stats_t *a, const frame_parser_stats_t *b)
+{
+    return a->frames == b->frames && a->crc_errors == b->crc_errors &&
+           a->bad_headers == b->bad_headers && a->bytes_skipped == b->bytes_skipped;
+}
+
+static bool same_capture(const capture_t *a, const capture_t *b)
+{
+    if (a->count != b->count || a->overflow || b->overflow) {
+        return false;
+    }
+    for (size_t i = 0; i < a->count; i++) {
+        if (!same(&a->frames[i], &b->frames[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool was_sent(const stream_t *s, const record_t *r)
+{
+    for (size_t i = 0; i < s->count; i++) {
+        if (same(&s->sent[i], r)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Every intact frame must appear in the delivered ones, in order. The
+ * one exception is CRC-16 itself: about once in 65 536 a flipped length
+ * byte gives a frame whose "CRC" (two bytes of whatever follows) still
+ * matches, and that frame swallows the ones it now covers. A loss right
+ * after such a never-sent frame is counted, not failed. */
+static unsigned crc_collisions;
+
+static bool intact_delivered(const stream_t *s, const capture_t *cap)
+{
+    size_t j = 0;
+    for (size_t i = 0; i < s->count; i++) {
+        if (!s->intact[i]) {
+            continue;
+        }
+        size_t k = j;
+        while (k < cap->count && !same(&cap->frames[k], &s->sent[i])) {
+            k++;
+        }
+        if (k < cap->count) {
+            j = k + 1;
+        } else if (j < cap->count && !was_sent(s, &cap->frames[j])) {
+            crc_collisions++;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool exact(const stream_t *s, const capture_t *cap)
+{
+    if (cap->count != s->count) {
+        return false;
+    }
+    for (size_t i = 0; i < s->count; i++) {
+        if (!same(&cap->frames[i], &s->sent[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool fail(const char *what, int iteration, bool dirty)
+{
+    fprintf(stderr, "FAIL: %s (%s stream, iteration %d, seed %llu)\n", what,
+            dirty ? "dirty" : "clean", iteration, (unsigned long long)opt.seed);
+    return false;
+}
+
+static bool run_one(int iteration, bool dirty)
+{
+    static stream_t s;
+    static capture_t whole, split;
+    static const char *const names[] = { "whole", "bytes", "small", "large" };
+    frame_parser_stats_t whole_stats, split_stats;
+
+    build(&s, dirty);
+
+    whole.count = 0;
+    whole.overflow = false;
+    feed_parser(&s, SPLIT_WHOLE, &whole, &whole_stats);
+
+    if (!dirty) {
+        if (!exact(&s, &whole) || whole_stats.crc_errors || whole_stats.bad_headers ||
+            whole_stats.bytes_skipped) {
+            return fail("whole: frames differ from the encoded ones", iteration, dirty);
+        }
+    } else if (!intact_delivered(&s, &whole)) {
+        return fail("whole: an intact frame was lost", iteration, dirty);
+    }
+
+    for (split_t mode = SPLIT_BYTES; mode <= SPLIT_LARGE; mode++) {
+        split.count = 0;
+        split.overflow = false;
+        feed_parser(&s, mode, &split, &split_stats);
+        if (!same_capture(&whole, &split) || !same_stats(&whole_stats, &split_stats)) {
+            char what[64];
+            snprintf(what, sizeof(what), "%s: differs from the whole-stream feed", names[mode]);
+            return fail(what, iteration, dirty);
+        }
+    }
+
+    split.count = 0;
+    split.overflow = false;
+    feed_stream(&s, &split, &split_stats);
+    if (!same_capture(&whole, &split) || !same_stats(&whole_stats, &split_stats)) {
+        return fail("stream: differs from the whole-stream feed", iteration, dirty);
+    }
+    return true;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-i iterations] [-s seed]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "i:s:h")) != -1) {
+        switch (c) {
+            case 'i': opt.iterations = atoi(optarg); break;
+            case 's': opt.seed = strtoull(optarg, NULL, 0); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.iterations < 1 || opt.seed == 0) {
+        usage(argv[0]);
+    }
+
+    rng_state = opt.seed;
+    for (int i = 0; i < opt.iterations; i++) {
+        if (!run_one(i, false) || !run_one(i, true)) {
+            return 1;
+        }
+    }
+    printf("framefuzz: %d clean + %d dirty streams, every split identical, "
+           "%u frames lost to CRC collisions  ok\n", opt.iterations, opt.iterations, crc_collisions);
+    return 0;
+}
@@ -0,0 +1,293 @@
+/*
+ * historybench.c
+ * Cost of a history window query as the window grows
+ *
+ * Fills one channel's history with 100 Hz samples (more than the ring
+ * holds, so it has wrapped) and asks for windows from one second up to
+ * the whole ring, summarised into one bucket per chart pixel:
+ *
+ *   pyramid  history_query_buckets() - the min/max/mean levels
+ *   raw      the same buckets from every raw record in the window
+ *            (history_window() + one pass), what a query costs
+ *            without the pyramid
+ *
+ * The pyramid query should cost about the same for every window; the
+ * raw pass grows with the number of samples.
+ *
+ * Then the query the firmware makes: the UI trace (ui.c) summarises
+ * every 100 ms column into one bucket, so it is timed the same two ways
+ * over a sweep of consecutive columns, each checked too.
+ *
+ * Every query is also checked against the raw pass, for windows with
+ * random (unaligned) ends as well: same sample count, same min and max,
+ * sum within one per sample (the stored means are rounded). Exits
+ * non-zero on a mismatch.
+ *
+ * The firmware's budget (HISTORY_DEFAULT_BUDGET_BYTES over all channels)
+ * gives each channel 8192 records - too few for a 1200 px window
+ * query to reach the first level - so by default the bench gives its
+ * one channel a bigger budget (-b, MB for all channels) to show the
+ * curve over minutes of data. `-b 8` is the firmware's budget, where
+ * only the trace columns use the levels, and only on channels fast
+ * enough (-R) to put HISTORY_LEVEL_FACTOR level entries in a column.
+ *
+ * Usage: historybench [-w width] [-r repeats] [-b budget_mb] [-R rate_hz]
+ */
+
+#define _GNU_SOURCE
+
+#include "history.h"
+#include "telemetry_channels.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+
+esp_log_level_t host_log_level = ESP_LOG_WARN;
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define CHANNEL         CH_PACK_CURRENT
+#define MAX_WIDTH       4096
+#define RANDOM_WINDOWS  2000        /* Unaligned windows checked */
+#define COLUMN_MS       100         /* UI_TRACE_COLUMN_US in ui.c */
+#define SWEEP_COLUMNS   600         /* Columns per timed trace sweep */
+
+typedef struct {
+    int width;
+    int repeats;
+    int budget_mb;
+    int rate_hz;
+} options_t;
+
+static options_t opt = {
+    .width = 1200,
+    .repeats = 5,
+    .budget_mb = 512,
+    .rate_hz = 100,
+};
+
+static history_bucket_t pyramid[MAX_WIDTH];
+static history_bucket_t raw[MAX_WIDTH];
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Slow sine + noise, negative half the time so rounding goes both ways */
+static int32_t synth_value(uint32_t n)
+{
+    return (int32_t)(80000 * sin(n * 0.0007)) + rand() % 2001 - 1000;
+}
+
+/* The reference: every raw record of the window into its bucket */
+static void query_raw(uint32_t from_ms, uint32_t to_ms, history_bucket_t *out, size_t width)
+{
+    history_span_t span;
+
+    memset(out, 0, width * sizeof(*out));
+    if (!history_window(CHANNEL, from_ms, to_ms, &span)) {
+        return;
+    }
+
+    uint32_t span_ms = to_ms - from_ms + 1;
+    size_t count = history_span_count(&span);
+    for (size_t i = 0; i < count; i++) {
+        const history_record_t *rec = history_span_at(&span, i);
+        size_t px = (size_t)((uint64_t)(rec->t_ms - from_ms) * width / span_ms);
+        history_bucket_t *b = &out[px < width ? px : width - 1];
+        if (b->count == 0 || rec->value < b->min) {
+            b->min = rec->value;
+        }
+        if (b->count == 0 || rec->value > b->max) {
+            b->max = rec->value;
+        }
+        b->sum += rec->value;
+        b->count++;
+    }
+}
+
+typedef struct {
+    uint64_t count;
+    int64_t sum;
+    int32_t min;
+    int32_t max;
+} totals_t;
+
+static totals_t totals(const history_bucket_t *b, size_t width)
+{
+    totals_t t = { 0, 0, INT32_MAX, INT32_MIN };
+    for (size_t i = 0; i < width; i++) {
+        if (b[i].count == 0) {
+            continue;
+        }
+        t.count += b[i].count;
+        t.sum += b[i].sum;
+        t.min = b[i].min < t.min ? b[i].min : t.min;
+        t.max = b[i].max > t.max ? b[i].max : t.max;
+    }
+    return t;
+}
+
+/* Pyramid buckets agree with the raw pass over the whole window */
+static bool check(uint32_t from_ms, uint32_t to_ms, size_t width)
+{
+    history_query_buckets(CHANNEL, from_ms, to_ms, pyramid, width);
+    query_raw(from_ms, to_ms, raw, width);
+
+    totals_t p = totals(pyramid, width);
+    totals_t r = totals(raw, width);
+    int64_t sum_err = p.sum > r.sum ? p.sum - r.sum : r.sum - p.sum;
+
+    if (p.count != r.count || p.min != r.min || p.max != r.max || sum_err > (int64_t)r.count) {
+        fprintf(stderr, "FAIL: window %u..%u ms: pyramid %llu samples [%ld, %ld] sum %lld, "
+                "raw %llu samples [%ld, %ld] sum %lld\n", from_ms, to_ms,
+                (unsigned long long)p.count, (long)p.min, (long)p.max, (long long)p.sum,
+                (unsigned long long)r.count, (long)r.min, (long)r.max, (long long)r.sum);
+        return false;
+    }
+    return true;
+}
+
+/* `columns` consecutive windows of `window_ms` from `from_ms`, each
+ * summarised into `width` buckets */
+static void sweep(bool use_pyramid, uint32_t from_ms, uint32_t window_ms, int columns,
+                  size_t width)
+{
+    for (int c = 0; c < columns; c++, from_ms += window_ms) {
+        if (use_pyramid) {
+            history_query_buckets(CHANNEL, from_ms, from_ms + window_ms - 1, pyramid, width);
+        } else {
+            query_raw(from_ms, from_ms + window_ms - 1, raw, width);
+        }
+    }
+}
+
+/* Best-of-repeats time of one sweep, in ns */
+static double time_sweep(bool use_pyramid, uint32_t from_ms, uint32_t window_ms, int columns,
+                         size_t width)
+{
+    int64_t best = INT64_MAX;
+    int inner = 0;
+    int64_t t0, t;
+
+    /* Enough calls per repeat to measure a ~10 us query */
+    for (inner = 1; inner < (1 << 20); inner *= 2) {
+        t0 = now_ns();
+        for (int i = 0; i < inner; i++) {
+            sweep(use_pyramid, from_ms, window_ms, columns, width);
+        }
+        if (now_ns() - t0 > 2000000) {
+            break;
+        }
+    }
+
+    for (int r = 0; r < opt.repeats; r++) {
+        t0 = now_ns();
+        for (int i = 0; i < inner; i++) {
+            sweep(use_pyramid, from_ms, window_ms, columns, width);
+        }
+        t = now_ns() - t0;
+        best = t < best ? t : best;
+    }
+    return (double)best / inner;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-w width] [-r repeats] [-b budget_mb] [-R rate_hz]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "w:r:b:R:h")) != -1) {
+        switch (c) {
+            case 'w': opt.width = atoi(optarg); break;
+            case 'r': opt.repeats = atoi(optarg); break;
+            case 'b': opt.budget_mb = atoi(optarg); break;
+            case 'R': opt.rate_hz = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.width < 1 || opt.width > MAX_WIDTH || opt.repeats < 1 || opt.budget_mb < 1 ||
+        opt.rate_hz < 1 || opt.rate_hz > 1000) {
+        usage(argv[0]);
+    }
+
+    if (history_init((size_t)opt.budget_mb * 1024 * 1024) != ESP_OK) {
+        return 1;
+    }
+
+    /* One and a half rings' worth, so the raw ring and the levels wrap */
+    uint32_t n_samples = (uint32_t)(history_capacity() * 3 / 2);
+    int64_t t_us = 1000000;
+    for (uint32_t n = 0; n < n_samples; n++, t_us += 1000000 / opt.rate_hz) {
+        history_append(CHANNEL, synth_value(n), t_us);
+    }
+    uint32_t newest_ms = (uint32_t)((t_us - 1000000 / opt.rate_hz) / 1000);
+    uint32_t kept_ms = (uint32_t)((uint64_t)(history_capacity() - HISTORY_GUARD_RECORDS) * 1000 /
+                                  (uint32_t)opt.rate_hz);
+
+    printf("%u records per channel, %u appended at %d Hz, %d px wide, best of %d\n\n",
+           (unsigned)history_capacity(), n_samples, opt.rate_hz, opt.width, opt.repeats);
+    printf("%10s %10s %14s %14s\n", "window", "samples", "pyramid us", "raw us");
+
+    bool ok = true;
+    for (uint32_t window_ms = 1000;; window_ms *= 4) {
+        if (window_ms > kept_ms) {
+            window_ms = kept_ms;
+        }
+        uint32_t from_ms = newest_ms - window_ms + 1;
+        ok &= check(from_ms, newest_ms, (size_t)opt.width);
+
+        double pyramid_ns = time_sweep(true, from_ms, window_ms, 1, (size_t)opt.width);
+        double raw_ns = time_sweep(false, from_ms, window_ms, 1, (size_t)opt.width);
+        printf("%8.0f s %10u %14.1f %14.1f\n", window_ms / 1000.0,
+               (unsigned)((uint64_t)window_ms * (uint32_t)opt.rate_hz / 1000), pyramid_ns / 1000,
+               raw_ns / 1000);
+        if (window_ms == kept_ms) {
+            break;
+        }
+    }
+
+    /* Unaligned ends: partial level entries must be clipped at both */
+    for (int i = 0; i < RANDOM_WINDOWS && ok; i++) {
+        uint32_t a = newest_ms - (uint32_t)(rand() % kept_ms);
+        uint32_t b = newest_ms - (uint32_t)(rand() % kept_ms);
+        ok &= check(a < b ? a : b, a < b ? b : a, (size_t)opt.width);
+    }
+
+    /* The UI trace: one bucket per column, the newest SWEEP_COLUMNS
+     * (or as many as the ring keeps) */
+    int columns = (int)(kept_ms / COLUMN_MS) < SWEEP_COLUMNS ? (int)(kept_ms / COLUMN_MS)
+                                                             : SWEEP_COLUMNS;
+    uint32_t sweep_from = newest_ms - (uint32_t)columns * COLUMN_MS + 1;
+    for (int c = 0; c < columns && ok; c++) {
+        uint32_t from_ms = sweep_from + (uint32_t)c * COLUMN_MS;
+        ok &= check(from_ms, from_ms + COLUMN_MS - 1, 1);
+    }
+    double pyramid_ns = time_sweep(true, sweep_from, COLUMN_MS, columns, 1);
+    double raw_ns = time_sweep(false, sweep_from, COLUMN_MS, columns, 1);
+    printf("\ntrace column (%d ms, %d samples, 1 bucket): pyramid %.2f us, raw %.2f us\n",
+           COLUMN_MS, COLUMN_MS * opt.rate_hz / 1000, pyramid_ns / 1000 / columns,
+           raw_ns / 1000 / columns);
+
+    printf("\n%d random windows and %d columns checked against the raw records  %s\n",
+           RANDOM_WINDOWS, columns, ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
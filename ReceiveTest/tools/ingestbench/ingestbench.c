@@ -0,0 +1,344 @@
+/*
+ * ingestbench.c
+ * Loopback comparison of the TCP and UDP ingest paths
+ *
+ * Starts the real server (net_server.c + udp_server.c, lanes, rx_pool,
+ * link quality) on loopback and sends it the same stream of VALUE
+ * frames - one frame per channel per burst, with sequence numbers - in
+ * four runs:
+ *
+ *   tcp/paced  udp/paced   -r bursts per second, the latency at a rate
+ *                          both paths keep up with
+ *   tcp/flat   udp/flat    as fast as the sender can go, the throughput
+ *
+ * A burst is one send() on TCP and one datagram (or as few as it takes)
+ * on UDP. Every frame carries its send time, so the data callback sees
+ * the latency from the sender's send() to the callback: socket, select()
+ * loop, parser and lane queue.
+ *
+ * Reports frames delivered and lost, delivered frames per second (first
+ * send to last delivery) and the latency percentiles for each run.
+ * Exits non-zero if TCP loses, reorders or misroutes a frame; UDP may
+ * drop datagrams when the socket buffer overflows - that is counted,
+ * not failed.
+ *
+ * Usage: ingestbench [-c channels] [-n bursts] [-r bursts_per_s] [-t tcp_port] [-u udp_port]
+ */
+
+#define _GNU_SOURCE
+
+#include "frame.h"
+#include "link_quality.h"
+#include "net_server.h"
+#include "udp_server.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define MAX_CHANNELS        LINK_MAX_CHANNELS       /* Ids with a sequence window */
+#define VALUE_FRAME_SIZE    (FRAME_HEADER_SIZE + FRAME_SEQ_SIZE + 4 + FRAME_CRC_SIZE)
+#define SETTLE_MS           500     /* A run ends this long after the last delivery */
+
+typedef struct {
+    int channels;
+    int bursts;
+    int rate_hz;
+    uint16_t tcp_port;
+    uint16_t udp_port;
+} options_t;
+
+static options_t opt = {
+    .channels = 32,
+    .bursts = 5000,
+    .rate_hz = 2000,
+    .tcp_port = 15000,
+    .udp_port = 15001,
+};
+
+/* ============================================================
+ * RECEIVER SIDE (server task)
+ * ============================================================ */
+static uint32_t *latency_us;            /* One per delivered frame */
+static uint32_t delivered;              /* Written by the server task only */
+static uint32_t misrouted;              /* Wrong transport, channel or type */
+static uint32_t out_of_order;           /* Sequence not the next on its channel */
+static int64_t last_delivery_us;
+static bool expect_udp;
+static uint16_t expect_seq[MAX_CHANNELS];
+
+static void on_data(const frame_t *frame, const network_rx_info_t *rx)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (frame->type != FRAME_TYPE_VALUE || frame->length != 4 || frame->channel >= opt.channels ||
+        (rx->conn == NETWORK_CONN_UDP) != expect_udp) {
+        misrouted++;
+        return;
+    }
+
+    /* UDP may lose datagrams: only TCP must deliver every number in turn */
+    uint16_t seq = frame->seq;
+    if (seq != expect_seq[frame->channel]) {
+        out_of_order++;
+    }
+    expect_seq[frame->channel] = (uint16_t)(seq + 1);
+
+    uint32_t sent = frame_read_u32(frame->payload);
+    uint32_t n = __atomic_load_n(&delivered, __ATOMIC_RELAXED);
+    latency_us[n] = (uint32_t)now - sent;
+    __atomic_store_n(&last_delivery_us, now, __ATOMIC_RELAXED);
+    __atomic_store_n(&delivered, n + 1, __ATOMIC_RELEASE);
+}
+
+/* ============================================================
+ * SENDER SIDE
+ * ============================================================ */
+static int tcp_sock = -1;
+static int udp_sock = -1;
+static struct sockaddr_in udp_dest;
+static uint32_t udp_seq;
+static uint16_t channel_seq[MAX_CHANNELS];
+
+static uint8_t tx_buf[MAX_CHANNELS * VALUE_FRAME_SIZE + UDP_DGRAM_HEADER_SIZE];
+
+static void die(const char *what)
+{
+    perror(what);
+    exit(1);
+}
+
+static void send_all(const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(tcp_sock, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            die("send");
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+static void send_datagram(size_t len)
+{
+    frame_write_u32(tx_buf + 4, udp_seq++);
+    /* A full socket buffer drops the datagram on the receiving side
+     * anyway - ENOBUFS here is the same loss, seen earlier */
+    if (sendto(udp_sock, tx_buf, len, 0, (struct sockaddr *)&udp_dest, sizeof(udp_dest)) < 0 &&
+        errno != ENOBUFS) {
+        die("sendto");
+    }
+}
+
+/* One frame per channel, stamped with the send time, in one send() or
+ * in as few datagrams as hold it */
+static void send_burst(bool udp)
+{
+    size_t head = udp ? UDP_DGRAM_HEADER_SIZE : 0;
+    size_t len = head;
+    uint8_t payload[4];
+
+    if (udp) {
+        tx_buf[0] = UDP_DGRAM_MAGIC;
+        tx_buf[1] = UDP_DGRAM_VERSION;
+        frame_write_u16(tx_buf + 2, 0);
+    }
+
+    for (int ch = 0; ch < opt.channels; ch++) {
+        if (udp && len + VALUE_FRAME_SIZE > UDP_MAX_DATAGRAM) {
+            send_datagram(len);
+            len = head;
+        }
+        frame_write_u32(payload, (uint32_t)esp_timer_get_time());
+        len += frame_encode_seq(tx_buf + len, sizeof(tx_buf) - len, FRAME_TYPE_VALUE,
+                                (uint16_t)ch, channel_seq[ch]++, payload, sizeof(payload));
+    }
+
+    if (udp) {
+        send_datagram(len);
+    } else {
+        send_all(tx_buf, len);
+    }
+}
+
+static void sleep_until(int64_t t_us)
+{
+    int64_t delta = t_us - esp_timer_get_time();
+    if (delta > 0) {
+        struct timespec ts = { delta / 1000000, (delta % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+/* The server task opens its listener after net_server_start() returns */
+static void open_sockets(void)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(opt.tcp_port);
+
+    for (int tries = 0;; tries++) {
+        tcp_sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (tcp_sock < 0) {
+            die("socket");
+        }
+        if (connect(tcp_sock, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            break;
+        }
+        if (errno != ECONNREFUSED || tries == 100) {
+            die("connect");
+        }
+        close(tcp_sock);
+        sleep_until(esp_timer_get_time() + 10000);
+    }
+    int one = 1;
+    setsockopt(tcp_sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    udp_sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (udp_sock < 0) {
+        die("socket");
+    }
+    udp_dest = addr;
+    udp_dest.sin_port = htons(opt.udp_port);
+}
+
+/* ============================================================
+ * BENCHMARK
+ * ============================================================ */
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* One run; returns false if TCP did not deliver every frame in order */
+static bool run(const char *name, bool udp, int rate_hz)
+{
+    uint32_t sent = (uint32_t)opt.bursts * (uint32_t)opt.channels;
+
+    /* The server is idle between runs (the last one has settled) */
+    __atomic_store_n(&delivered, 0, __ATOMIC_RELAXED);
+    misrouted = 0;
+    out_of_order = 0;
+    expect_udp = udp;
+    memcpy(expect_seq, channel_seq, sizeof(expect_seq));
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    int64_t start = esp_timer_get_time();
+    for (int b = 0; b < opt.bursts; b++) {
+        if (rate_hz > 0) {
+            sleep_until(start + (int64_t)b * 1000000 / rate_hz);
+        }
+        send_burst(udp);
+    }
+
+    /* Wait for the tail (or, on UDP, until nothing more is coming) */
+    uint32_t n, seen = 0;
+    int64_t quiet_since = esp_timer_get_time();
+    while ((n = __atomic_load_n(&delivered, __ATOMIC_ACQUIRE)) < sent) {
+        int64_t now = esp_timer_get_time();
+        if (n != seen) {
+            seen = n;
+            quiet_since = now;
+        } else if (now - quiet_since > (int64_t)SETTLE_MS * 1000) {
+            break;
+        }
+        sleep_until(now + 1000);
+    }
+    int64_t span_us = __atomic_load_n(&last_delivery_us, __ATOMIC_RELAXED) - start;
+
+    printf("%-10s %9lu %9lu %8lu %11.0f", name, (unsigned long)sent, (unsigned long)n,
+           (unsigned long)(sent - n), n > 0 && span_us > 0 ? n * 1e6 / span_us : 0.0);
+    if (n > 0) {
+        qsort(latency_us, n, sizeof(latency_us[0]), cmp_u32);
+        printf(" %7lu %7lu %8lu", (unsigned long)latency_us[n / 2],
+               (unsigned long)latency_us[(n - 1) * 99 / 100], (unsigned long)latency_us[n - 1]);
+    }
+    printf("\n");
+
+    if (misrouted > 0 || (!udp && (n != sent || out_of_order > 0))) {
+        fprintf(stderr, "FAIL: %s: %lu of %lu delivered, %lu out of order, %lu misrouted\n", name,
+                (unsigned long)n, (unsigned long)sent, (unsigned long)out_of_order,
+                (unsigned long)misrouted);
+        return false;
+    }
+    return true;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-c channels] [-n bursts] [-r bursts_per_s] [-t tcp_port] [-u udp_port]\n",
+            argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "c:n:r:t:u:h")) != -1) {
+        switch (c) {
+            case 'c': opt.channels = atoi(optarg); break;
+            case 'n': opt.bursts = atoi(optarg); break;
+            case 'r': opt.rate_hz = atoi(optarg); break;
+            case 't': opt.tcp_port = (uint16_t)atoi(optarg); break;
+            case 'u': opt.udp_port = (uint16_t)atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.channels < 1 || opt.channels > MAX_CHANNELS || opt.bursts < 1 || opt.rate_hz < 1) {
+        usage(argv[0]);
+    }
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    latency_us = malloc((size_t)opt.bursts * (size_t)opt.channels * sizeof(*latency_us));
+    if (latency_us == NULL) {
+        die("malloc");
+    }
+
+    if (net_server_start(opt.tcp_port, opt.udp_port, on_data, NULL) != ESP_OK) {
+        return 1;
+    }
+    open_sockets();
+
+    printf("%d channels x %d bursts per run, paced runs at %d bursts/s (%d frames/s)\n\n",
+           opt.channels, opt.bursts, opt.rate_hz, opt.rate_hz * opt.channels);
+    printf("%-10s %9s %9s %8s %11s %7s %7s %8s\n", "run", "sent", "delivered", "lost",
+           "frames/s", "p50 us", "p99 us", "max us");
+
+    bool ok = true;
+    ok &= run("tcp/paced", false, opt.rate_hz);
+    ok &= run("udp/paced", true, opt.rate_hz);
+    ok &= run("tcp/flat", false, 0);
+    ok &= run("udp/flat", true, 0);
+
+    udp_server_stats_t udp;
+    udp_server_get_stats(&udp);
+    printf("\nudp %lu datagrams in %lu wake-ups, %lu lost\n", (unsigned long)udp.datagrams,
+           (unsigned long)udp.batches, (unsigned long)udp.lost);
+    printf("tcp frames delivered complete and in order  %s\n", ok ? "ok" : "MISMATCH");
+
+    close(tcp_sock);
+    close(udp_sock);
+    free(latency_us);
+    return ok ? 0 : 1;
+}
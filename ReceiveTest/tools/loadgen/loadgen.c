@@ -0,0 +1,801 @@
+/*
+ * loadgen.c
+ * Command-line load generator / race log replayer for the receiver
+ *
+ * Sends VALUE (or BATCH) frames for many channels at a fixed rate
+ * (optionally in bursts, optionally with on/off duty cycling) or replays
+ * a recorded race log at 1x..100x, over TCP or UDP. Every 1/probe-rate
+ * seconds it also sends a latency PROBE the same way as the samples and
+ * collects the PROBE_ACK the receiver sends back once the probe is on
+ * screen. Acks always come back on the TCP connection - in UDP mode the
+ * receiver finds it by the datagram's source address.
+ *
+ * Works against the real board and the host build alike - it only
+ * speaks the wire protocol from frame.h / udp_server.h.
+ * tools/ingestbench sends one stream over both transports to the
+ * server on loopback and compares them side by side.
+ *
+ * Usage: loadgen [options]
+ *   -H host          receiver address            (192.168.1.100)
+ *   -t port          TCP port                    (5000)
+ *   -u port          UDP port                    (5001)
+ *   -m tcp|udp       transport for samples and probes (tcp)
+ *   -c channels      number of channels          (32)
+ *   -r hz            samples per second per channel (100)
+ *   -b n             send n samples per channel in one burst (1)
+ *   -p on_ms:off_ms  duty cycle: send for on_ms, pause for off_ms
+ *   -d seconds       run time, 0 = until ^C      (10)
+ *   -R file          replay a race log instead of synthetic data
+ *   -s speed         replay speed 1..100         (1)
+ *   -P hz            latency probes per second, 0 = off (10)
+ *   -L percent       skip this share of samples (sequence numbers still
+ *                    advance, so the receiver sees gaps) (0)
+ *   -B               send BATCH frames instead of one VALUE frame per sample
+ *   -C               send the probes as critical frames (FRAME_FLAG_CRITICAL),
+ *                    to measure the critical lane under the sample flood
+ *   -T offset_ms[:drift_ppm]
+ *                    sync clocks: run our clock this far ahead of (and this
+ *                    much faster than) CLOCK_MONOTONIC, answer the receiver's
+ *                    clock sync (TIME_REQ every second) and stamp batches
+ *                    with it (BATCH_TS) - checks the receiver's estimate
+ *
+ * Every VALUE frame carries a per-channel sequence number
+ * (FRAME_FLAG_SEQ); BATCH frames number the batches instead.
+ *
+ * Race log: one sample per line, "seconds,channel,value" with the
+ * value as the raw int32 the channel table expects. Lines starting
+ * with '#' are skipped. Times must not go backwards.
+ */
+
+#define _GNU_SOURCE
+
+#include "frame.h"
+#include "frame_batch.h"
+#include "udp_server.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define TX_BUFFER_SIZE      (64 * 1024)     /* One TCP write */
+#define MAX_RTT_SAMPLES     (1 << 20)
+#define REPORT_INTERVAL_US  1000000
+
+typedef struct {
+    const char *host;
+    uint16_t tcp_port;
+    uint16_t udp_port;
+    bool udp;
+    int channels;
+    double rate_hz;
+    int burst;
+    int on_ms;
+    int off_ms;
+    double duration_s;
+    const char *replay_path;
+    double speed;
+    double probe_hz;
+    double loss_percent;
+    bool batch;
+    bool critical_probes;
+    bool sync;
+    double clock_offset_ms;
+    double clock_drift_ppm;
+} options_t;
+
+/* One replayed (or, with -B, pending) sample */
+typedef struct {
+    int64_t t_us;
+    uint16_t channel;
+    int32_t value;
+} log_sample_t;
+
+/* ============================================================
+ * STATE
+ * ============================================================ */
+static options_t opt = {
+    .host = "192.168.1.100",
+    .tcp_port = 5000,
+    .udp_port = 5001,
+    .channels = 32,
+    .rate_hz = 100,
+    .burst = 1,
+    .duration_s = 10,
+    .speed = 1,
+    .probe_hz = 10,
+};
+
+static volatile sig_atomic_t stop;
+
+static int tcp_sock = -1;               /* Samples and probes (TCP mode) + acks */
+static int udp_sock = -1;
+static struct sockaddr_in udp_dest;
+static uint32_t udp_seq;
+
+static uint8_t tx_buf[TX_BUFFER_SIZE];
+static size_t tx_len;
+
+static frame_parser_t ack_parser;
+
+static uint16_t channel_seq[UINT16_MAX + 1];     /* Next sequence number per channel */
+
+/* -B: samples wait here until the burst is flushed as BATCH frames */
+static log_sample_t *pending;
+static size_t pending_count, pending_cap;
+static uint16_t batch_seq;
+static frame_batch_writer_t batch;
+static int64_t batch_time_us;           /* The `now` the batch ages are relative to */
+
+/* -T: clock sync exchanges */
+#define SYNC_FAST_COUNT     8           /* First requests go out 4x as often */
+static uint32_t sync_seq;               /* Next request */
+static uint64_t sync_prev_t4;           /* When the answer to request sync_seq - 1 came, 0 = not yet */
+static uint32_t syncs_answered;
+
+/* Counters */
+static uint64_t samples_sent;
+static uint64_t batches_sent;
+static uint64_t bytes_sent;
+static uint64_t datagrams_sent;
+static uint64_t samples_skipped;
+static uint32_t probes_sent;
+static uint32_t probes_acked;
+
+/* Round trips, and the receiver's own view from the newest ack */
+static uint32_t *rtt_us;
+static uint32_t rtt_count;
+static uint32_t last_recv_to_apply, last_apply_to_flush;
+static uint32_t board_p50, board_p99, board_max;
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* The clock we stamp probes, TIME_REQs and BATCH_TS frames with: with
+ * -T deliberately offset from (and drifting against) CLOCK_MONOTONIC */
+static int64_t sender_clock_at(int64_t mono_us)
+{
+    return mono_us + (int64_t)(opt.clock_offset_ms * 1000 + mono_us * opt.clock_drift_ppm / 1e6);
+}
+
+static void sleep_until(int64_t t_us)
+{
+    int64_t delta = t_us - now_us();
+    if (delta > 0) {
+        struct timespec ts = { delta / 1000000, (delta % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void die(const char *what)
+{
+    perror(what);
+    exit(1);
+}
+
+/* ============================================================
+ * TRANSMIT
+ * Frames are collected in tx_buf and written out together: one
+ * send() per burst on TCP, one datagram per UDP_MAX_DATAGRAM on UDP.
+ * ============================================================ */
+static void send_all(int sock, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(sock, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            die("send");
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+static void flush_tx(void)
+{
+    if (tx_len == 0 || (opt.udp && tx_len <= UDP_DGRAM_HEADER_SIZE)) {
+        return;
+    }
+
+    if (opt.udp) {
+        if (sendto(udp_sock, tx_buf, tx_len, 0, (struct sockaddr *)&udp_dest,
+                   sizeof(udp_dest)) < 0 && errno != ENOBUFS) {
+            die("sendto");
+        }
+        datagrams_sent++;
+    } else {
+        send_all(tcp_sock, tx_buf, tx_len);
+    }
+    bytes_sent += tx_len;
+    tx_len = 0;
+}
+
+/* Start a datagram: magic, version, reserved, sequence */
+static void begin_datagram(void)
+{
+    tx_buf[0] = UDP_DGRAM_MAGIC;
+    tx_buf[1] = UDP_DGRAM_VERSION;
+    frame_write_u16(tx_buf + 2, 0);
+    frame_write_u32(tx_buf + 4, udp_seq++);
+    tx_len = UDP_DGRAM_HEADER_SIZE;
+}
+
+/* Make room for one `size`-byte frame; returns the space limit */
+static size_t reserve_tx(size_t size)
+{
+    size_t limit = opt.udp ? UDP_MAX_DATAGRAM : sizeof(tx_buf);
+
+    if (opt.udp && tx_len == 0) {
+        begin_datagram();
+    }
+    if (tx_len + size > limit) {
+        flush_tx();
+        if (opt.udp) {
+            begin_datagram();
+        }
+    }
+    return limit;
+}
+
+static void queue_value(uint16_t channel, int32_t value, int64_t t_us)
+{
+    uint8_t payload[4];
+    uint16_t seq = channel_seq[channel]++;
+
+    if (opt.loss_percent > 0 && rand() < opt.loss_percent / 100 * RAND_MAX) {
+        samples_skipped++;
+        return;
+    }
+
+    if (opt.batch) {
+        if (pending_count == pending_cap) {
+            pending_cap = pending_cap ? pending_cap * 2 : 4096;
+            pending = realloc(pending, pending_cap * sizeof(*pending));
+            if (pending == NULL) {
+                die("realloc");
+            }
+        }
+        pending[pending_count++] = (log_sample_t){ t_us, channel, value };
+        return;
+    }
+
+    size_t limit = reserve_tx(FRAME_HEADER_SIZE + FRAME_SEQ_SIZE + sizeof(payload) + FRAME_CRC_SIZE);
+    frame_write_u32(payload, (uint32_t)value);
+    tx_len += frame_encode_seq(tx_buf + tx_len, limit - tx_len, FRAME_TYPE_VALUE, channel,
+                               seq, payload, sizeof(payload));
+    samples_sent++;
+}
+
+static void start_batch(void)
+{
+    if (opt.sync) {
+        frame_batch_writer_init_stamped(&batch);
+    } else {
+        frame_batch_writer_init(&batch);
+    }
+}
+
+static void emit_batch(void)
+{
+    if (batch.count == 0) {
+        return;
+    }
+    if (opt.sync) {
+        frame_batch_set_stamp(&batch, (uint64_t)sender_clock_at(batch_time_us));
+    }
+    size_t limit = reserve_tx(FRAME_HEADER_SIZE + FRAME_SEQ_SIZE + batch.len + FRAME_CRC_SIZE);
+    tx_len += frame_encode_seq(tx_buf + tx_len, limit - tx_len,
+                               opt.sync ? FRAME_TYPE_BATCH_TS : FRAME_TYPE_BATCH,
+                               FRAME_BATCH_CHANNEL, batch_seq++, batch.buf, (uint16_t)batch.len);
+    samples_sent += batch.count;
+    batches_sent++;
+    start_batch();
+}
+
+/* Channel-major, oldest first: what makes the deltas small */
+static int cmp_pending(const void *a, const void *b)
+{
+    const log_sample_t *x = a, *y = b;
+    if (x->channel != y->channel) {
+        return x->channel < y->channel ? -1 : 1;
+    }
+    return (x->t_us > y->t_us) - (x->t_us < y->t_us);
+}
+
+/* Send everything queued so far */
+static void flush_samples(void)
+{
+    if (opt.batch && pending_count > 0) {
+        int64_t now = now_us();
+
+        qsort(pending, pending_count, sizeof(*pending), cmp_pending);
+        batch_time_us = now;
+        start_batch();
+        for (size_t i = 0; i < pending_count; i++) {
+            int64_t age = now - pending[i].t_us;
+            uint32_t age_us = age > 0 ? (uint32_t)age : 0;
+            if (!frame_batch_add(&batch, pending[i].channel, age_us, pending[i].value)) {
+                emit_batch();
+                frame_batch_add(&batch, pending[i].channel, age_us, pending[i].value);
+            }
+        }
+        emit_batch();
+        pending_count = 0;
+    }
+    flush_tx();
+}
+
+/* ============================================================
+ * LATENCY PROBES
+ * ============================================================ */
+static void send_probe(void)
+{
+    uint8_t payload[FRAME_PROBE_SIZE];
+
+    /* The probe takes the samples' transport and queues behind the
+     * pending ones, so it measures what a sample would see */
+    flush_samples();
+
+    frame_write_u32(payload, probes_sent++);
+    frame_write_u64(payload + 4, (uint64_t)sender_clock_at(now_us()));
+    size_t limit = reserve_tx(FRAME_HEADER_SIZE + FRAME_PROBE_SIZE + FRAME_CRC_SIZE);
+    tx_len += frame_encode_flags(tx_buf + tx_len, limit - tx_len, FRAME_TYPE_PROBE,
+                                 opt.critical_probes ? FRAME_FLAG_CRITICAL : 0, 0, 0,
+                                 payload, sizeof(payload));
+    flush_tx();
+}
+
+/* -T: the receiver does the estimating; we just hand it our send and
+ * receive times (t1 now, t4 of the previous exchange) */
+static void send_time_request(void)
+{
+    uint8_t payload[FRAME_TIME_REQ_SIZE];
+    uint8_t out[FRAME_HEADER_SIZE + FRAME_TIME_REQ_SIZE + FRAME_CRC_SIZE];
+
+    frame_write_u32(payload, sync_seq++);
+    frame_write_u64(payload + 4, (uint64_t)sender_clock_at(now_us()));
+    frame_write_u64(payload + 12, sync_prev_t4);
+    sync_prev_t4 = 0;
+    size_t n = frame_encode(out, sizeof(out), FRAME_TYPE_TIME_REQ, 0, payload, sizeof(payload));
+
+    /* Straight onto the socket, ahead of queued samples: queueing
+     * behind them would only add delay the receiver has to filter out */
+    send_all(tcp_sock, out, n);
+}
+
+static void on_time_response(const frame_t *frame)
+{
+    int64_t t4 = sender_clock_at(now_us());
+    if (frame->length == FRAME_TIME_RESP_SIZE && frame_read_u32(frame->payload) + 1 == sync_seq) {
+        sync_prev_t4 = (uint64_t)t4;
+        syncs_answered++;
+    }
+}
+
+static void on_ack(const frame_t *frame, void *ctx)
+{
+    (void)ctx;
+    if (frame->type == FRAME_TYPE_TIME_RESP) {
+        on_time_response(frame);
+        return;
+    }
+    if (frame->type != FRAME_TYPE_PROBE_ACK || frame->length != FRAME_PROBE_ACK_SIZE) {
+        return;
+    }
+
+    const uint8_t *p = frame->payload;
+    int64_t rtt = sender_clock_at(now_us()) - (int64_t)frame_read_u64(p + 4);
+    if (rtt_count < MAX_RTT_SAMPLES) {
+        rtt_us[rtt_count++] = rtt < 0 ? 0 : (uint32_t)rtt;
+    }
+    last_recv_to_apply = frame_read_u32(p + 12);
+    last_apply_to_flush = frame_read_u32(p + 16);
+    board_p50 = frame_read_u32(p + 20);
+    board_p99 = frame_read_u32(p + 24);
+    board_max = frame_read_u32(p + 28);
+    probes_acked++;
+}
+
+/* Read whatever the receiver sent back, without blocking */
+static void poll_acks(void)
+{
+    uint8_t buf[1024];
+    struct pollfd pfd = { .fd = tcp_sock, .events = POLLIN };
+
+    while (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+        ssize_t n = recv(tcp_sock, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n <= 0) {
+            if (n == 0) {
+                fprintf(stderr, "receiver closed the connection\n");
+                stop = 1;
+            }
+            return;
+        }
+        frame_parser_feed(&ack_parser, buf, (size_t)n, on_ack, NULL);
+    }
+}
+
+/* Sleep until `t_us`, but read answers the moment they arrive: a TIME_RESP
+ * stamped late makes the receiver's clock estimate worse */
+static void wait_until(int64_t t_us)
+{
+    struct pollfd pfd = { .fd = tcp_sock, .events = POLLIN };
+    int64_t delta;
+
+    while (!stop && (delta = t_us - now_us()) > 0) {
+        struct timespec ts = { delta / 1000000, (delta % 1000000) * 1000 };
+        if (ppoll(&pfd, 1, &ts, NULL) > 0) {
+            poll_acks();
+        }
+    }
+}
+
+/* ============================================================
+ * REPORTING
+ * ============================================================ */
+static void report(int64_t elapsed_us, uint64_t samples, uint64_t bytes, int64_t span_us)
+{
+    double s = span_us / 1e6;
+    printf("%7.1f s  %9.0f samples/s  %7.2f Mbit/s",
+           elapsed_us / 1e6, samples / s, bytes * 8 / s / 1e6);
+    if (probes_acked > 0) {
+        printf("  | acked %u/%u  board p50 %.1f p99 %.1f max %.1f ms",
+               probes_acked, probes_sent, board_p50 / 1e3, board_p99 / 1e3, board_max / 1e3);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+static void final_report(int64_t elapsed_us)
+{
+    double s = elapsed_us / 1e6;
+
+    printf("\n==== %s, %.1f s ====\n", opt.udp ? "UDP" : "TCP", s);
+    printf("samples   %llu (%.0f/s)\n", (unsigned long long)samples_sent, samples_sent / s);
+    if (batches_sent > 0) {
+        printf("batches   %llu (%.1f samples each)\n", (unsigned long long)batches_sent,
+               (double)samples_sent / batches_sent);
+    }
+    printf("bytes     %llu (%.2f Mbit/s)\n", (unsigned long long)bytes_sent,
+           bytes_sent * 8 / s / 1e6);
+    if (opt.udp) {
+        printf("datagrams %llu\n", (unsigned long long)datagrams_sent);
+    }
+    if (samples_skipped > 0) {
+        printf("skipped   %llu (simulated loss)\n", (unsigned long long)samples_skipped);
+    }
+
+    if (opt.sync) {
+        printf("clock     %u sync requests, %u answered\n", sync_seq, syncs_answered);
+    }
+
+    if (probes_sent == 0) {
+        return;
+    }
+    printf("probes    %u sent, %u acked\n", probes_sent, probes_acked);
+    if (rtt_count == 0) {
+        return;
+    }
+
+    qsort(rtt_us, rtt_count, sizeof(rtt_us[0]), cmp_u32);
+    printf("round trip (send -> on screen -> ack)  p50 %.2f  p99 %.2f  max %.2f ms\n",
+           rtt_us[rtt_count / 2] / 1e3, rtt_us[(rtt_count - 1) * 99 / 100] / 1e3,
+           rtt_us[rtt_count - 1] / 1e3);
+    printf("board recv -> flush                    p50 %.2f  p99 %.2f  max %.2f ms\n",
+           board_p50 / 1e3, board_p99 / 1e3, board_max / 1e3);
+    printf("last probe: recv -> apply %.2f ms, apply -> flush %.2f ms\n",
+           last_recv_to_apply / 1e3, last_apply_to_flush / 1e3);
+}
+
+/* ============================================================
+ * SAMPLE SOURCES
+ * ============================================================ */
+
+/* Synthetic: every channel a slow sine with its own phase */
+static int32_t synth_value(int channel, uint64_t tick)
+{
+    double t = tick / opt.rate_hz;
+    return (int32_t)(50000 + 40000 * sin(t * 0.5 + channel * 0.37));
+}
+
+static log_sample_t *load_log(const char *path, size_t *count)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        die(path);
+    }
+
+    size_t cap = 4096, n = 0;
+    log_sample_t *samples = malloc(cap * sizeof(*samples));
+    char line[256];
+    int lineno = 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        double t;
+        unsigned channel;
+        long value;
+        if (sscanf(line, "%lf,%u,%ld", &t, &channel, &value) != 3 || channel > UINT16_MAX) {
+            fprintf(stderr, "%s:%d: expected seconds,channel,value\n", path, lineno);
+            exit(1);
+        }
+        if (n == cap) {
+            cap *= 2;
+            samples = realloc(samples, cap * sizeof(*samples));
+        }
+        samples[n++] = (log_sample_t){ (int64_t)(t * 1e6), (uint16_t)channel, (int32_t)value };
+    }
+    fclose(f);
+
+    if (n == 0) {
+        fprintf(stderr, "%s: no samples\n", path);
+        exit(1);
+    }
+    *count = n;
+    return samples;
+}
+
+/* ============================================================
+ * MAIN LOOP
+ * One pass per burst: send what is due, poll acks, maybe probe,
+ * maybe print, sleep until the next burst is due.
+ * ============================================================ */
+static void run(void)
+{
+    size_t log_count = 0, log_next = 0;
+    log_sample_t *log = NULL;
+    if (opt.replay_path != NULL) {
+        log = load_log(opt.replay_path, &log_count);
+    }
+
+    int64_t burst_us = (int64_t)(opt.burst * 1e6 / opt.rate_hz);
+    int64_t probe_us = opt.probe_hz > 0 ? (int64_t)(1e6 / opt.probe_hz) : 0;
+    int64_t start = now_us();
+    int64_t next_burst = start, next_probe = start, next_report = start + REPORT_INTERVAL_US;
+    int64_t next_sync = opt.sync ? start : INT64_MAX;
+    int64_t last_report = start;
+    uint64_t tick = 0, samples_at_report = 0, bytes_at_report = 0;
+
+    while (!stop) {
+        int64_t now = now_us();
+        int64_t elapsed = now - start;
+        if (opt.duration_s > 0 && elapsed >= (int64_t)(opt.duration_s * 1e6)) {
+            break;
+        }
+
+        bool paused = opt.off_ms > 0 &&
+                      (elapsed / 1000) % (opt.on_ms + opt.off_ms) >= opt.on_ms;
+
+        if (log != NULL) {
+            /* Replay: everything whose scaled timestamp has passed */
+            int64_t log_t = log[0].t_us + (int64_t)(elapsed * opt.speed);
+            while (log_next < log_count && log[log_next].t_us <= log_t) {
+                if (!paused) {
+                    queue_value(log[log_next].channel, log[log_next].value,
+                                start + (int64_t)((log[log_next].t_us - log[0].t_us) / opt.speed));
+                }
+                log_next++;
+            }
+            flush_samples();
+            if (log_next == log_count) {
+                break;
+            }
+        } else if (now >= next_burst) {
+            /* Synthetic: `burst` ticks of every channel, then wait */
+            for (int b = 0; b < opt.burst; b++, tick++) {
+                /* A burst is what the sensors collected since the last one */
+                int64_t t = next_burst - (int64_t)((opt.burst - 1 - b) * 1e6 / opt.rate_hz);
+                for (int ch = 0; ch < opt.channels && !paused; ch++) {
+                    queue_value((uint16_t)ch, synth_value(ch, tick), t);
+                }
+            }
+            flush_samples();
+            next_burst += burst_us;
+            if (next_burst < now - 1000000) {
+                next_burst = now;   /* Hopelessly behind: don't try to catch up a second of backlog */
+            }
+        }
+
+        poll_acks();
+
+        if (probe_us > 0 && now >= next_probe) {
+            send_probe();
+            next_probe += probe_us;
+        }
+
+        if (now >= next_sync) {
+            send_time_request();
+            next_sync += sync_seq < SYNC_FAST_COUNT ? 250000 : 1000000;
+        }
+
+        if (now >= next_report) {
+            report(elapsed, samples_sent - samples_at_report, bytes_sent - bytes_at_report,
+                   now - last_report);
+            samples_at_report = samples_sent;
+            bytes_at_report = bytes_sent;
+            last_report = now;
+            next_report += REPORT_INTERVAL_US;
+        }
+
+        int64_t wake = next_report;
+        if (log != NULL) {
+            int64_t due = start + (int64_t)((log[log_next].t_us - log[0].t_us) / opt.speed);
+            wake = due < wake ? due : wake;
+        } else if (next_burst < wake) {
+            wake = next_burst;
+        }
+        if (probe_us > 0 && next_probe < wake) {
+            wake = next_probe;
+        }
+        if (next_sync < wake) {
+            wake = next_sync;
+        }
+        wait_until(wake);
+    }
+
+    /* Give the last probes a moment to come back */
+    int64_t drain_until = now_us() + 200000;
+    while (probes_acked < probes_sent && now_us() < drain_until) {
+        poll_acks();
+        sleep_until(now_us() + 5000);
+    }
+
+    final_report(now_us() - start);
+    free(log);
+    free(pending);
+}
+
+/* ============================================================
+ * SETUP
+ * ============================================================ */
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-H host] [-t tcp_port] [-u udp_port] [-m tcp|udp] [-c channels]\n"
+            "          [-r hz] [-b burst] [-p on_ms:off_ms] [-d seconds] [-R race.csv]\n"
+            "          [-s speed] [-P probe_hz] [-L loss_percent] [-B] [-C]\n"
+            "          [-T offset_ms[:drift_ppm]]\n", argv0);
+    exit(2);
+}
+
+static void parse_args(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "H:t:u:m:c:r:b:p:d:R:s:P:L:BCT:h")) != -1) {
+        switch (c) {
+            case 'H': opt.host = optarg; break;
+            case 't': opt.tcp_port = (uint16_t)atoi(optarg); break;
+            case 'u': opt.udp_port = (uint16_t)atoi(optarg); break;
+            case 'm': opt.udp = strcmp(optarg, "udp") == 0; break;
+            case 'c': opt.channels = atoi(optarg); break;
+            case 'r': opt.rate_hz = atof(optarg); break;
+            case 'b': opt.burst = atoi(optarg); break;
+            case 'p':
+                if (sscanf(optarg, "%d:%d", &opt.on_ms, &opt.off_ms) != 2) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'd': opt.duration_s = atof(optarg); break;
+            case 'R': opt.replay_path = optarg; break;
+            case 's': opt.speed = atof(optarg); break;
+            case 'P': opt.probe_hz = atof(optarg); break;
+            case 'L': opt.loss_percent = atof(optarg); break;
+            case 'B': opt.batch = true; break;
+            case 'C': opt.critical_probes = true; break;
+            case 'T':
+                opt.sync = true;
+                sscanf(optarg, "%lf:%lf", &opt.clock_offset_ms, &opt.clock_drift_ppm);
+                break;
+            default: usage(argv[0]);
+        }
+    }
+
+    if (opt.channels < 1 || opt.channels > UINT16_MAX + 1 || opt.rate_hz <= 0 ||
+        opt.burst < 1 || opt.speed < 1 || opt.speed > 100 ||
+        (opt.off_ms > 0 && opt.on_ms <= 0)) {
+        usage(argv[0]);
+    }
+}
+
+static void open_sockets(void)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (inet_pton(AF_INET, opt.host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "bad address %s\n", opt.host);
+        exit(1);
+    }
+
+    /* TCP: the sample stream in TCP mode, and always the ack channel */
+    tcp_sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (tcp_sock < 0) {
+        die("socket");
+    }
+    int one = 1;
+    setsockopt(tcp_sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    addr.sin_port = htons(opt.tcp_port);
+    if (connect(tcp_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        die("connect");
+    }
+
+    if (opt.udp) {
+        udp_sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (udp_sock < 0) {
+            die("socket");
+        }
+        udp_dest = addr;
+        udp_dest.sin_port = htons(opt.udp_port);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    parse_args(argc, argv);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    rtt_us = malloc(MAX_RTT_SAMPLES * sizeof(*rtt_us));
+    if (rtt_us == NULL) {
+        die("malloc");
+    }
+    frame_parser_init(&ack_parser);
+    open_sockets();
+
+    if (opt.replay_path != NULL) {
+        printf("Replaying %s at %.0fx to %s over %s\n", opt.replay_path, opt.speed, opt.host,
+               opt.udp ? "UDP" : "TCP");
+    } else {
+        printf("%d channels x %.0f Hz (%.0f samples/s) to %s over %s, burst %d%s\n",
+               opt.channels, opt.rate_hz, opt.channels * opt.rate_hz, opt.host,
+               opt.udp ? "UDP" : "TCP", opt.burst, opt.batch ? ", batched" : "");
+    }
+
+    run();
+
+    close(tcp_sock);
+    if (udp_sock >= 0) {
+        close(udp_sock);
+    }
+    free(rtt_us);
+    return 0;
+}
@@ -0,0 +1,365 @@
+/*
+ * recextract.c
+ * Turn a flight recording (components/recorder) back into a frame stream
+ *
+ * Input is the recorder partition as one file: the host build's -r
+ * file, or the board's partition read back with
+ *   parttool.py read_partition --partition-name recorder --output rec.bin
+ *
+ * Blocks are put in order by their sequence numbers; the block headers
+ * are the seek index, so -f only reads the blocks it needs.
+ *
+ * Usage: recextract [options] recording.bin
+ *   -l            list the sessions (and with -v every block) and exit
+ *   -S session    session to extract      (the newest)
+ *   -f seconds    start this far into the session   (0)
+ *   -t seconds    stop this far into the session    (end)
+ *   -o file       write the frames back to back, as they were received
+ *                 (replay with e.g. `nc board 5000 < file`)
+ *   -H host       replay to a receiver over TCP, with the recorded timing
+ *   -p port       TCP port for -H              (5000)
+ *   -s speed      replay speed for -H, 1..100  (1)
+ *   -v            more detail with -l; report bad blocks
+ */
+
+#define _GNU_SOURCE
+
+#include "frame.h"
+#include "recorder_format.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+typedef struct {
+    bool list;
+    bool verbose;
+    int session;                /* -1 = newest */
+    double from_s;
+    double to_s;                /* < 0 = to the end */
+    const char *out;
+    const char *host;
+    int port;
+    int speed;
+    const char *path;
+} options_t;
+
+static options_t opt = {
+    .session = -1,
+    .to_s = -1,
+    .port = 5000,
+    .speed = 1,
+};
+
+/* One valid block, from the index */
+typedef struct {
+    recorder_block_t h;
+    uint32_t slot;
+} entry_t;
+
+static FILE *in;
+static entry_t *blocks;         /* Valid blocks, oldest first */
+static size_t block_count;
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static void die(const char *what)
+{
+    perror(what);
+    exit(1);
+}
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_until(int64_t t_us)
+{
+    int64_t delta = t_us - now_us();
+    if (delta > 0) {
+        struct timespec ts = { delta / 1000000, (delta % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static int cmp_seq(const void *a, const void *b)
+{
+    const entry_t *x = a, *y = b;
+    int32_t d = (int32_t)(x->h.seq - y->h.seq);     /* Survives wrap-around */
+    return (d > 0) - (d < 0);
+}
+
+/* ============================================================
+ * INDEX
+ * ============================================================ */
+
+/* Read every block header; keep the valid ones, oldest first */
+static void load_index(void)
+{
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    uint32_t slots = (uint32_t)(size / RECORDER_BLOCK_SIZE);
+
+    blocks = calloc(slots ? slots : 1, sizeof(*blocks));
+    if (blocks == NULL) {
+        die("calloc");
+    }
+
+    uint8_t header[RECORDER_HEADER_SIZE];
+    for (uint32_t slot = 0; slot < slots; slot++) {
+        entry_t e = { .slot = slot };
+        if (fseek(in, (long)slot * RECORDER_BLOCK_SIZE, SEEK_SET) != 0 ||
+            fread(header, sizeof(header), 1, in) != 1 ||
+            !recorder_read_header(header, &e.h) || e.h.seq % slots != slot) {
+            continue;
+        }
+        blocks[block_count++] = e;
+    }
+    qsort(blocks, block_count, sizeof(*blocks), cmp_seq);
+}
+
+/* Blocks [*first, *end) belong to `session` (blocks are in session order) */
+static bool session_range(uint16_t session, size_t *first, size_t *end)
+{
+    size_t i = 0;
+    while (i < block_count && blocks[i].h.session != session) {
+        i++;
+    }
+    if (i == block_count) {
+        return false;
+    }
+    *first = i;
+    while (i < block_count && blocks[i].h.session == session) {
+        i++;
+    }
+    *end = i;
+    return true;
+}
+
+/* recorder_seek() over the index; it has no holes */
+static const recorder_block_t *block_at(uint32_t i, void *ctx)
+{
+    (void)ctx;
+    return &blocks[i].h;
+}
+
+static void list_sessions(void)
+{
+    size_t i = 0;
+
+    printf("%zu blocks\n", block_count);
+    while (i < block_count) {
+        size_t first, end;
+        session_range(blocks[i].h.session, &first, &end);
+
+        uint64_t records = 0;
+        for (size_t j = first; j < end; j++) {
+            records += blocks[j].h.records;
+        }
+        printf("session %5u  %6zu blocks  %9llu frames  %9.3f s\n", blocks[first].h.session,
+               end - first, (unsigned long long)records,
+               (blocks[end - 1].h.last_us - blocks[first].h.first_us) / 1e6);
+
+        if (opt.verbose) {
+            for (size_t j = first; j < end; j++) {
+                const recorder_block_t *h = &blocks[j].h;
+                printf("    block %8lu  slot %6lu  %5u frames  %5u bytes  %9.3f .. %9.3f s\n",
+                       (unsigned long)h->seq, (unsigned long)blocks[j].slot, h->records, h->used,
+                       (h->first_us - blocks[first].h.first_us) / 1e6,
+                       (h->last_us - blocks[first].h.first_us) / 1e6);
+            }
+        }
+        i = end;
+    }
+}
+
+/* ============================================================
+ * EXTRACT / REPLAY
+ * ============================================================ */
+static int open_receiver(void)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opt.port);
+    if (inet_pton(AF_INET, opt.host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "bad address %s\n", opt.host);
+        exit(1);
+    }
+
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        die("socket");
+    }
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        die("connect");
+    }
+    return sock;
+}
+
+static void send_all(int sock, const uint8_t *p, size_t n)
+{
+    while (n > 0) {
+        ssize_t sent = send(sock, p, n, MSG_NOSIGNAL);
+        if (sent < 0) {
+            die("send");
+        }
+        p += sent;
+        n -= (size_t)sent;
+    }
+}
+
+static void extract(uint16_t session, size_t first, size_t end)
+{
+    FILE *out = NULL;
+    int sock = -1;
+
+    if (opt.out != NULL && (out = fopen(opt.out, "wb")) == NULL) {
+        die(opt.out);
+    }
+    if (opt.host != NULL) {
+        sock = open_receiver();
+    }
+
+    int64_t origin = blocks[first].h.first_us;
+    int64_t from = origin + (int64_t)(opt.from_s * 1e6);
+    int64_t to = opt.to_s < 0 ? INT64_MAX : origin + (int64_t)(opt.to_s * 1e6);
+    int64_t start = now_us();
+    uint64_t frames = 0, bytes = 0, bad_blocks = 0;
+    uint8_t block[RECORDER_BLOCK_SIZE];
+
+    size_t i = recorder_seek((uint32_t)block_count, block_at, NULL, session, from);
+    for (; i < end && blocks[i].h.first_us <= to; i++) {
+        const recorder_block_t *h = &blocks[i].h;
+
+        if (fseek(in, (long)blocks[i].slot * RECORDER_BLOCK_SIZE, SEEK_SET) != 0 ||
+            fread(block, sizeof(block), 1, in) != 1 ||
+            frame_crc16(block + RECORDER_HEADER_SIZE, h->used - RECORDER_HEADER_SIZE) != h->crc) {
+            bad_blocks++;
+            if (opt.verbose) {
+                fprintf(stderr, "block %lu: bad CRC, skipped\n", (unsigned long)h->seq);
+            }
+            continue;
+        }
+
+        const uint8_t *p = block + RECORDER_HEADER_SIZE;
+        const uint8_t *block_end = block + h->used;
+        while (p + RECORDER_RECORD_HEADER_SIZE <= block_end) {
+            int64_t t = h->first_us + frame_read_u32(p);
+            uint16_t len = frame_read_u16(p + 4);
+            const uint8_t *wire = p + RECORDER_RECORD_HEADER_SIZE;
+            if (wire + len > block_end) {
+                break;
+            }
+            p = wire + len;
+            if (t < from || t > to) {
+                continue;
+            }
+
+            if (out != NULL) {
+                fwrite(wire, 1, len, out);
+            }
+            if (sock >= 0) {
+                sleep_until(start + (t - from) / opt.speed);
+                send_all(sock, wire, len);
+            }
+            frames++;
+            bytes += len;
+        }
+    }
+
+    fprintf(stderr, "session %u: %llu frames, %llu bytes%s", session,
+            (unsigned long long)frames, (unsigned long long)bytes,
+            bad_blocks ? "" : "\n");
+    if (bad_blocks) {
+        fprintf(stderr, ", %llu bad blocks skipped\n", (unsigned long long)bad_blocks);
+    }
+
+    if (out != NULL) {
+        fclose(out);
+    }
+    if (sock >= 0) {
+        /* Read until the receiver closes too: closing with its probe
+         * acks unread would reset the connection and could throw away
+         * frames it has not read yet */
+        char discard[256];
+        shutdown(sock, SHUT_WR);
+        while (recv(sock, discard, sizeof(discard), 0) > 0) {
+        }
+        close(sock);
+    }
+}
+
+/* ============================================================
+ * MAIN
+ * ============================================================ */
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-l] [-v] [-S session] [-f from_s] [-t to_s] [-o out.bin]\n"
+                    "          [-H host] [-p port] [-s speed] recording.bin\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "lvS:f:t:o:H:p:s:h")) != -1) {
+        switch (c) {
+            case 'l': opt.list = true; break;
+            case 'v': opt.verbose = true; break;
+            case 'S': opt.session = atoi(optarg); break;
+            case 'f': opt.from_s = atof(optarg); break;
+            case 't': opt.to_s = atof(optarg); break;
+            case 'o': opt.out = optarg; break;
+            case 'H': opt.host = optarg; break;
+            case 'p': opt.port = atoi(optarg); break;
+            case 's': opt.speed = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 || opt.speed < 1 || opt.speed > 100 ||
+        (!opt.list && opt.out == NULL && opt.host == NULL)) {
+        usage(argv[0]);
+    }
+    opt.path = argv[optind];
+
+    if ((in = fopen(opt.path, "rb")) == NULL) {
+        die(opt.path);
+    }
+    load_index();
+
+    if (opt.list) {
+        list_sessions();
+        return 0;
+    }
+    if (block_count == 0) {
+        fprintf(stderr, "%s: no recorded blocks\n", opt.path);
+        return 1;
+    }
+
+    uint16_t session = opt.session < 0 ? blocks[block_count - 1].h.session : (uint16_t)opt.session;
+    size_t first, end;
+    if (!session_range(session, &first, &end)) {
+        fprintf(stderr, "%s: no session %u (see -l)\n", opt.path, session);
+        return 1;
+    }
+
+    extract(session, first, end);
+    fclose(in);
+    return 0;
+}
@@ -0,0 +1,274 @@
+/*
+ * recseek.c
+ * Check of the recording seek: recorder_seek() and recorder_find_block()
+ *
+ *   search    recorder_seek() over random runs of blocks with random
+ *             holes (erased, failed or half-written slots), against a
+ *             linear scan, for every session and a spread of times
+ *   device    the real recorder.c on a file-backed partition of
+ *             PARTITION_SLOTS blocks: an older session already on
+ *             flash, with a hole, a new one recorded over it until the
+ *             ring wraps, then recorder_find_block() asked for the first, a middle,
+ *             a between-blocks and the last moment of each session,
+ *             times before and after them and unknown sessions
+ *
+ * Exits non-zero on the first wrong answer.
+ *
+ * Usage: recseek [-n runs]
+ */
+
+#define _GNU_SOURCE
+
+#include "frame.h"
+#include "recorder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define SEARCH_MAX_BLOCKS   40
+#define PARTITION_SLOTS     32
+#define OLD_SESSION         5
+#define OLD_BLOCKS          10      /* Session 5: seq 0..9, 1 s apart */
+#define OLD_HOLE            4       /* ...but that one never made it to flash */
+#define NEW_BLOCKS          25      /* Session 6: seq 10..34, wraps over seq 0..2 */
+#define FRAME_PERIOD_US     100000
+#define BLOCK_FRAMES        (RECORDER_FLUSH_MS * 1000 / FRAME_PERIOD_US)    /* Per sealed block */
+#define NEW_ORIGIN_US       1000000
+
+static int failures;
+
+#define CHECK(cond, ...)                                    \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);          \
+            fputc('\n', stderr);                            \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+/* ============================================================
+ * SEARCH
+ * ============================================================ */
+typedef struct {
+    recorder_block_t h[SEARCH_MAX_BLOCKS];
+    bool hole[SEARCH_MAX_BLOCKS];
+} run_t;
+
+static const recorder_block_t *run_at(uint32_t i, void *ctx)
+{
+    run_t *run = ctx;
+    return run->hole[i] ? NULL : &run->h[i];
+}
+
+static uint32_t linear_seek(run_t *run, uint32_t n, uint16_t session, int64_t t_us)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        if (!run->hole[i] && !recorder_block_before(&run->h[i], session, t_us)) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static void check_search(int runs)
+{
+    run_t run;
+    uint32_t queries = 0;
+
+    srand(1);
+    for (int r = 0; r < runs; r++) {
+        uint32_t n = (uint32_t)(rand() % (SEARCH_MAX_BLOCKS + 1));
+        int hole_pct = rand() % 4 == 0 ? 90 : rand() % 40;
+        uint16_t session = (uint16_t)(rand() % 3 == 0 ? 65534 : 1);    /* Wraps too */
+        int64_t t = 0;
+
+        for (uint32_t i = 0; i < n; i++) {
+            if (rand() % 6 == 0) {
+                session++;
+                t = 0;
+            }
+            run.h[i] = (recorder_block_t){ .session = session, .first_us = t,
+                                           .last_us = t + rand() % 1000, .used = 1 };
+            t = run.h[i].last_us + rand() % 100;
+            run.hole[i] = rand() % 100 < hole_pct;
+        }
+
+        for (uint16_t s = session - 8; s != (uint16_t)(session + 2); s++) {
+            for (int64_t q = -1; q < t + 1000; q += 1 + rand() % 200) {
+                uint32_t got = recorder_seek(n, run_at, &run, s, q);
+                uint32_t want = linear_seek(&run, n, s, q);
+                CHECK(got == want, "search: %u blocks, session %u t %lld: got %u, want %u",
+                      n, s, (long long)q, got, want);
+                queries++;
+                if (failures != 0) {
+                    return;
+                }
+            }
+        }
+    }
+    printf("search   %d runs, %u queries\n", runs, queries);
+}
+
+/* ============================================================
+ * DEVICE
+ * ============================================================ */
+static int64_t old_first(uint32_t seq)  { return (int64_t)seq * 1000000; }
+static int64_t old_last(uint32_t seq)   { return old_first(seq) + 900000; }
+static int64_t new_first(uint32_t b)    { return NEW_ORIGIN_US + (int64_t)b * RECORDER_FLUSH_MS * 1000; }
+static int64_t new_last(uint32_t b)     { return new_first(b) + RECORDER_FLUSH_MS * 1000 - FRAME_PERIOD_US; }
+
+static int64_t rx_time;
+
+static void record_frame(const frame_t *frame, void *ctx)
+{
+    (void)ctx;
+    network_rx_info_t rx = { .rx_time_us = rx_time, .conn = 0, .lane = NETWORK_LANE_BULK };
+    recorder_record(frame, &rx);
+}
+
+/* Wait for the recorder task to write the first `blocks` blocks */
+static void wait_blocks(uint32_t blocks)
+{
+    recorder_stats_t stats;
+    recorder_get_stats(&stats);
+    for (int i = 0; i < 1000 && stats.blocks < blocks; i++) {
+        usleep(1000);
+        recorder_get_stats(&stats);
+    }
+}
+
+static int seeks;
+
+static void expect(uint16_t session, int64_t t_us, bool found, uint32_t seq)
+{
+    recorder_block_t h;
+    bool got = recorder_find_block(session, t_us, &h);
+    seeks++;
+    if (found) {
+        CHECK(got && h.seq == seq && h.session == session,
+              "device: session %u t %lld: got %s seq %lu, want seq %lu", session,
+              (long long)t_us, got ? "" : "nothing,", got ? (unsigned long)h.seq : 0ul,
+              (unsigned long)seq);
+    } else {
+        CHECK(!got, "device: session %u t %lld: got seq %lu, want nothing", session,
+              (long long)t_us, (unsigned long)h.seq);
+    }
+}
+
+static void check_device(void)
+{
+    char path[] = "/tmp/recseekXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || esp_partition_host_attach(RECORDER_PARTITION_LABEL, RECORDER_PARTITION_SUBTYPE,
+                                            path, PARTITION_SLOTS * RECORDER_BLOCK_SIZE) != ESP_OK) {
+        perror(path);
+        exit(1);
+    }
+    close(fd);
+    unlink(path);
+
+    /* Session 5 was recorded by an earlier boot */
+    const esp_partition_t *part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)RECORDER_PARTITION_SUBTYPE,
+        RECORDER_PARTITION_LABEL);
+    uint8_t block[RECORDER_BLOCK_SIZE];
+    memset(block, 0xFF, sizeof(block));
+    for (uint32_t seq = 0; seq < OLD_BLOCKS; seq++) {
+        if (seq == OLD_HOLE) {
+            continue;
+        }
+        recorder_block_t h = { .seq = seq, .session = OLD_SESSION, .used = RECORDER_HEADER_SIZE,
+                               .first_us = old_first(seq), .last_us = old_last(seq) };
+        recorder_write_header(block, &h);
+        esp_partition_write(part, (size_t)seq * RECORDER_BLOCK_SIZE, block, sizeof(block));
+    }
+
+    if (recorder_init() != ESP_OK) {
+        fprintf(stderr, "FAIL: device: recorder_init\n");
+        exit(1);
+    }
+
+    /* Session 6: each block sealed by the poll, BLOCK_FRAMES frames in */
+    uint8_t wire[32];
+    for (uint32_t i = 0; i < NEW_BLOCKS * BLOCK_FRAMES; i++) {
+        int64_t t = NEW_ORIGIN_US + (int64_t)i * FRAME_PERIOD_US;
+        recorder_poll(t);
+        wait_blocks(i / BLOCK_FRAMES);
+        rx_time = t;
+        uint32_t payload = i;
+        size_t len = frame_encode(wire, sizeof(wire), FRAME_TYPE_VALUE, 1, &payload,
+                                  sizeof(payload));
+        frame_parse_buffer(wire, len, record_frame, NULL, NULL);
+    }
+    recorder_poll(rx_time + RECORDER_FLUSH_MS * 1000);
+    wait_blocks(NEW_BLOCKS);
+
+    recorder_stats_t stats;
+    recorder_get_stats(&stats);
+    CHECK(stats.session == OLD_SESSION + 1 && stats.blocks == NEW_BLOCKS && stats.dropped == 0,
+          "device: session %u, %lu blocks, %lu dropped", stats.session,
+          (unsigned long)stats.blocks, (unsigned long)stats.dropped);
+
+    /* The ring holds seq 3..34: session 5 lost its first three blocks */
+    uint32_t old_kept = OLD_BLOCKS + NEW_BLOCKS - PARTITION_SLOTS;
+    expect(OLD_SESSION, -1, true, old_kept);
+    expect(OLD_SESSION, old_first(1), true, old_kept);
+    expect(OLD_SESSION, old_first(OLD_HOLE) + 500000, true, OLD_HOLE + 1);
+    expect(OLD_SESSION, old_first(6) + 500000, true, 6);
+    expect(OLD_SESSION, old_last(6) + 50000, true, 7);
+    expect(OLD_SESSION, old_last(OLD_BLOCKS - 1), true, OLD_BLOCKS - 1);
+    expect(OLD_SESSION, old_last(OLD_BLOCKS - 1) + 1, false, 0);
+
+    uint16_t s = OLD_SESSION + 1;
+    expect(s, 0, true, OLD_BLOCKS);
+    expect(s, new_first(0), true, OLD_BLOCKS);
+    expect(s, new_first(12) + 500000, true, OLD_BLOCKS + 12);
+    expect(s, new_last(12), true, OLD_BLOCKS + 12);
+    expect(s, new_last(12) + 50000, true, OLD_BLOCKS + 13);
+    expect(s, new_last(NEW_BLOCKS - 1), true, OLD_BLOCKS + NEW_BLOCKS - 1);
+    expect(s, new_last(NEW_BLOCKS - 1) + 1, false, 0);
+    expect(s, INT64_MAX, false, 0);
+
+    expect(OLD_SESSION - 1, 0, false, 0);
+    expect(OLD_SESSION + 2, 0, false, 0);
+
+    printf("device   %u slots, sessions %u and %u, %d seeks\n", PARTITION_SLOTS, OLD_SESSION,
+           s, seeks);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-n runs]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int runs = 2000;
+    int c;
+    while ((c = getopt(argc, argv, "n:h")) != -1) {
+        switch (c) {
+            case 'n': runs = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    check_search(runs);
+    check_device();
+
+    if (failures != 0) {
+        fprintf(stderr, "%d failures\n", failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
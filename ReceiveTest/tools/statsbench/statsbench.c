@@ -0,0 +1,234 @@
+/*
+ * statsbench.c
+ * Accuracy of the running statistics against a two-pass reference,
+ * and the cost of stats_update()
+ *
+ * Feeds each stats channel a long run of samples the way the network
+ * task does, then compares what stats_read() reports with the mean and
+ * variance computed the textbook way (two passes, long double) over
+ * the same samples:
+ *
+ *   pack voltage  ~100 V in mV, small noise on a big offset - the case
+ *                 that loses digits when M2 is a float
+ *   pack current  a slow swing through zero plus noise
+ *
+ * Then a lap: stats_request_reset_all() mid-stream, and the snapshot
+ * must cover only the samples after it (count, min/max, mean and
+ * variance). Mean and variance must agree to 1e-9 relative; exits
+ * non-zero if they do not.
+ *
+ * Usage: statsbench [-n samples] [-r repeats]
+ */
+
+#define _GNU_SOURCE
+
+#include "stats.h"
+#include "telemetry_channels.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+
+esp_log_level_t host_log_level = ESP_LOG_WARN;
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define SAMPLE_US       10000       /* 100 Hz */
+#define MAX_REL_ERR     1e-9
+
+typedef struct {
+    int samples;
+    int repeats;
+} options_t;
+
+static options_t opt = {
+    .samples = 2000000,
+    .repeats = 5,
+};
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int32_t synth_value(uint16_t channel, int n)
+{
+    if (channel == CH_PACK_VOLTAGE) {
+        return 100000 + rand() % 101 - 50;
+    }
+    return (int32_t)(30000 * sin(n * 0.0003)) + rand() % 2001 - 1000;
+}
+
+/* ============================================================
+ * REFERENCE
+ * ============================================================ */
+typedef struct {
+    int32_t *values;
+    int count;
+} series_t;
+
+static void reference(const series_t *s, long double *mean, long double *variance)
+{
+    long double sum = 0, sq = 0;
+    for (int i = 0; i < s->count; i++) {
+        sum += s->values[i];
+    }
+    *mean = sum / s->count;
+    for (int i = 0; i < s->count; i++) {
+        long double d = s->values[i] - *mean;
+        sq += d * d;
+    }
+    *variance = s->count > 1 ? sq / (s->count - 1) : 0;
+}
+
+static double rel_err(double got, long double want)
+{
+    long double scale = fabsl(want) > 1 ? fabsl(want) : 1;
+    return (double)(fabsl((long double)got - want) / scale);
+}
+
+/* The snapshot agrees with the reference over `s` */
+static bool check(const char *step, uint16_t channel, const series_t *s)
+{
+    stats_snapshot_t snap;
+    long double mean, variance;
+    int32_t lo = s->values[0], hi = s->values[0];
+
+    for (int i = 1; i < s->count; i++) {
+        lo = s->values[i] < lo ? s->values[i] : lo;
+        hi = s->values[i] > hi ? s->values[i] : hi;
+    }
+    reference(s, &mean, &variance);
+
+    bool ok = stats_read(channel, &snap) && snap.count == (uint32_t)s->count &&
+              snap.min == lo && snap.max == hi;
+    double mean_err = rel_err(snap.mean, mean);
+    double var_err = rel_err(snap.variance, variance);
+    ok = ok && mean_err <= MAX_REL_ERR && var_err <= MAX_REL_ERR;
+
+    printf("%-22s %-13s %8lu samples  mean %14.4f (err %.1e)  variance %14.4f (err %.1e)  %s\n",
+           step, telemetry_channel_info[channel].name, (unsigned long)snap.count, snap.mean,
+           mean_err, snap.variance, var_err, ok ? "ok" : "MISMATCH");
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s %s: %lu samples [%ld, %ld], expected %d [%ld, %ld] "
+                "mean %.6Lf variance %.6Lf\n", step, telemetry_channel_info[channel].name,
+                (unsigned long)snap.count, (long)snap.min, (long)snap.max, s->count,
+                (long)lo, (long)hi, mean, variance);
+    }
+    return ok;
+}
+
+/* ============================================================
+ * ACCURACY
+ * ============================================================ */
+static bool check_accuracy(void)
+{
+    static const uint16_t channels[] = { CH_PACK_VOLTAGE, CH_PACK_CURRENT };
+    enum { CHANNELS = sizeof(channels) / sizeof(channels[0]) };
+    series_t before[CHANNELS], lap[CHANNELS];
+    int lap_start = opt.samples / 2;
+    int64_t t_us = 0;
+    bool ok = true;
+
+    for (int c = 0; c < CHANNELS; c++) {
+        before[c].values = malloc((size_t)opt.samples * sizeof(int32_t));
+        before[c].count = 0;
+        if (before[c].values == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+        lap[c].values = before[c].values + lap_start;
+        lap[c].count = 0;
+    }
+
+    stats_init();
+    for (int n = 0; n < opt.samples; n++, t_us += SAMPLE_US) {
+        if (n == lap_start) {
+            for (int c = 0; c < CHANNELS; c++) {
+                ok &= check("before the lap marker", channels[c], &before[c]);
+            }
+            stats_request_reset_all();
+        }
+        for (int c = 0; c < CHANNELS; c++) {
+            int32_t v = synth_value(channels[c], n);
+            before[c].values[before[c].count++] = v;
+            if (n >= lap_start) {
+                lap[c].count++;
+            }
+            stats_update(channels[c], v, t_us);
+        }
+    }
+    for (int c = 0; c < CHANNELS; c++) {
+        ok &= check("after the lap marker", channels[c], &lap[c]);
+        free(before[c].values);
+    }
+    return ok;
+}
+
+/* ============================================================
+ * BENCHMARK
+ * ============================================================ */
+static void bench(void)
+{
+    int64_t best = INT64_MAX;
+    int32_t *values = malloc((size_t)opt.samples * sizeof(int32_t));
+    if (values == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (int n = 0; n < opt.samples; n++) {
+        values[n] = synth_value(CH_PACK_VOLTAGE, n);
+    }
+
+    for (int r = 0; r < opt.repeats; r++) {
+        stats_init();
+        stats_request_reset_all();
+        int64_t t0 = now_ns();
+        for (int n = 0; n < opt.samples; n++) {
+            stats_update(CH_PACK_VOLTAGE, values[n], (int64_t)n * SAMPLE_US);
+        }
+        int64_t t = now_ns() - t0;
+        best = t < best ? t : best;
+    }
+    free(values);
+
+    printf("\nstats_update  %d samples, best of %d  %6.1f ns/sample\n", opt.samples,
+           opt.repeats, (double)best / opt.samples);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-n samples] [-r repeats]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:r:h")) != -1) {
+        switch (c) {
+            case 'n': opt.samples = atoi(optarg); break;
+            case 'r': opt.repeats = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.samples < 4 || opt.repeats < 1) {
+        usage(argv[0]);
+    }
+
+    bool ok = check_accuracy();
+    bench();
+    printf("\nmean and variance against the two-pass reference  %s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/*
+ * tracebench.c
+ * Cost of one TRACE() on the host + a check of the ring's bookkeeping
+ *
+ * Times trace_write() in a tight loop, the way a hot path calls it:
+ *
+ *   1 writer   one thread tracing
+ *   N writers  N threads tracing at once, so they contend on the
+ *              ring's head index and on its cache lines
+ *
+ * Reports ns per TRACE() (best of the repeats). Nothing is printed
+ * while timing - the ring just laps itself, as it would if the trace
+ * task were starved.
+ *
+ * Then checks the bookkeeping: every call is counted as written, and
+ * one flush (output thrown away) accounts for every record as either
+ * printed or dropped. Exits non-zero if it does not.
+ *
+ * The firmware number differs: esp_timer_get_time() is a systimer read
+ * on the board rather than clock_gettime().
+ *
+ * Usage: tracebench [-n calls] [-r repeats] [-t threads]
+ */
+
+#define _GNU_SOURCE
+
+#include "trace.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define MAX_THREADS     16
+
+typedef struct {
+    int calls;                  /* Per thread, per repeat */
+    int repeats;
+    int threads;
+} options_t;
+
+static options_t opt = {
+    .calls = 2000000,
+    .repeats = 5,
+    .threads = 2,
+};
+
+/* ============================================================
+ * HELPERS
+ * ============================================================ */
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* ============================================================
+ * BENCHMARK
+ * ============================================================ */
+static pthread_barrier_t start;
+
+static void *writer(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+
+    pthread_barrier_wait(&start);
+    for (int i = 0; i < opt.calls; i++) {
+        TRACE(NET_FRAME, id, i, 0x55, i >> 3);
+    }
+    return NULL;
+}
+
+/* Wall time of `threads` writers doing opt.calls each, ns per call per
+ * thread */
+static double run(int threads)
+{
+    int64_t best = INT64_MAX;
+
+    for (int r = 0; r < opt.repeats; r++) {
+        pthread_t tid[MAX_THREADS];
+
+        pthread_barrier_init(&start, NULL, (unsigned)threads + 1);
+        for (int t = 0; t < threads; t++) {
+            pthread_create(&tid[t], NULL, writer, (void *)(intptr_t)t);
+        }
+        pthread_barrier_wait(&start);
+        int64_t t0 = now_ns();
+        for (int t = 0; t < threads; t++) {
+            pthread_join(tid[t], NULL);
+        }
+        int64_t t = now_ns() - t0;
+        pthread_barrier_destroy(&start);
+        best = t < best ? t : best;
+    }
+    return (double)best / opt.calls;
+}
+
+/* ============================================================
+ * BOOKKEEPING CHECK
+ * ============================================================ */
+
+/* trace_flush() with stdout sent to /dev/null */
+static void flush_quietly(void)
+{
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+
+    trace_flush();
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+}
+
+static bool check_stats(uint32_t expected_written)
+{
+    trace_stats_t s;
+
+    flush_quietly();
+    trace_get_stats(&s);
+    if (s.written == expected_written && s.printed + s.dropped == s.written &&
+        s.printed <= TRACE_RING_SIZE) {
+        return true;
+    }
+    fprintf(stderr, "FAIL: %lu written (expected %lu), %lu printed + %lu dropped\n",
+            (unsigned long)s.written, (unsigned long)expected_written,
+            (unsigned long)s.printed, (unsigned long)s.dropped);
+    return false;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-n calls] [-r repeats] [-t threads]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:r:t:h")) != -1) {
+        switch (c) {
+            case 'n': opt.calls = atoi(optarg); break;
+            case 'r': opt.repeats = atoi(optarg); break;
+            case 't': opt.threads = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.calls < 1 || opt.repeats < 1 || opt.threads < 1 || opt.threads > MAX_THREADS) {
+        usage(argv[0]);
+    }
+
+    printf("%d calls per thread, ring of %d, best of %d\n\n", opt.calls, TRACE_RING_SIZE,
+           opt.repeats);
+    printf("1 writer    %6.1f ns/TRACE\n", run(1));
+    if (opt.threads > 1) {
+        printf("%d writers   %6.1f ns/TRACE (wall time per call per thread)\n", opt.threads,
+               run(opt.threads));
+    }
+
+    int threads_run = 1 + (opt.threads > 1 ? opt.threads : 0);
+    uint32_t written = (uint32_t)opt.calls * (uint32_t)opt.repeats * (uint32_t)threads_run;
+    bool ok = check_stats(written);
+    printf("\nwritten = printed + dropped after a flush  %s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,460 @@
+/*
+ * uibench.c
+ * Pixels filled and render time per update for the UI widgets
+ *
+ * Each scenario puts one widget on an empty 1280 x 800 screen (the
+ * board's display after rotation), renders it once, then applies a
+ * series of updates, rendering after each one the way the LVGL task
+ * does once per refresh period. The flush callback adds up the area
+ * handed to the "panel" - the pixels LVGL had to fill - and the time
+ * spent applying the update and in lv_refr_now() is its cost.
+ *
+ * The flushed areas are also copied into a frame buffer. After the last
+ * update the whole screen is redrawn from scratch and compared with it:
+ * a widget that skips too much shows up as a mismatch.
+ *
+ *   clock     "HH:MM:SS", one second per update (a 1 Hz clock)
+ *   counter   a counter going up by one per update (50 Hz)
+ *
+ * each drawn by a plain lv_label and by a readout (readout.h), both in
+ * Montserrat 48 like the main data display, and
+ *
+ *   grid      a full screen of Montserrat 48 numbers, all changing on
+ *             every update, drawn from the font and from a glyph atlas
+ *             (glyph_atlas.h) - same pixels, render time differs
+ *   chart     three 1200 x 300 live traces, one sample per series per
+ *             update, in an lv_chart (shift mode) and in a strip chart
+ *             (stripchart.h); chart/envelope feeds the strip chart eight
+ *             noisy samples per series per update, chart/catchup sweeps
+ *             it four columns per update (a late refresh, wraps). Chart
+ *             scenarios also report the pixels flushed per new column.
+ *   history   three 10 000-point series in a 1200 x 300 lv_chart, one new
+ *             point each per update - lv_chart's crowded drawing, one
+ *             vertical line per pixel column
+ *
+ * Exits non-zero if any scenario or check shows a mismatch.
+ *
+ * Usage: uibench [-n updates] [-r repeats] [scenario ...]
+ */
+
+#define _GNU_SOURCE
+
+#include "readout.h"
+#include "glyph_atlas.h"
+#include "stripchart.h"
+#include "esp_log.h"
+#include "lvgl.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================================================
+ * CONFIGURATION
+ * ============================================================ */
+#define SCREEN_W        1280
+#define SCREEN_H        800
+#define BUF_LINES       80      /* Partial render buffer, like the board's */
+
+typedef struct {
+    int updates;
+    int repeats;
+} options_t;
+
+static options_t opt = {
+    .updates = 500,
+    .repeats = 5,
+};
+
+esp_log_level_t host_log_level = ESP_LOG_WARN;
+
+/* ============================================================
+ * DISPLAY (counts what is flushed)
+ * ============================================================ */
+static uint8_t draw_buf[SCREEN_W * BUF_LINES * 2];
+static uint16_t frame[SCREEN_W * SCREEN_H];         /* What the panel shows */
+static uint16_t incremental[SCREEN_W * SCREEN_H];
+static uint64_t flushed_px;
+static uint32_t flushes;
+
+static void flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    int32_t w = lv_area_get_width(area);
+    const uint16_t *src = (const uint16_t *)px_map;
+    for (int32_t y = area->y1; y <= area->y2; y++, src += w) {
+        memcpy(&frame[y * SCREEN_W + area->x1], src, w * sizeof(uint16_t));
+    }
+
+    flushed_px += (uint64_t)w * lv_area_get_height(area);
+    flushes++;
+    lv_display_flush_ready(disp);
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint32_t tick_cb(void)
+{
+    return (uint32_t)(now_ns() / 1000000);
+}
+
+/* ============================================================
+ * SCENARIOS
+ * ============================================================ */
+typedef struct {
+    const char *name;
+    lv_obj_t *(*create)(lv_obj_t *screen);
+    void (*update)(lv_obj_t *obj, int step);
+    int columns;            /* Chart columns added per update, 0: not a chart */
+} scenario_t;
+
+static void clock_text(int step, char *buf, size_t size)
+{
+    int s = 12 * 3600 + 34 * 60 + step;
+    snprintf(buf, size, "%02d:%02d:%02d", s / 3600 % 24, s / 60 % 60, s % 60);
+}
+
+static void counter_text(int step, char *buf, size_t size)
+{
+    snprintf(buf, size, "%d", 98700 + step);
+}
+
+/* Plain label / readout, Montserrat 48 */
+static lv_obj_t *create_label(lv_obj_t *screen)
+{
+    lv_obj_t *label = lv_label_create(screen);
+    lv_obj_set_style_text_font(label, &lv_font_montserrat_48, LV_PART_MAIN);
+    lv_obj_set_style_text_color(label, lv_color_hex(0x00FF00), LV_PART_MAIN);
+    lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
+    return label;
+}
+
+static lv_obj_t *create_readout(lv_obj_t *screen)
+{
+    lv_obj_t *readout = readout_create(screen, &lv_font_montserrat_48, 8);
+    lv_obj_set_style_text_color(readout, lv_color_hex(0x00FF00), LV_PART_MAIN);
+    readout_set_align(readout, LV_TEXT_ALIGN_CENTER);
+    lv_obj_align(readout, LV_ALIGN_CENTER, 0, 0);
+    return readout;
+}
+
+static void clock_label(lv_obj_t *obj, int step)
+{
+    char text[16];
+    clock_text(step, text, sizeof(text));
+    lv_label_set_text(obj, text);
+}
+
+static void clock_readout(lv_obj_t *obj, int step)
+{
+    char text[16];
+    clock_text(step, text, sizeof(text));
+    readout_set_text(obj, text);
+}
+
+static void counter_label(lv_obj_t *obj, int step)
+{
+    char text[16];
+    counter_text(step, text, sizeof(text));
+    lv_label_set_text(obj, text);
+}
+
+static void counter_readout(lv_obj_t *obj, int step)
+{
+    char text[16];
+    counter_text(step, text, sizeof(text));
+    readout_set_text(obj, text);
+}
+
+/* Full-screen numeric dashboard: a grid of Montserrat 48 values that
+ * all change every update, drawn straight from the font or through a
+ * glyph atlas (glyph_atlas.h) */
+#define GRID_COLUMNS    6
+#define GRID_ROWS       13
+
+static const lv_font_t *atlas_48;
+
+static lv_obj_t *create_grid(lv_obj_t *screen, const lv_font_t *font)
+{
+    lv_obj_t *grid = lv_obj_create(screen);
+    lv_obj_remove_style_all(grid);
+    lv_obj_set_size(grid, SCREEN_W, SCREEN_H);
+    lv_obj_set_style_text_font(grid, font, LV_PART_MAIN);
+    lv_obj_set_style_text_color(grid, lv_color_white(), LV_PART_MAIN);
+
+    for (int i = 0; i < GRID_COLUMNS * GRID_ROWS; i++) {
+        lv_obj_t *label = lv_label_create(grid);
+        lv_obj_set_pos(label, i % GRID_COLUMNS * (SCREEN_W / GRID_COLUMNS),
+                       i / GRID_COLUMNS * (SCREEN_H / GRID_ROWS) - 6);
+    }
+    return grid;
+}
+
+static lv_obj_t *create_grid_font(lv_obj_t *screen)
+{
+    return create_grid(screen, &lv_font_montserrat_48);
+}
+
+static lv_obj_t *create_grid_atlas(lv_obj_t *screen)
+{
+    return create_grid(screen, atlas_48);
+}
+
+static void update_grid(lv_obj_t *grid, int step)
+{
+    uint32_t n = lv_obj_get_child_count(grid);
+    for (uint32_t i = 0; i < n; i++) {
+        int v = (int)((step * 7919u + i * 104729u) % 200000) - 100000;
+        lv_label_set_text_fmt(lv_obj_get_child(grid, i), "%d.%02d", v / 100, abs(v % 100));
+    }
+}
+
+/* Live traces: three series, 1200 x 300, one column per update */
+#define CHART_W         1200
+#define CHART_H         300
+#define CHART_SERIES    3
+#define ENVELOPE_SAMPLES 8
+
+static const uint32_t chart_colors[CHART_SERIES] = { 0x00FF00, 0xFFCC00, 0x33CCFF };
+
+/* Sample `k` of series `i`: a triangle wave each, different periods */
+static int32_t trace_value(int i, int step, int k)
+{
+    int period = 150 + 70 * i;
+    int phase = (step * ENVELOPE_SAMPLES + k) % (period * ENVELOPE_SAMPLES);
+    int half = period * ENVELOPE_SAMPLES / 2;
+    int tri = phase < half ? phase : 2 * half - phase;
+    return 100 + i * 200 + tri * 600 / half;
+}
+
+static lv_obj_t *create_lv_chart(lv_obj_t *screen)
+{
+    lv_obj_t *chart = lv_chart_create(screen);
+    lv_obj_set_size(chart, CHART_W, CHART_H);
+    lv_obj_center(chart);
+    lv_chart_set_type(chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_SHIFT);
+    lv_chart_set_point_count(chart, CHART_W);
+    lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, 1100);
+    lv_chart_set_div_line_count(chart, 5, 12);
+    lv_obj_set_style_size(chart, 0, 0, LV_PART_INDICATOR);
+    for (int i = 0; i < CHART_SERIES; i++) {
+        lv_chart_add_series(chart, lv_color_hex(chart_colors[i]), LV_CHART_AXIS_PRIMARY_Y);
+    }
+    return chart;
+}
+
+static void update_lv_chart(lv_obj_t *chart, int step)
+{
+    lv_chart_series_t *ser = lv_chart_get_series_next(chart, NULL);
+    for (int i = 0; ser != NULL; i++, ser = lv_chart_get_series_next(chart, ser)) {
+        lv_chart_set_next_value(chart, ser, trace_value(i, step, 0));
+    }
+}
+
+static lv_obj_t *create_strip(lv_obj_t *screen)
+{
+    lv_obj_t *chart = stripchart_create(screen, CHART_W, CHART_H);
+    lv_obj_center(chart);
+    stripchart_set_colors(chart, lv_color_hex(0x001A33), lv_color_hex(0x335577));
+    stripchart_set_range(chart, 0, 1100);
+    stripchart_set_grid(chart, 4, CHART_W / 12);
+    for (int i = 0; i < CHART_SERIES; i++) {
+        stripchart_add_series(chart, lv_color_hex(chart_colors[i]));
+    }
+    return chart;
+}
+
+static void update_strip(lv_obj_t *chart, int step)
+{
+    for (int i = 0; i < CHART_SERIES; i++) {
+        stripchart_push(chart, i, trace_value(i, step, 0));
+    }
+    stripchart_advance(chart, 1);
+}
+
+/* A late refresh: four columns due at once, so the sweep wraps */
+#define CATCHUP_COLUMNS 4
+
+static void update_catchup(lv_obj_t *chart, int step)
+{
+    for (int i = 0; i < CHART_SERIES; i++) {
+        stripchart_push(chart, i, trace_value(i, step, 0));
+    }
+    stripchart_advance(chart, CATCHUP_COLUMNS);
+}
+
+static void update_envelope(lv_obj_t *chart, int step)
+{
+    for (int i = 0; i < CHART_SERIES; i++) {
+        for (int k = 0; k < ENVELOPE_SAMPLES; k++) {
+            /* +-30 of deterministic noise */
+            int32_t noise = (int32_t)((step * 31u + k * 17u + i * 7u) * 2654435761u >> 26) - 32;
+            stripchart_push(chart, i, trace_value(i, step, k) + noise);
+        }
+    }
+    stripchart_advance(chart, 1);
+}
+
+/* History view: three 10 000-point series in a 1200 x 300 lv_chart,
+ * eight points per pixel column, one new point per series per update.
+ * The points live here - they would not fit in LVGL's heap. */
+#define HISTORY_POINTS  10000
+
+static int32_t history_points[CHART_SERIES][HISTORY_POINTS];
+
+static int32_t history_value(int i, int n)
+{
+    int32_t noise = (int32_t)((n * 2654435761u + i * 40503u) >> 26) - 32;
+    return 250 + i * 300 + (int32_t)(200 * sin(n * 0.0025 + i)) + noise;
+}
+
+static lv_obj_t *create_history(lv_obj_t *screen)
+{
+    lv_obj_t *chart = create_lv_chart(screen);
+    lv_chart_series_t *ser = lv_chart_get_series_next(chart, NULL);
+    for (int i = 0; ser != NULL; i++, ser = lv_chart_get_series_next(chart, ser)) {
+        for (int n = 0; n < HISTORY_POINTS; n++) {
+            history_points[i][n] = history_value(i, n);
+        }
+        lv_chart_set_ext_y_array(chart, ser, history_points[i]);
+    }
+    lv_chart_set_point_count(chart, HISTORY_POINTS);
+    return chart;
+}
+
+static void update_history(lv_obj_t *chart, int step)
+{
+    lv_chart_series_t *ser = lv_chart_get_series_next(chart, NULL);
+    for (int i = 0; ser != NULL; i++, ser = lv_chart_get_series_next(chart, ser)) {
+        lv_chart_set_next_value(chart, ser, history_value(i, HISTORY_POINTS + step));
+    }
+}
+
+static const scenario_t scenarios[] = {
+    { "clock/label",     create_label,      clock_label,     0 },
+    { "clock/readout",   create_readout,    clock_readout,   0 },
+    { "counter/label",   create_label,      counter_label,   0 },
+    { "counter/readout", create_readout,    counter_readout, 0 },
+    { "grid/font",       create_grid_font,  update_grid,     0 },
+    { "grid/atlas",      create_grid_atlas, update_grid,     0 },
+    { "chart/lv_chart",  create_lv_chart,   update_lv_chart, 1 },
+    { "chart/strip",     create_strip,      update_strip,    1 },
+    { "chart/envelope",  create_strip,      update_envelope, 1 },
+    { "chart/catchup",   create_strip,      update_catchup,  CATCHUP_COLUMNS },
+    { "history/lvgl",    create_history,    update_history,  0 },
+};
+
+#define SCENARIO_COUNT  (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/* ============================================================
+ * BENCHMARK
+ * ============================================================ */
+static bool run(const scenario_t *sc)
+{
+    int64_t best = INT64_MAX;
+    uint64_t px = 0;
+    uint32_t areas = 0;
+
+    for (int r = 0; r < opt.repeats; r++) {
+        lv_obj_t *screen = lv_screen_active();
+        lv_obj_clean(screen);
+        lv_obj_t *obj = sc->create(screen);
+        sc->update(obj, 0);
+        lv_refr_now(NULL);
+
+        flushed_px = 0;
+        flushes = 0;
+        int64_t t = 0;
+        for (int step = 1; step <= opt.updates; step++) {
+            int64_t t0 = now_ns();
+            sc->update(obj, step);
+            lv_refr_now(NULL);
+            t += now_ns() - t0;
+        }
+        best = t < best ? t : best;
+        px = flushed_px;
+        areas = flushes;
+    }
+
+    /* Incremental result vs a full redraw */
+    memcpy(incremental, frame, sizeof(frame));
+    lv_obj_invalidate(lv_screen_active());
+    lv_refr_now(NULL);
+    bool same = memcmp(incremental, frame, sizeof(frame)) == 0;
+
+    printf("%-16s %8.0f px/update  %5.2f areas/update  %7.1f us/update  %s",
+           sc->name, (double)px / opt.updates, (double)areas / opt.updates,
+           (double)best / opt.updates / 1000, same ? "ok" : "MISMATCH");
+    if (sc->columns > 0) {
+        printf("  %6.0f px/column", (double)px / opt.updates / sc->columns);
+    }
+    printf("\n");
+    return same;
+}
+
+static bool selected(const char *name, int argc, char **argv)
+{
+    bool wanted = optind >= argc;
+    for (int a = optind; a < argc; a++) {
+        wanted |= strstr(name, argv[a]) != NULL;
+    }
+    return wanted;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-n updates] [-r repeats] [scenario ...]\nscenarios:", argv0);
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        fprintf(stderr, " %s", scenarios[i].name);
+    }
+    fprintf(stderr, "\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:r:h")) != -1) {
+        switch (c) {
+            case 'n': opt.updates = atoi(optarg); break;
+            case 'r': opt.repeats = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (opt.updates < 1 || opt.repeats < 1) {
+        usage(argv[0]);
+    }
+
+    lv_init();
+    lv_tick_set_cb(tick_cb);
+    lv_display_t *disp = lv_display_create(SCREEN_W, SCREEN_H);
+    lv_display_set_buffers(disp, draw_buf, NULL, sizeof(draw_buf), LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(disp, flush_cb);
+
+    /* Same background as the UI, so a redraw costs what it would there */
+    lv_obj_set_style_bg_color(lv_screen_active(), lv_color_hex(0x003366), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(lv_screen_active(), LV_OPA_COVER, LV_PART_MAIN);
+
+    atlas_48 = glyph_atlas_create(&lv_font_montserrat_48, GLYPH_ATLAS_NUMERIC);
+    glyph_atlas_stats_t atlas;
+    glyph_atlas_get_stats(&atlas);
+    printf("atlas: %u glyphs, %u bytes of bitmaps + %u of tables\n", atlas.glyphs,
+           (unsigned)atlas.bitmap_bytes, (unsigned)atlas.table_bytes);
+
+    printf("%d updates, best of %d, %dx%d screen\n", opt.updates, opt.repeats, SCREEN_W, SCREEN_H);
+    bool ok = true;
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        if (selected(scenarios[i].name, argc, argv)) {
+            ok &= run(&scenarios[i]);
+        }
+    }
+    return ok ? 0 : 1;
+}